@@ -0,0 +1,175 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+""" ArduPilot gyro filter sweep
+
+Extracts gyro samples from a log and evaluates a grid of candidate filter
+parameters with the FilterChainEval example, which runs the same notch,
+low-pass and FFT code as the vehicle. Candidates are evaluated in parallel
+and ranked by the noise attenuation achieved on roll and pitch, subject to
+an optional limit on the phase lag at a control frequency.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <http://www.gnu.org/licenses/>.
+"""
+
+import argparse
+import concurrent.futures
+import itertools
+import os
+import subprocess
+import sys
+import tempfile
+
+from pymavlink import mavutil
+
+# batch sampler sensor type for gyros
+ISBH_TYPE_GYRO = 1
+
+
+def extract_batch_samples(logfile, instance):
+    '''extract batch sampler gyro data, each batch becomes its own segment'''
+    mlog = mavutil.mavlink_connection(logfile)
+    samples = []
+    rates = []
+    header = None
+    while True:
+        m = mlog.recv_match(type=['ISBH', 'ISBD'])
+        if m is None:
+            break
+        if m.get_type() == 'ISBH':
+            if m.type == ISBH_TYPE_GYRO and m.instance == instance:
+                header = m
+                rates.append(m.smp_rate)
+            else:
+                header = None
+            continue
+        if header is None or m.N != header.N:
+            continue
+        mul = float(header.mul)
+        for x, y, z in zip(m.x, m.y, m.z):
+            samples.append((header.N, x / mul, y / mul, z / mul))
+    if not rates:
+        return samples, 0
+    return samples, sorted(rates)[len(rates) // 2]
+
+
+def extract_raw_samples(logfile, instance):
+    '''extract raw gyro data, gaps in the data start a new segment'''
+    mlog = mavutil.mavlink_connection(logfile)
+    times = []
+    values = []
+    while True:
+        m = mlog.recv_match(type='GYR')
+        if m is None:
+            break
+        if m.I != instance:
+            continue
+        times.append(m.SampleUS)
+        values.append((m.GyrX, m.GyrY, m.GyrZ))
+    if len(times) < 2:
+        return [], 0
+    deltas = sorted(t1 - t0 for t0, t1 in zip(times, times[1:]) if t1 > t0)
+    dt_us = deltas[len(deltas) // 2]
+    samples = []
+    segment = 0
+    for i, (x, y, z) in enumerate(values):
+        if i > 0 and times[i] - times[i-1] > 5 * dt_us:
+            segment += 1
+        samples.append((segment, x, y, z))
+    return samples, 1.0e6 / dt_us
+
+
+def parse_range(spec):
+    '''parse NAME=v1,v2,... or NAME=start:stop:step into a list of (NAME, value)'''
+    name, _, values = spec.partition('=')
+    if not values:
+        raise argparse.ArgumentTypeError("expected NAME=VALUES: %s" % spec)
+    if ':' in values:
+        start, stop, step = [float(v) for v in values.split(':')]
+        result = []
+        v = start
+        while v <= stop + step * 1.0e-6:
+            result.append(v)
+            v += step
+    else:
+        result = [float(v) for v in values.split(',')]
+    return [(name, v) for v in result]
+
+
+def run_candidate(binary, csvfile, sample_rate, candidate):
+    '''evaluate one set of parameters, returning a dictionary of results'''
+    cmd = [binary, csvfile, "%f" % sample_rate] + ["%s=%g" % p for p in candidate]
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    header = None
+    for line in out.stdout.splitlines():
+        if line.startswith("HEADER,"):
+            header = line.split(',')[1:]
+        elif line.startswith("RESULT,") and header is not None:
+            return dict(zip(header, [float(v) for v in line.split(',')[1:]]))
+    raise RuntimeError("%s failed: %s" % (' '.join(cmd), out.stdout.strip()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Sweep gyro filter parameters against a log')
+    parser.add_argument('logfile', help='log containing batch sampler (ISBD) or raw (GYR) gyro data')
+    parser.add_argument('--binary', default='build/sitl/examples/FilterChainEval', help='path to the FilterChainEval example')
+    parser.add_argument('--instance', type=int, default=0, help='gyro instance')
+    parser.add_argument('--source', choices=['batch', 'raw'], default='batch', help='use batch sampler or raw IMU data')
+    parser.add_argument('--set', action='append', default=[], type=parse_range, help='fixed parameter, NAME=VALUE')
+    parser.add_argument('--sweep', action='append', default=[], type=parse_range,
+                        help='parameter to sweep, NAME=v1,v2,... or NAME=start:stop:step')
+    parser.add_argument('--max-lag', type=float, default=None, help='reject candidates with more phase lag than this in degrees')
+    parser.add_argument('--lag-freq', type=int, default=20, help='control frequency at which to check phase lag')
+    parser.add_argument('--top', type=int, default=10, help='number of candidates to show')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count(), help='number of parallel evaluations')
+    args = parser.parse_args()
+
+    if args.source == 'batch':
+        samples, sample_rate = extract_batch_samples(args.logfile, args.instance)
+    else:
+        samples, sample_rate = extract_raw_samples(args.logfile, args.instance)
+    if not samples:
+        print("No %s gyro samples found for instance %u" % (args.source, args.instance))
+        sys.exit(1)
+    print("Loaded %u samples at %.1fHz" % (len(samples), sample_rate))
+
+    fixed = [p for s in args.set for p in s]
+    candidates = [fixed + list(c) for c in itertools.product(*args.sweep)]
+
+    with tempfile.NamedTemporaryFile(mode='w', suffix='.csv', delete=False) as f:
+        f.write("seg,x,y,z\n")
+        for s in samples:
+            f.write("%u,%f,%f,%f\n" % s)
+        csvfile = f.name
+
+    lag_key = "Lag%u" % args.lag_freq
+    results = []
+    try:
+        with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as executor:
+            futures = {executor.submit(run_candidate, args.binary, csvfile, sample_rate, c): c for c in candidates}
+            for future in concurrent.futures.as_completed(futures):
+                r = future.result()
+                if args.max_lag is not None and r.get(lag_key, 0) > args.max_lag:
+                    continue
+                results.append((0.5 * (r["AttX"] + r["AttY"]), futures[future], r))
+    finally:
+        os.unlink(csvfile)
+
+    results.sort(key=lambda r: r[0], reverse=True)
+    print("Evaluated %u candidates, %u within limits" % (len(candidates), len(results)))
+    for score, candidate, r in results[:args.top]:
+        params = ' '.join("%s=%g" % p for p in candidate)
+        print("%6.2fdB roll/pitch %6.2fdB yaw %5.1fdeg lag@%uHz notch %.1fHz: %s" %
+              (score, r["AttZ"], r.get(lag_key, 0), args.lag_freq, r["NotchHz"], params))
+
+
+if __name__ == '__main__':
+    main()
@@ -11,6 +11,7 @@ import copy
 import math
 import operator
 import os
+import re
 import sys
 import time
 
@@ -5294,6 +5295,8 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
                 "math.lua",
                 "strings.lua",
                 "mavlink_test.lua",
+                "alloc_bench.lua",
+                "binding_bench.lua",
         ]:
             self.install_test_script_context(script)
 
@@ -5306,7 +5309,9 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
                 "Internal tests passed",
                 "Math tests passed",
                 "String tests passed",
-                "Received heartbeat from"
+                "Received heartbeat from",
+                "Alloc bench done",
+                "Binding bench done",
         ]:
             self.wait_statustext(success_text, check_context=True)
 
@@ -5320,6 +5325,45 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
         self.context_pop()
         self.reboot_sitl()
 
+    def run_scripting_alloc_bench(self, pool_pct):
+        '''run alloc_bench.lua with SCR_POOL_PCT set to pool_pct, returning
+        the mean time of a run in microseconds'''
+        self.context_push()
+
+        self.set_parameters({
+            "SCR_ENABLE": 1,
+            "SCR_HEAP_SIZE": 1024000,
+            "SCR_VM_I_COUNT": 1000000,
+            "SCR_POOL_PCT": pool_pct,
+            "SCR_DEBUG_OPTS": 2,  # runtime messages, to see the pool usage
+        })
+        self.install_test_script_context("alloc_bench.lua")
+
+        self.context_collect('STATUSTEXT')
+
+        self.reboot_sitl()
+
+        m = self.wait_statustext(r"Alloc bench: .* mean (\d+)us", regex=True, check_context=True, timeout=60)
+        mean_us = int(re.search(r"mean (\d+)us", m.text).group(1))
+        self.wait_statustext("Alloc bench done", check_context=True)
+
+        # the runtime messages report the pool as used/size
+        m = self.wait_statustext(r"Lua: Time: .* Pool: \d+/\d+", regex=True, check_context=True)
+        pool_size = int(re.search(r"Pool: \d+/(\d+)", m.text).group(1))
+        if (pool_size != 0) != (pool_pct != 0):
+            raise NotAchievedException("SCR_POOL_PCT=%u but pool size is %u" % (pool_pct, pool_size))
+
+        self.context_pop()
+        self.reboot_sitl()
+        return mean_us
+
+    def test_scripting_alloc_pool(self):
+        self.start_subtest("Scripting allocation pool")
+
+        heap_mean_us = self.run_scripting_alloc_bench(0)
+        pool_mean_us = self.run_scripting_alloc_bench(25)
+        self.progress("Alloc bench mean: heap %uus pool %uus" % (heap_mean_us, pool_mean_us))
+
     def test_scripting_hello_world(self):
         self.start_subtest("Scripting hello world")
 
@@ -5413,6 +5457,7 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
         self.test_scripting_hello_world()
         self.test_scripting_simple_loop()
         self.test_scripting_internal_test()
+        self.test_scripting_alloc_pool()
         self.test_scripting_auxfunc()
 
     def test_mission_frame(self, frame, target_system=1, target_component=1):
@@ -5469,6 +5514,30 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
                                     target_system=1,
                                     target_component=1)
 
+    def MissionUploadLarge(self):
+        '''Upload and download a large mission'''
+        # SITL is a HAL_MEM_CLASS_1000 board, so this goes through the
+        # staged upload which replaces the stored mission in one write
+        count = 1000
+        items = []
+        for i in range(count):
+            items.append((mavutil.mavlink.MAV_CMD_NAV_WAYPOINT, 10 * (i // 50), 10 * (i % 50), 20 + i % 10))
+        mission = self.create_simple_relhome_mission(items)
+
+        tstart_wall = time.time()
+        tstart_sim = self.get_sim_time()
+        self.upload_using_mission_protocol(mavutil.mavlink.MAV_MISSION_TYPE_MISSION, mission)
+        self.progress("Uploaded %u items in %.2fs (%.2fs sim time)" %
+                      (len(mission), time.time() - tstart_wall, self.get_sim_time() - tstart_sim))
+
+        downloaded_items = self.download_using_mission_protocol(mavutil.mavlink.MAV_MISSION_TYPE_MISSION)
+        self.check_mission_waypoint_items_same(mission, downloaded_items)
+
+        # the mission must have been written to storage, not just staged
+        self.reboot_sitl()
+        downloaded_items = self.download_using_mission_protocol(mavutil.mavlink.MAV_MISSION_TYPE_MISSION)
+        self.check_mission_waypoint_items_same(mission, downloaded_items)
+
     def mavlink_time_boot_ms(self):
         '''returns a time suitable for putting into the time_boot_ms entry in mavlink packets'''
         return int(time.time() * 1000000)
@@ -6787,6 +6856,7 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
             self.Scripting,
             self.ScriptingSteeringAndThrottle,
             self.MissionFrames,
+            self.MissionUploadLarge,
             self.SetpointGlobalPos,
             self.SetpointGlobalVel,
             self.AccelCal,
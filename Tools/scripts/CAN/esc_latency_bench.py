@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+'''
+benchmark of ESC command delivery on SITL CAN
+
+Listens to the SITL multicast CAN bus and times the ESC RawCommand
+transfers sent by the vehicle. For each transfer the time from its
+first frame to its last frame is the latency added by queueing the
+frames onto the bus, the period between transfers shows the jitter of
+the ESC output loop.
+
+Start SITL with DroneCAN ESCs on the multicast CAN transport, for example
+  ./build/sitl/bin/arducopter --model quad -A --defaults esc.parm
+with esc.parm holding
+  CAN_P1_DRIVER 1
+  CAN_D1_PROTOCOL 1
+  CAN_D1_UC_ESC_BM 15
+  SIM_CAN_TYPE1 1
+then arm the vehicle, or run a motor test, and run
+  ./Tools/scripts/CAN/esc_latency_bench.py --duration 30
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import socket
+import struct
+import time
+
+MCAST_ADDRESS_BASE = "239.65.82."
+MCAST_PORT = 57732
+MCAST_MAGIC = 0x2934
+
+ESC_RAWCOMMAND_ID = 1030
+HOBBYWING_RAWCOMMAND_ID = 20013
+
+TAIL_START = 0x80
+TAIL_END = 0x40
+
+
+def percentile(values, pct):
+    if len(values) == 0:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * pct / 100.0))]
+
+
+def report(name, values):
+    '''print statistics of a list of times in seconds in microseconds'''
+    if len(values) == 0:
+        print("%s: no samples" % name)
+        return
+    us = [v * 1.0e6 for v in values]
+    print("%s: n=%u mean=%.1fus p50=%.1fus p99=%.1fus max=%.1fus" % (
+        name, len(us), sum(us) / len(us), percentile(us, 50), percentile(us, 99), max(us)))
+
+
+class ESCLatencyBench(object):
+    def __init__(self, opts):
+        self.opts = opts
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind(('', MCAST_PORT))
+        group = MCAST_ADDRESS_BASE + str(opts.bus)
+        mreq = struct.pack("4sl", socket.inet_aton(group), socket.INADDR_ANY)
+        self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+        self.sock.settimeout(0.1)
+
+        self.msg_ids = [ESC_RAWCOMMAND_ID, HOBBYWING_RAWCOMMAND_ID]
+        # start time of the transfer in progress from each source
+        self.transfer_start = {}
+        # time of the last completed transfer from each source
+        self.last_transfer = {}
+        self.spread = []
+        self.period = []
+        self.frames = 0
+
+    def handle(self, pkt, tnow):
+        if len(pkt) < 11:
+            return
+        (magic, crc, flags, can_id) = struct.unpack("<HHHI", pkt[:10])
+        if magic != MCAST_MAGIC:
+            return
+        can_id &= 0x1FFFFFFF
+        if can_id & 0x80:
+            # service transfer
+            return
+        msg_id = (can_id >> 8) & 0xFFFF
+        if msg_id not in self.msg_ids:
+            return
+        self.frames += 1
+        key = (can_id & 0x7F, msg_id)
+        tail = pkt[-1]
+        if tail & TAIL_START:
+            self.transfer_start[key] = tnow
+        if tail & TAIL_END and key in self.transfer_start:
+            self.spread.append(tnow - self.transfer_start.pop(key))
+            if key in self.last_transfer:
+                self.period.append(tnow - self.last_transfer[key])
+            self.last_transfer[key] = tnow
+
+    def run(self):
+        print("Listening on CAN bus %u for %.0fs" % (self.opts.bus, self.opts.duration))
+        end = time.monotonic() + self.opts.duration
+        while time.monotonic() < end:
+            try:
+                pkt = self.sock.recv(128)
+            except socket.timeout:
+                continue
+            self.handle(pkt, time.monotonic())
+
+        print("%u ESC frames" % self.frames)
+        report("transfer first to last frame", self.spread)
+        report("transfer period", self.period)
+        if len(self.period) > 1:
+            mean = sum(self.period) / len(self.period)
+            jitter = [abs(p - mean) for p in self.period]
+            report("period jitter", jitter)
+        return len(self.spread) > 0
+
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument("--bus", type=int, default=0, help="SITL CAN bus number")
+parser.add_argument("--duration", type=float, default=10.0, help="seconds to listen for")
+args = parser.parse_args()
+
+if not ESCLatencyBench(args).run():
+    raise SystemExit(1)
@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+'''
+benchmark of MAVLink FTP downloads
+
+Downloads a file over one or more concurrent FTP sessions with burst
+reads, re-requesting any lost packets, and reports the throughput. Each
+download is checked against the CRC32 calculated by the vehicle.
+
+For a local UDP link start SITL with something like
+  ./build/sitl/bin/arducopter --model quad -A --serial1=udpclient:127.0.0.1:14551
+then run
+  ./Tools/scripts/mavftp_bench.py --master udpin:127.0.0.1:14551 logs/00000001.BIN --sessions 2
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import struct
+import time
+import zlib
+
+from pymavlink import mavutil
+
+OP_TERMINATE_SESSION = 1
+OP_OPEN_FILE_RO = 4
+OP_CALC_FILE_CRC32 = 14
+OP_BURST_READ_FILE = 15
+OP_ACK = 128
+OP_NACK = 129
+
+ERR_EOF = 6
+
+DATA_SIZE = 239
+BURST_TIMEOUT = 0.5
+
+
+class Session(object):
+    def __init__(self, session_id):
+        self.id = session_id
+        self.seq = 0
+        self.size = None
+        self.data = None
+        self.have = None
+        self.burst_active = False
+        self.last_rx = 0
+        self.start = None
+        self.done_time = None
+        self.crc = None
+        self.resends = 0
+
+    def first_missing(self):
+        for i, have in enumerate(self.have):
+            if not have:
+                return i
+        return None
+
+    def truncate(self, size):
+        '''the file ended before the size given when it was opened'''
+        if size < self.size:
+            self.size = size
+            self.data = self.data[:size]
+            self.have = self.have[:(size + DATA_SIZE - 1) // DATA_SIZE]
+
+
+class FTPBench(object):
+    def __init__(self, opts):
+        self.opts = opts
+        self.master = mavutil.mavlink_connection(opts.master, source_system=opts.source_system)
+        print("Waiting for heartbeat")
+        self.master.wait_heartbeat()
+        self.sessions = [Session(i + 1) for i in range(opts.sessions)]
+
+    def send(self, session, opcode, offset=0, data=b'', size=None):
+        if size is None:
+            size = len(data)
+        payload = struct.pack("<HBBBBBBI", session.seq, session.id, opcode, size, 0, 0, 0, offset)
+        payload += data + bytes(DATA_SIZE - len(data))
+        session.seq = (session.seq + 1) % 65536
+        self.master.mav.file_transfer_protocol_send(0,
+                                                    self.master.target_system,
+                                                    self.master.target_component,
+                                                    list(payload))
+
+    def recv(self, timeout):
+        m = self.master.recv_match(type='FILE_TRANSFER_PROTOCOL', blocking=True, timeout=timeout)
+        if m is None:
+            return None
+        payload = bytes(m.payload)
+        (seq, session_id, opcode, size, req_opcode, burst_complete, _, offset) = struct.unpack("<HBBBBBBI", payload[:12])
+        for session in self.sessions:
+            if session.id == session_id:
+                return (session, opcode, size, req_opcode, burst_complete, offset, payload[12:12+size])
+        return None
+
+    def request(self, session, opcode, data, timeout=2.0):
+        '''send a request and wait for the reply to it'''
+        for _ in range(5):
+            self.send(session, opcode, data=data)
+            end = time.time() + timeout
+            while time.time() < end:
+                r = self.recv(end - time.time())
+                if r is not None and r[0] is session and r[3] == opcode:
+                    return r
+        raise RuntimeError("no reply to opcode %u on session %u" % (opcode, session.id))
+
+    def open(self, session):
+        self.send(session, OP_TERMINATE_SESSION)
+        r = self.request(session, OP_OPEN_FILE_RO, self.opts.path.encode())
+        if r[1] != OP_ACK:
+            raise RuntimeError("open of %s failed: %s" % (self.opts.path, list(r[6])))
+        session.size = struct.unpack("<I", r[6][:4])[0]
+        session.data = bytearray(session.size)
+        session.have = [False] * ((session.size + DATA_SIZE - 1) // DATA_SIZE)
+        session.start = time.time()
+
+    def burst(self, session):
+        block = session.first_missing()
+        if block is None:
+            return
+        if session.burst_active:
+            session.resends += 1
+        self.send(session, OP_BURST_READ_FILE, offset=block*DATA_SIZE, size=DATA_SIZE)
+        session.burst_active = True
+        session.last_rx = time.time()
+
+    def handle(self, r):
+        (session, opcode, size, req_opcode, burst_complete, offset, data) = r
+        if req_opcode != OP_BURST_READ_FILE or session.done_time is not None:
+            return
+        session.last_rx = time.time()
+        if opcode == OP_ACK:
+            if size < DATA_SIZE:
+                # virtual files such as @PARAM/param.pck may be
+                # shorter than the size given on open
+                session.truncate(offset + size)
+            session.data[offset:offset+size] = data
+            if offset % DATA_SIZE == 0 and (size == DATA_SIZE or offset + size == session.size):
+                session.have[offset // DATA_SIZE] = True
+            if burst_complete:
+                session.burst_active = False
+        elif opcode == OP_NACK:
+            if len(data) == 0 or data[0] != ERR_EOF:
+                print("session %u: burst error %s" % (session.id, list(data)))
+            else:
+                session.truncate(offset)
+            session.burst_active = False
+        if session.first_missing() is None:
+            session.done_time = time.time()
+
+    def download(self):
+        '''download opts.path over every session'''
+        for session in self.sessions:
+            self.open(session)
+            print("session %u: %s is %u bytes" % (session.id, self.opts.path, session.size))
+
+        start = time.time()
+        while any(s.done_time is None for s in self.sessions):
+            if time.time() - start > self.opts.timeout:
+                raise RuntimeError("download timed out")
+            now = time.time()
+            for session in self.sessions:
+                if session.done_time is not None:
+                    continue
+                if not session.burst_active or now - session.last_rx > BURST_TIMEOUT:
+                    # start a burst at the first lost packet
+                    self.burst(session)
+            r = self.recv(0.1)
+            if r is not None:
+                self.handle(r)
+        for session in self.sessions:
+            self.send(session, OP_TERMINATE_SESSION)
+
+    def run(self):
+        self.download()
+
+        total_bytes = 0
+        ok = True
+        for session in self.sessions:
+            r = self.request(session, OP_CALC_FILE_CRC32, self.opts.path.encode(), timeout=10.0)
+            # the vehicle's crc32 starts from zero with no final inversion
+            crc = zlib.crc32(session.data, 0xFFFFFFFF) ^ 0xFFFFFFFF
+            remote_crc = struct.unpack("<I", r[6][:4])[0] if r[1] == OP_ACK else None
+            elapsed = session.done_time - session.start
+            print("session %u: %u bytes in %.2fs, %.1f KB/s, %u resends, crc %s" % (
+                session.id, session.size, elapsed, session.size / (1024.0 * max(elapsed, 0.001)),
+                session.resends, "OK" if crc == remote_crc else "MISMATCH"))
+            ok = ok and crc == remote_crc
+            total_bytes += session.size
+        elapsed = max(s.done_time for s in self.sessions) - min(s.start for s in self.sessions)
+        print("total %.1f KB/s over %u sessions" % (total_bytes / (1024.0 * max(elapsed, 0.001)), len(self.sessions)))
+        return ok
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("path", help="path of the file on the vehicle")
+    parser.add_argument("--master", default="udpin:127.0.0.1:14551", help="MAVLink connection")
+    parser.add_argument("--sessions", type=int, default=1, help="number of concurrent downloads")
+    parser.add_argument("--source-system", type=int, default=250, help="our MAVLink system ID")
+    parser.add_argument("--timeout", type=float, default=300.0, help="give up after this many seconds")
+    args = parser.parse_args()
+
+    if not FTPBench(args).run():
+        raise SystemExit(1)
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+'''
+benchmark of mission uploads
+
+Uploads a mission of waypoints with the MAVLink mission protocol and
+reports the time from MISSION_COUNT to the final MISSION_ACK. The
+mission is then downloaded and checked against what was sent.
+
+Start SITL with something like
+  ./build/sitl/bin/arducopter --model quad -A --serial1=udpclient:127.0.0.1:14551
+then run
+  ./Tools/scripts/mission_upload_bench.py --master udpin:127.0.0.1:14551 --count 1000 --runs 5
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import time
+
+from pymavlink import mavutil
+
+MISSION_TYPE = mavutil.mavlink.MAV_MISSION_TYPE_MISSION
+
+
+class MissionBench(object):
+    def __init__(self, opts):
+        self.opts = opts
+        self.master = mavutil.mavlink_connection(opts.master, source_system=opts.source_system)
+        print("Waiting for heartbeat")
+        self.master.wait_heartbeat()
+
+    def make_items(self):
+        '''a grid of waypoints, item 0 being the home position'''
+        items = []
+        for seq in range(self.opts.count):
+            lat = int((self.opts.lat + 0.0001 * (seq // 100)) * 1.0e7)
+            lng = int((self.opts.lng + 0.0001 * (seq % 100)) * 1.0e7)
+            items.append((seq, lat, lng, 20.0 + seq % 10))
+        return items
+
+    def send_item(self, item):
+        (seq, lat, lng, alt) = item
+        self.master.mav.mission_item_int_send(self.master.target_system,
+                                              self.master.target_component,
+                                              seq,
+                                              mavutil.mavlink.MAV_FRAME_GLOBAL_RELATIVE_ALT_INT,
+                                              mavutil.mavlink.MAV_CMD_NAV_WAYPOINT,
+                                              0, 1,
+                                              0, 0, 0, 0,
+                                              lat, lng, alt,
+                                              MISSION_TYPE)
+
+    def upload(self, items):
+        '''upload items, returning the time taken'''
+        start = time.time()
+        self.master.mav.mission_count_send(self.master.target_system,
+                                           self.master.target_component,
+                                           len(items),
+                                           MISSION_TYPE)
+        while True:
+            if time.time() - start > self.opts.timeout:
+                raise RuntimeError("upload timed out")
+            m = self.master.recv_match(type=['MISSION_REQUEST', 'MISSION_REQUEST_INT', 'MISSION_ACK'],
+                                       blocking=True, timeout=1)
+            if m is None:
+                continue
+            if m.get_type() == 'MISSION_ACK':
+                if m.type != mavutil.mavlink.MAV_MISSION_ACCEPTED:
+                    raise RuntimeError("upload failed with result %u" % m.type)
+                return time.time() - start
+            if m.seq < len(items):
+                self.send_item(items[m.seq])
+
+    def download(self):
+        '''download the mission, returning a list of items'''
+        self.master.mav.mission_request_list_send(self.master.target_system,
+                                                  self.master.target_component,
+                                                  MISSION_TYPE)
+        m = self.master.recv_match(type='MISSION_COUNT', blocking=True, timeout=5)
+        if m is None:
+            raise RuntimeError("no MISSION_COUNT")
+        items = []
+        for seq in range(m.count):
+            for _ in range(5):
+                self.master.mav.mission_request_int_send(self.master.target_system,
+                                                         self.master.target_component,
+                                                         seq,
+                                                         MISSION_TYPE)
+                r = self.master.recv_match(type='MISSION_ITEM_INT', blocking=True, timeout=1)
+                if r is not None and r.seq == seq:
+                    items.append((r.seq, r.x, r.y, r.z))
+                    break
+            else:
+                raise RuntimeError("no reply for item %u" % seq)
+        self.master.mav.mission_ack_send(self.master.target_system,
+                                         self.master.target_component,
+                                         mavutil.mavlink.MAV_MISSION_ACCEPTED,
+                                         MISSION_TYPE)
+        return items
+
+    def run(self):
+        items = self.make_items()
+        times = []
+        for i in range(self.opts.runs):
+            t = self.upload(items)
+            times.append(t)
+            print("run %u: %u items in %.3fs, %.1f items/s" % (i + 1, len(items), t, len(items) / max(t, 0.001)))
+        print("upload of %u items: mean %.3fs min %.3fs max %.3fs" % (
+            len(items), sum(times) / len(times), min(times), max(times)))
+
+        got = self.download()
+        # item 0 is replaced by the home position
+        ok = len(got) == len(items)
+        for (sent, recv) in zip(items[1:], got[1:]):
+            if sent[:3] != recv[:3] or abs(sent[3] - recv[3]) > 0.01:
+                print("item %u mismatch: sent %s got %s" % (sent[0], sent, recv))
+                ok = False
+                break
+        print("download check %s" % ("OK" if ok else "FAILED"))
+        return ok
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--master", default="udpin:127.0.0.1:14551", help="MAVLink connection")
+    parser.add_argument("--count", type=int, default=1000, help="number of mission items, including home")
+    parser.add_argument("--runs", type=int, default=3, help="number of uploads to time")
+    parser.add_argument("--lat", type=float, default=-35.363261, help="latitude of the first waypoint")
+    parser.add_argument("--lng", type=float, default=149.165230, help="longitude of the first waypoint")
+    parser.add_argument("--source-system", type=int, default=250, help="our MAVLink system ID")
+    parser.add_argument("--timeout", type=float, default=120.0, help="give up on an upload after this many seconds")
+    args = parser.parse_args()
+
+    if not MissionBench(args).run():
+        raise SystemExit(1)
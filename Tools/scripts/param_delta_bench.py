@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+'''
+benchmark of parameter download at connect
+
+Times fetching the full parameter list with PARAM_REQUEST_LIST and with
+a MAVLink FTP download of @PARAM/param.pck, then the reconnect case of
+downloading only the parameters changed since the first download with
+@PARAM/param.pck?changed_since=HASH. The delta is merged into the
+first download and checked against a fresh full download.
+
+Start SITL as described in mavftp_bench.py then run
+  ./Tools/scripts/param_delta_bench.py --master udpin:127.0.0.1:14551 --set RTL_ALT=2000
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import struct
+import time
+
+from mavftp_bench import FTPBench, Session
+
+PMAGIC_HASH = 0x671d
+PMAGIC_HASH_WITH_DEFAULT = 0x671e
+
+# mapping of data type to type length and format
+DATA_TYPES = {
+    1: (1, 'b'),
+    2: (2, 'h'),
+    3: (4, 'i'),
+    4: (4, 'f'),
+}
+
+
+def unpack(data):
+    '''unpack a param.pck file with a hash header, returns (hash, base_hash, params)'''
+    magic, num_params, total_params, snap_hash, base_hash = struct.unpack("<HHHII", data[:14])
+    if magic not in [PMAGIC_HASH, PMAGIC_HASH_WITH_DEFAULT]:
+        raise RuntimeError("no snapshot hash, magic 0x%x" % magic)
+    data = data[14:]
+    params = {}
+    last_name = ""
+    while True:
+        # skip pad bytes
+        while len(data) > 0 and data[0] == 0:
+            data = data[1:]
+        if len(data) == 0:
+            break
+        ptype, plen = struct.unpack("<BB", data[:2])
+        flags = ptype >> 4
+        (type_len, type_format) = DATA_TYPES[ptype & 0x0F]
+        name_len = (plen >> 4) + 1
+        common_len = plen & 0x0F
+        name = last_name[:common_len] + data[2:2+name_len].decode('utf-8')
+        params[name], = struct.unpack("<" + type_format, data[2+name_len:2+name_len+type_len])
+        last_name = name
+        data = data[2+name_len+type_len*(2 if flags & 1 else 1):]
+    if len(params) != num_params:
+        raise RuntimeError("got %u params expected %u/%u" % (len(params), num_params, total_params))
+    return (snap_hash, base_hash, params)
+
+
+class ParamDeltaBench(object):
+    def __init__(self, opts):
+        self.opts = opts
+        opts.sessions = 1
+        opts.path = None
+        self.ftp = FTPBench(opts)
+        self.master = self.ftp.master
+
+    def param_request_list(self):
+        '''time a download of all parameters with PARAM_VALUE messages'''
+        start = time.time()
+        self.master.mav.param_request_list_send(self.master.target_system, self.master.target_component)
+        received = set()
+        count = None
+        last_rx = time.time()
+        while count is None or len(received) < count:
+            if time.time() - start > self.opts.timeout:
+                raise RuntimeError("PARAM_REQUEST_LIST timed out")
+            m = self.master.recv_match(type='PARAM_VALUE', blocking=True, timeout=0.1)
+            if m is not None:
+                count = m.param_count
+                received.add(m.param_index)
+                last_rx = time.time()
+            elif count is not None and time.time() - last_rx > 1.0:
+                # ask again for the ones we missed
+                for idx in range(count):
+                    if idx not in received:
+                        self.master.mav.param_request_read_send(self.master.target_system,
+                                                                self.master.target_component,
+                                                                b'', idx)
+                last_rx = time.time()
+        return (count, time.time() - start)
+
+    def fetch(self, base_hash):
+        '''time a download of param.pck with the hash header'''
+        self.ftp.opts.path = "@PARAM/param.pck?changed_since=%08x" % base_hash
+        self.ftp.sessions = [Session(1)]
+        start = time.time()
+        self.ftp.download()
+        elapsed = time.time() - start
+        session = self.ftp.sessions[0]
+        return unpack(bytes(session.data)) + (session.size, elapsed)
+
+    def set_params(self):
+        for p in self.opts.set:
+            (name, value) = p.split('=')
+            self.master.param_set_send(name, float(value))
+            self.master.recv_match(type='PARAM_VALUE', blocking=True, timeout=2)
+
+    def run(self):
+        (count, elapsed) = self.param_request_list()
+        print("PARAM_REQUEST_LIST: %u params in %.2fs" % (count, elapsed))
+
+        (snap_hash, base_hash, params, size, elapsed) = self.fetch(0)
+        print("param.pck full: %u params, %u bytes in %.2fs, hash 0x%08x" % (len(params), size, elapsed, snap_hash))
+
+        self.set_params()
+
+        (new_hash, base_hash, changed, size, elapsed) = self.fetch(snap_hash)
+        if base_hash != snap_hash:
+            print("param.pck delta not available, got full list")
+        print("param.pck delta: %u params, %u bytes in %.2fs, hash 0x%08x" % (len(changed), size, elapsed, new_hash))
+        params.update(changed)
+
+        # check the merged list against a full download
+        (_, _, full, _, _) = self.fetch(0)
+        if full != params:
+            print("merged parameters don't match full download")
+            return False
+        print("merged parameters match full download")
+        return True
+
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument("--master", default="udpin:127.0.0.1:14551", help="MAVLink connection")
+parser.add_argument("--source-system", type=int, default=250, help="our MAVLink system ID")
+parser.add_argument("--timeout", type=float, default=300.0, help="give up after this many seconds")
+parser.add_argument("--set", action='append', default=[], help="NAME=VALUE of a parameter to change before the delta")
+args = parser.parse_args()
+
+if not ParamDeltaBench(args).run():
+    raise SystemExit(1)
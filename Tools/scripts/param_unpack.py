@@ -15,14 +15,25 @@ data = open(args.file,'rb').read()
 last_name = ""
 
 magic = 0x671b
+magic_defaults = 0x671c
+magic_hash = 0x671d
+magic_hash_defaults = 0x671e
 
 # header of 6 bytes
 magic2,num_params,total_params = struct.unpack("<HHH", data[0:6])
-if magic != magic2:
+if magic2 not in [magic, magic_defaults, magic_hash, magic_hash_defaults]:
     print("Bad magic 0x%x expected 0x%x" % (magic2, magic))
     sys.exit(1)
 
-data = data[6:]
+if magic2 in [magic_hash, magic_hash_defaults]:
+    # snapshot hash header of 14 bytes
+    snap_hash, base_hash = struct.unpack("<II", data[6:14])
+    if base_hash != 0:
+        print("Changes since 0x%08x" % base_hash)
+    print("Hash 0x%08x" % snap_hash)
+    data = data[14:]
+else:
+    data = data[6:]
 
 # mapping of data type to type length and format
 data_types = {
@@ -65,6 +76,9 @@ while True:
     vdata = data[2+name_len:2+name_len+type_len]
     last_name = name
     data = data[2+name_len+type_len:]
+    if flags & 1:
+        # skip the default value
+        data = data[type_len:]
     v, = struct.unpack("<" + type_format, vdata)
     count += 1
     print("%-16s %f" % (name, float(v)))
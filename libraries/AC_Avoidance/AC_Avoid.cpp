@@ -34,6 +34,9 @@
     # define AP_AVOID_ENABLE_Z          1
 #endif
 
+// maximum number of nearby polygon edges checked using a polygon's edge index
+#define AC_AVOID_POLYGON_NEAR_EDGES_MAX 32
+
 const AP_Param::GroupInfo AC_Avoid::var_info[] = {
 
     // @Param: ENABLE
@@ -840,9 +843,10 @@ void AC_Avoid::adjust_velocity_inclusion_and_exclusion_polygons(float kP, float
     for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
+        const PolygonIndex<float>* index = fence->polyfence().get_inclusion_polygon_index(i);
         Vector2f backup_vel_inc;
         // adjust velocity
-        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_inc, boundary, num_points, fence->get_margin(), dt, true);
+        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_inc, boundary, num_points, fence->get_margin(), dt, true, index);
         find_max_quadrant_velocity(backup_vel_inc, quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel);
     }
 
@@ -851,9 +855,10 @@ void AC_Avoid::adjust_velocity_inclusion_and_exclusion_polygons(float kP, float
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
+        const PolygonIndex<float>* index = fence->polyfence().get_exclusion_polygon_index(i);
         Vector2f backup_vel_exc;
         // adjust velocity
-        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_exc, boundary, num_points, fence->get_margin(), dt, false);
+        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_exc, boundary, num_points, fence->get_margin(), dt, false, index);
         find_max_quadrant_velocity(backup_vel_exc, quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel);
     }
     // desired backup velocity is sum of maximum velocity component in each quadrant 
@@ -1170,7 +1175,7 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
 
     AP_Proximity &_proximity = *proximity;
     // get total number of obstacles
-    const uint8_t obstacle_num = _proximity.get_obstacle_count();
+    const uint16_t obstacle_num = _proximity.get_obstacle_count();
     if (obstacle_num == 0) {
         // no obstacles
         return;
@@ -1190,6 +1195,12 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
     Vector3f safe_vel = Vector3f{desired_vel_body_cms.x, desired_vel_body_cms.y, desired_vel_cms.z};
     const Vector3f safe_vel_orig = safe_vel;
 
+    // only consider obstacles within _velocity_angle of the desired acceleration
+    // the test is done on the cosine of the angle to keep the loop over the obstacles cheap with high resolution sensors
+    const bool check_velocity_angle = (_velocity_angle > 0) && !desired_accel.is_zero();
+    const Vector2f des_accel_body = check_velocity_angle ? _ahrs.earth_to_body2D(desired_accel).normalized() : Vector2f{};
+    const float cos_velocity_angle = cosf(radians(_velocity_angle));
+
     // calc margin in cm
     const float margin_cm = MAX(_margin * 100.0f, 0.0f);
     Vector3f stopping_point_plus_margin;
@@ -1199,7 +1210,7 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
         stopping_point_plus_margin = safe_vel * ((2.0f + margin_cm + get_stopping_distance(kP, accel_cmss, speed))/speed);
     }
 
-    for (uint8_t i = 0; i<obstacle_num; i++) {
+    for (uint16_t i = 0; i<obstacle_num; i++) {
         // get obstacle from proximity library
         Vector3f vector_to_obstacle;
         if (!_proximity.get_obstacle(i, vector_to_obstacle)) {
@@ -1214,10 +1225,10 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
 
         // consider only obstacle in body velocity direction +- _velocity_angle
         // actually now we're using desired acceleration
-        if (_velocity_angle > 0 && !desired_accel.is_zero()) {
-            Vector2f des_accel_body = _ahrs.earth_to_body2D(desired_accel);
-            float angle_vel_obstacle = des_accel_body.angle(vector_to_obstacle.xy());
-            if (abs(angle_vel_obstacle) > radians(_velocity_angle)) {
+        if (check_velocity_angle) {
+            const Vector2f obstacle_xy = vector_to_obstacle.xy();
+            const float obstacle_xy_length = obstacle_xy.length();
+            if (!is_zero(obstacle_xy_length) && (des_accel_body * obstacle_xy < cos_velocity_angle * obstacle_xy_length)) {
                 continue;
             }
         }
@@ -1309,7 +1320,7 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
 /*
  * Adjusts the desired velocity for the polygon fence.
  */
-void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside)
+void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside, const PolygonIndex<float>* index)
 {
     // exit if there are no points
     if (boundary == nullptr || num_points == 0) {
@@ -1329,7 +1340,7 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
 
 
     // return if we have already breached polygon
-    const bool inside_polygon = !Polygon_outside(position_xy, boundary, num_points);
+    const bool inside_polygon = (index != nullptr) ? !index->outside(position_xy) : !Polygon_outside(position_xy, boundary, num_points);
     if (inside_polygon != stay_inside) {
         return;
     }
@@ -1352,8 +1363,23 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
 
     // for backing away
     Vector2f quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel;
-   
-    for (uint16_t i=0; i<num_points; i++) {
+
+    // edges further away than the stopping distance plus margin can
+    // neither limit the velocity nor cause a backup, so only check the
+    // nearby edges if we have an index.  The edges are kept in order
+    // as the limits are applied one after another
+    uint16_t near_edges[AC_AVOID_POLYGON_NEAR_EDGES_MAX];
+    uint16_t num_near_edges = 0;
+    bool use_near_edges = false;
+    if (index != nullptr && is_positive(accel_cmss) && !is_negative(kP)) {
+        const float near_dist_cm = 2.0f + margin_cm + MAX(get_stopping_distance(kP, accel_cmss, speed), speed * dt);
+        // pad the distance to allow for rounding
+        use_near_edges = index->edges_near(position_xy, near_dist_cm * 1.01f + 10.0f, near_edges, ARRAY_SIZE(near_edges), num_near_edges);
+    }
+    const uint16_t num_edges = use_near_edges ? num_near_edges : num_points;
+
+    for (uint16_t k=0; k<num_edges; k++) {
+        const uint16_t i = use_near_edges ? near_edges[k] : k;
         uint16_t j = i+1;
         if (j >= num_points) {
             j = 0;
@@ -155,8 +155,9 @@ private:
      * The boundary must be in Earth Frame
      * margin is the distance (in meters) that the vehicle should stop short of the polygon
      * stay_inside should be true for fences, false for exclusion polygons
+     * index is an optional edge index of the boundary points used to only check nearby edges
      */
-    void adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside);
+    void adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside, const PolygonIndex<float>* index = nullptr);
 
     /*
      * Computes distance required to stop, given current speed.
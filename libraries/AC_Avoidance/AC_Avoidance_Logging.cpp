@@ -28,7 +28,8 @@ void AP_OABendyRuler::Write_OABendyRuler(const uint8_t type, const bool active,
         final_alt   : got_final_dest ? final_alt : final_dest.alt,
         oa_lat      : oa_dest.lat,
         oa_lng      : oa_dest.lng,
-        oa_alt      : got_oa_dest ? oa_dest_alt : oa_dest.alt
+        oa_alt      : got_oa_dest ? oa_dest_alt : oa_dest.alt,
+        latency_us  : AP_HAL::micros() - _update_start_us
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
 }
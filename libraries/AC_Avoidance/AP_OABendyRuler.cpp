@@ -20,6 +20,8 @@
 #include <AP_Logger/AP_Logger.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 
+extern const AP_HAL::HAL &hal;
+
 // parameter defaults
 const float OA_BENDYRULER_LOOKAHEAD_DEFAULT = 15.0f;
 const float OA_BENDYRULER_RATIO_DEFAULT = 1.5f;
@@ -83,9 +85,15 @@ AP_OABendyRuler::AP_OABendyRuler()
 // bendy_type is set to the type of BendyRuler used
 bool AP_OABendyRuler::update(const Location& current_loc, const Location& destination, const Vector2f &ground_speed_vec, Location &origin_new, Location &destination_new, OABendyType &bendy_type, bool proximity_only)
 {
+    // time the search for the log
+    _update_start_us = AP_HAL::micros();
+
     // bendy ruler always sets origin to current_loc
     origin_new = current_loc;
 
+    // copy the fence so it is consistent for the whole search and can be used by the worker threads
+    update_fence_snapshot();
+
     // init bendy_type returned
     bendy_type = OABendyType::OA_BENDY_DISABLED;
 
@@ -138,6 +146,24 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
 {
     // check OA_BEARING_INC definition allows checking in all directions
     static_assert(360 % OA_BENDYRULER_BEARING_INC_XY == 0, "check 360 is a multiple of OA_BEARING_INC");
+    static_assert(OA_BENDYRULER_XY_BEARINGS == 1 + 2 * (170 / OA_BENDYRULER_BEARING_INC_XY), "check OA_BENDYRULER_XY_BEARINGS matches OA_BEARING_INC");
+
+    // margins are calculated on demand or, with worker threads, in batches ahead of the search
+    _xy_search.current_loc = current_loc;
+    _xy_search.destination = destination;
+    _xy_search.bearing_to_dest = bearing_to_dest;
+    _xy_search.lookahead_step1_dist = lookahead_step1_dist;
+    _xy_search.lookahead_step2_dist = lookahead_step2_dist;
+    _xy_search.proximity_only = proximity_only;
+    for (auto &result : _xy_results) {
+        result.valid = false;
+    }
+
+#if AP_OABENDYRULER_NUM_WORKERS > 0
+    // batches are sized so each thread evaluates two bearings
+    const bool use_workers = init_workers();
+    const uint8_t batch_size = (_num_workers + 1) * 2;
+#endif
 
     // search in OA_BENDYRULER_BEARING_INC degree increments around the vehicle alternating left
     // and right. For each direction check if vehicle would avoid all obstacles
@@ -147,70 +173,64 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
     float best_margin = -FLT_MAX;
     float best_margin_bearing = best_bearing;
 
-    for (uint8_t i = 0; i <= (170 / OA_BENDYRULER_BEARING_INC_XY); i++) {
-        for (uint8_t bdir = 0; bdir <= 1; bdir++) {
-            // skip duplicate check of bearing straight towards destination
-            if ((i==0) && (bdir > 0)) {
-                continue;
+    for (uint8_t i = 0; i < OA_BENDYRULER_XY_BEARINGS; i++) {
+        auto &result = _xy_results[i];
+        if (!result.valid) {
+#if AP_OABENDYRULER_NUM_WORKERS > 0
+            // the bearing straight towards the destination is usually clear so is checked on its own
+            if (use_workers && (i > 0)) {
+                calc_xy_bearings_parallel(i, MIN(i + batch_size, OA_BENDYRULER_XY_BEARINGS));
+            } else
+#endif
+            {
+                calc_xy_bearing(i, 0);
             }
-            // bearing that we are probing
-            const float bearing_delta = i * OA_BENDYRULER_BEARING_INC_XY * (bdir == 0 ? -1.0f : 1.0f);
-            const float bearing_test = wrap_180(bearing_to_dest + bearing_delta);
-
-            // ToDo: add effective groundspeed calculations using airspeed
-            // ToDo: add prediction of vehicle's position change as part of turn to desired heading
+        }
 
-            // test location is projected from current location at test bearing
-            Location test_loc = current_loc;
-            test_loc.offset_bearing(bearing_test, lookahead_step1_dist);
+        // ToDo: add effective groundspeed calculations using airspeed
+        // ToDo: add prediction of vehicle's position change as part of turn to desired heading
 
-            // calculate margin from obstacles for this scenario
-            float margin = calc_avoidance_margin(current_loc, test_loc, proximity_only);
-            if (margin > best_margin) {
-                best_margin_bearing = bearing_test;
-                best_margin = margin;
+        const float bearing_test = result.bearing;
+        const float margin = result.margin;
+        if (margin > best_margin) {
+            best_margin_bearing = bearing_test;
+            best_margin = margin;
+        }
+        if (margin > _margin_max) {
+            // this bearing avoids obstacles out to the lookahead_step1_dist
+            // now check in there is a clear path in three directions towards the destination
+            if (!have_best_bearing) {
+                best_bearing = bearing_test;
+                best_bearing_margin = margin;
+                have_best_bearing = true;
+            } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
+                       fabsf(wrap_180(ground_course_deg - best_bearing))) {
+                // replace bearing with one that is closer to our current ground course
+                best_bearing = bearing_test;
+                best_bearing_margin = margin;
             }
-            if (margin > _margin_max) {
-                // this bearing avoids obstacles out to the lookahead_step1_dist
-                // now check in there is a clear path in three directions towards the destination
-                if (!have_best_bearing) {
-                    best_bearing = bearing_test;
-                    best_bearing_margin = margin;
-                    have_best_bearing = true;
-                } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
-                           fabsf(wrap_180(ground_course_deg - best_bearing))) {
-                    // replace bearing with one that is closer to our current ground course
-                    best_bearing = bearing_test;
-                    best_bearing_margin = margin;
-                }
-
-                // perform second stage test in three directions looking for obstacles
-                const float test_bearings[] { 0.0f, 45.0f, -45.0f };
-                const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
-                float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
-                for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
-                    float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
-                    Location test_loc2 = test_loc;
-                    test_loc2.offset_bearing(bearing_test2, distance2);
 
-                    // calculate minimum margin to fence and obstacles for this scenario
-                    float margin2 = calc_avoidance_margin(test_loc, test_loc2, proximity_only);
-                    if (margin2 > _margin_max) {
-                        // if the chosen direction is directly towards the destination avoidance can be turned off
-                        // i == 0 && j == 0 implies no deviation from bearing to destination 
-                        const bool active = (i != 0 || j != 0);
-                        float final_bearing = bearing_test;
-                        float final_margin = margin;
-                        // check if we need ignore test_bearing and continue on previous bearing
-                        const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
-
-                        // all good, now project in the chosen direction by the full distance
-                        destination_new = current_loc;
-                        destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
-                        _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
-                        Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
-                        return active;
-                    }
+            // perform second stage test in three directions looking for obstacles
+            for (uint8_t j = 0; j < ARRAY_SIZE(result.margin2); j++) {
+                if (j >= result.num_margin2) {
+                    result.margin2[j] = calc_xy_margin2(i, j);
+                    result.num_margin2 = j + 1;
+                }
+                if (result.margin2[j] > _margin_max) {
+                    // if the chosen direction is directly towards the destination avoidance can be turned off
+                    // i == 0 && j == 0 implies no deviation from bearing to destination 
+                    const bool active = (i != 0 || j != 0);
+                    float final_bearing = bearing_test;
+                    float final_margin = margin;
+                    // check if we need ignore test_bearing and continue on previous bearing
+                    const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
+
+                    // all good, now project in the chosen direction by the full distance
+                    destination_new = current_loc;
+                    destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
+                    _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
+                    Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
+                    return active;
                 }
             }
         }
@@ -242,6 +262,106 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
     return true;
 }
 
+// calculate the step1 margin for one bearing of the horizontal search and, if the bearing is clear,
+// the first num_step2 of its second stage margins.  Bearings alternate left and right of the
+// destination moving outwards so index 0 is straight towards the destination
+void AP_OABendyRuler::calc_xy_bearing(uint8_t index, uint8_t num_step2)
+{
+    auto &result = _xy_results[index];
+
+    // bearing that we are probing
+    const float bearing_delta = ((index + 1) / 2) * OA_BENDYRULER_BEARING_INC_XY * ((index & 1) ? -1.0f : 1.0f);
+    result.bearing = wrap_180(_xy_search.bearing_to_dest + bearing_delta);
+
+    // test location is projected from current location at test bearing
+    result.test_loc = _xy_search.current_loc;
+    result.test_loc.offset_bearing(result.bearing, _xy_search.lookahead_step1_dist);
+
+    // calculate margin from obstacles for this scenario
+    result.margin = calc_avoidance_margin(_xy_search.current_loc, result.test_loc, _xy_search.proximity_only);
+    result.num_margin2 = 0;
+    if (result.margin > _margin_max) {
+        result.bearing_to_dest2 = result.test_loc.get_bearing_to(_xy_search.destination) * 0.01f;
+        result.distance2 = constrain_float(_xy_search.lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, result.test_loc.get_distance(_xy_search.destination));
+        num_step2 = MIN(num_step2, ARRAY_SIZE(result.margin2));
+        for (uint8_t j = 0; j < num_step2; j++) {
+            result.margin2[j] = calc_xy_margin2(index, j);
+        }
+        result.num_margin2 = num_step2;
+    }
+    result.valid = true;
+}
+
+// calculate the second stage margin in direction j for a bearing that is clear for step1
+float AP_OABendyRuler::calc_xy_margin2(uint8_t index, uint8_t j) const
+{
+    const auto &result = _xy_results[index];
+    const float test_bearings[] { 0.0f, 45.0f, -45.0f };
+    static_assert(ARRAY_SIZE(test_bearings) == ARRAY_SIZE(result.margin2), "check margin2 holds all second stage bearings");
+
+    const float bearing_test2 = wrap_180(result.bearing_to_dest2 + test_bearings[j]);
+    Location test_loc2 = result.test_loc;
+    test_loc2.offset_bearing(bearing_test2, result.distance2);
+
+    // calculate minimum margin to fence and obstacles for this scenario
+    return calc_avoidance_margin(result.test_loc, test_loc2, _xy_search.proximity_only);
+}
+
+#if AP_OABENDYRULER_NUM_WORKERS > 0
+// start worker threads, returns true if at least one is available
+bool AP_OABendyRuler::init_workers()
+{
+    if (!_workers_init_done) {
+        _workers_init_done = true;
+        for (uint8_t i = 0; i < ARRAY_SIZE(_workers); i++) {
+            Worker &worker = _workers[i];
+            worker.bendy = this;
+            worker.stripe = i + 1;
+            // workers run at the same priority as the avoidance thread
+            if (!hal.scheduler->thread_create(FUNCTOR_BIND(&worker, &AP_OABendyRuler::Worker::thread, void),
+                                              "avoidance",
+                                              8192, AP_HAL::Scheduler::PRIORITY_IO, -1)) {
+                break;
+            }
+            _num_workers++;
+        }
+    }
+    return _num_workers > 0;
+}
+
+// worker thread evaluates its share of each batch of bearings when signalled by the avoidance thread
+void AP_OABendyRuler::Worker::thread()
+{
+    while (true) {
+        start.wait_blocking();
+        bendy->calc_xy_bearings_stripe(stripe);
+        done.signal();
+    }
+}
+
+// calculate all margins for bearings start to end-1, sharing the work with the worker threads
+void AP_OABendyRuler::calc_xy_bearings_parallel(uint8_t start, uint8_t end)
+{
+    _xy_search.batch_start = start;
+    _xy_search.batch_end = end;
+    for (uint8_t i = 0; i < _num_workers; i++) {
+        _workers[i].start.signal();
+    }
+    calc_xy_bearings_stripe(0);
+    for (uint8_t i = 0; i < _num_workers; i++) {
+        _workers[i].done.wait_blocking();
+    }
+}
+
+// calculate all margins for every (_num_workers+1)th bearing of the current batch beginning at stripe
+void AP_OABendyRuler::calc_xy_bearings_stripe(uint8_t stripe)
+{
+    for (uint16_t i = _xy_search.batch_start + stripe; i < _xy_search.batch_end; i += _num_workers + 1) {
+        calc_xy_bearing(i, ARRAY_SIZE(_xy_results[i].margin2));
+    }
+}
+#endif  // AP_OABENDYRULER_NUM_WORKERS > 0
+
 // Search for path in the vertical directions
 bool AP_OABendyRuler::search_vertical_path(const Location &current_loc, const Location &destination, Location &destination_new, float lookahead_step1_dist, float lookahead_step2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only)
 {
@@ -412,6 +532,116 @@ bool AP_OABendyRuler::resist_bearing_change(const Location &destination, const L
     return resisted_change;
 }
 
+// copy the fence so margins can be calculated without holding the fence semaphore.  Polygons
+// and circles are only copied when the fence is reloaded
+void AP_OABendyRuler::update_fence_snapshot()
+{
+#if AP_FENCE_ENABLED
+    AC_Fence *fence = AP::fence();
+    if (fence == nullptr) {
+        _fence.enabled_fences = 0;
+        return;
+    }
+    _fence.enabled_fences = fence->get_enabled_fences();
+    _fence.margin = fence->get_margin();
+    _fence.circle_radius = fence->get_radius();
+    _fence.safe_alt_max = fence->get_safe_alt_max();
+    _fence.home = AP::ahrs().get_home();
+
+    AC_PolyFence_loader &polyfence = fence->polyfence();
+    WITH_SEMAPHORE(polyfence.get_loaded_fence_semaphore());
+
+    const uint8_t num_inclusion_polygons = polyfence.get_inclusion_polygon_count();
+    const uint8_t num_exclusion_polygons = polyfence.get_exclusion_polygon_count();
+    const uint8_t num_inclusion_circles = polyfence.get_inclusion_circle_count();
+    const uint8_t num_exclusion_circles = polyfence.get_exclusion_circle_count();
+    if (_fence.ok &&
+        (_fence.load_time_ms == polyfence.get_inclusion_polygon_update_ms()) &&
+        (_fence.num_inclusion_polygons == num_inclusion_polygons) &&
+        (_fence.num_exclusion_polygons == num_exclusion_polygons) &&
+        (_fence.num_inclusion_circles == num_inclusion_circles) &&
+        (_fence.num_exclusion_circles == num_exclusion_circles)) {
+        return;
+    }
+    _fence.ok = false;
+
+    // count polygon points
+    const uint16_t num_polygons = num_inclusion_polygons + num_exclusion_polygons;
+    uint16_t num_points_total = 0;
+    for (uint16_t i = 0; i < num_polygons; i++) {
+        uint16_t num_points;
+        if (i < num_inclusion_polygons) {
+            polyfence.get_inclusion_polygon(i, num_points);
+        } else {
+            polyfence.get_exclusion_polygon(i - num_inclusion_polygons, num_points);
+        }
+        num_points_total += num_points;
+    }
+
+    // expand arrays if required
+    if (num_points_total > _fence.points_max) {
+        delete[] _fence.points;
+        _fence.points = new Vector2f[num_points_total];
+        _fence.points_max = (_fence.points != nullptr) ? num_points_total : 0;
+    }
+    if (num_polygons > _fence.polygons_max) {
+        delete[] _fence.polygons;
+        _fence.polygons = new FenceSnapshotPolygon[num_polygons];
+        _fence.polygons_max = (_fence.polygons != nullptr) ? num_polygons : 0;
+    }
+    const uint16_t num_circles = num_inclusion_circles + num_exclusion_circles;
+    if (num_circles > _fence.circles_max) {
+        delete[] _fence.circles;
+        _fence.circles = new FenceSnapshotCircle[num_circles];
+        _fence.circles_max = (_fence.circles != nullptr) ? num_circles : 0;
+    }
+    if ((num_points_total > _fence.points_max) || (num_polygons > _fence.polygons_max) || (num_circles > _fence.circles_max)) {
+        return;
+    }
+
+    // copy inclusion polygons followed by exclusion polygons
+    uint16_t start = 0;
+    for (uint16_t i = 0; i < num_polygons; i++) {
+        uint16_t num_points;
+        const Vector2f *boundary;
+        if (i < num_inclusion_polygons) {
+            boundary = polyfence.get_inclusion_polygon(i, num_points);
+        } else {
+            boundary = polyfence.get_exclusion_polygon(i - num_inclusion_polygons, num_points);
+        }
+        if (boundary == nullptr) {
+            num_points = 0;
+        } else {
+            memcpy(&_fence.points[start], boundary, num_points * sizeof(Vector2f));
+        }
+        _fence.polygons[i].start = start;
+        _fence.polygons[i].num_points = num_points;
+        start += num_points;
+    }
+
+    // copy inclusion circles followed by exclusion circles
+    for (uint16_t i = 0; i < num_circles; i++) {
+        FenceSnapshotCircle &circle = _fence.circles[i];
+        bool ok;
+        if (i < num_inclusion_circles) {
+            ok = polyfence.get_inclusion_circle(i, circle.center_pos_cm, circle.radius);
+        } else {
+            ok = polyfence.get_exclusion_circle(i - num_inclusion_circles, circle.center_pos_cm, circle.radius);
+        }
+        if (!ok) {
+            return;
+        }
+    }
+
+    _fence.num_inclusion_polygons = num_inclusion_polygons;
+    _fence.num_exclusion_polygons = num_exclusion_polygons;
+    _fence.num_inclusion_circles = num_inclusion_circles;
+    _fence.num_exclusion_circles = num_exclusion_circles;
+    _fence.load_time_ms = polyfence.get_inclusion_polygon_update_ms();
+    _fence.ok = true;
+#endif // AP_FENCE_ENABLED
+}
+
 // calculate minimum distance between a segment and any obstacle
 float AP_OABendyRuler::calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const
 {
@@ -458,22 +688,17 @@ float AP_OABendyRuler::calc_avoidance_margin(const Location &start, const Locati
 bool AP_OABendyRuler::calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin) const
 {
 #if AP_FENCE_ENABLED
-    // exit immediately if polygon fence is not enabled
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
-        return false;
-    }
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_CIRCLE) == 0) {
+    // exit immediately if circular fence is not enabled
+    if ((_fence.enabled_fences & AC_FENCE_TYPE_CIRCLE) == 0) {
         return false;
     }
 
     // calculate start and end point's distance from home
-    const Location &ahrs_home = AP::ahrs().get_home();
-    const float start_dist_sq = ahrs_home.get_distance_NE(start).length_squared();
-    const float end_dist_sq = ahrs_home.get_distance_NE(end).length_squared();
+    const float start_dist_sq = _fence.home.get_distance_NE(start).length_squared();
+    const float end_dist_sq = _fence.home.get_distance_NE(end).length_squared();
 
     // get circular fence radius + margin
-    const float fence_radius_plus_margin = fence->get_radius() - fence->get_margin();
+    const float fence_radius_plus_margin = _fence.circle_radius - _fence.margin;
 
     // margin is fence radius minus the longer of start or end distance
     margin = fence_radius_plus_margin - sqrtf(MAX(start_dist_sq, end_dist_sq));
@@ -488,12 +713,8 @@ bool AP_OABendyRuler::calc_margin_from_circular_fence(const Location &start, con
 bool AP_OABendyRuler::calc_margin_from_alt_fence(const Location &start, const Location &end, float &margin) const
 {
 #if AP_FENCE_ENABLED
-    // exit immediately if polygon fence is not enabled
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
-        return false;
-    }
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_ALT_MAX) == 0) {
+    // exit immediately if alt fence is not enabled
+    if ((_fence.enabled_fences & AC_FENCE_TYPE_ALT_MAX) == 0) {
         return false;
     }
 
@@ -506,7 +727,7 @@ bool AP_OABendyRuler::calc_margin_from_alt_fence(const Location &start, const Lo
     }
 
     // safe max alt = fence alt - fence margin
-    const float max_fence_alt = fence->get_safe_alt_max();
+    const float max_fence_alt = _fence.safe_alt_max;
     const float margin_start =  max_fence_alt - alt_above_home_cm_start * 0.01f;
     const float margin_end =  max_fence_alt - alt_above_home_cm_end * 0.01f;
 
@@ -524,19 +745,20 @@ bool AP_OABendyRuler::calc_margin_from_alt_fence(const Location &start, const Lo
 bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const
 {
 #if AP_FENCE_ENABLED
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
+    // exclusion polygons enabled along with polygon fences
+    if ((_fence.enabled_fences & AC_FENCE_TYPE_POLYGON) == 0) {
         return false;
     }
 
-    // exclusion polygons enabled along with polygon fences
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_POLYGON) == 0) {
-        return false;
+    // if the fence could not be copied treat every path as blocked
+    if (!_fence.ok) {
+        margin = -FLT_MAX;
+        return true;
     }
 
     // return immediately if no inclusion nor exclusion polygons
-    const uint8_t num_inclusion_polygons = fence->polyfence().get_inclusion_polygon_count();
-    const uint8_t num_exclusion_polygons = fence->polyfence().get_exclusion_polygon_count();
+    const uint8_t num_inclusion_polygons = _fence.num_inclusion_polygons;
+    const uint8_t num_exclusion_polygons = _fence.num_exclusion_polygons;
     if ((num_inclusion_polygons == 0) && (num_exclusion_polygons == 0)) {
         return false;
     }
@@ -548,13 +770,13 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
     }
 
     // get fence margin
-    const float fence_margin = fence->get_margin();
+    const float fence_margin = _fence.margin;
 
     // iterate through inclusion polygons and calculate minimum margin
     bool margin_updated = false;
     for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
-        uint16_t num_points;
-        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
+        const uint16_t num_points = _fence.polygons[i].num_points;
+        const Vector2f* boundary = &_fence.points[_fence.polygons[i].start];
      
         // if outside the fence margin is the closest distance but with negative sign
         const float sign = Polygon_outside(start_NE, boundary, num_points) ? -1.0f : 1.0f;
@@ -569,8 +791,8 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
 
     // iterate through exclusion polygons and calculate minimum margin
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
-        uint16_t num_points;
-        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
+        const uint16_t num_points = _fence.polygons[num_inclusion_polygons + i].num_points;
+        const Vector2f* boundary = &_fence.points[_fence.polygons[num_inclusion_polygons + i].start];
    
         // if start is inside the polygon the margin's sign is reversed
         const float sign = Polygon_outside(start_NE, boundary, num_points) ? 1.0f : -1.0f;
@@ -594,20 +816,20 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
 bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const
 {
 #if AP_FENCE_ENABLED
-    // exit immediately if fence is not enabled
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
+    // inclusion/exclusion circles enabled along with polygon fences
+    if ((_fence.enabled_fences & AC_FENCE_TYPE_POLYGON) == 0) {
         return false;
     }
 
-    // inclusion/exclusion circles enabled along with polygon fences
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_POLYGON) == 0) {
-        return false;
+    // if the fence could not be copied treat every path as blocked
+    if (!_fence.ok) {
+        margin = -FLT_MAX;
+        return true;
     }
 
     // return immediately if no inclusion nor exclusion circles
-    const uint8_t num_inclusion_circles = fence->polyfence().get_inclusion_circle_count();
-    const uint8_t num_exclusion_circles = fence->polyfence().get_exclusion_circle_count();
+    const uint8_t num_inclusion_circles = _fence.num_inclusion_circles;
+    const uint8_t num_exclusion_circles = _fence.num_exclusion_circles;
     if ((num_inclusion_circles == 0) && (num_exclusion_circles == 0)) {
         return false;
     }
@@ -619,47 +841,43 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
     }
 
     // get fence margin
-    const float fence_margin = fence->get_margin();
+    const float fence_margin = _fence.margin;
 
     // iterate through inclusion circles and calculate minimum margin
     bool margin_updated = false;
     for (uint8_t i = 0; i < num_inclusion_circles; i++) {
-        Vector2f center_pos_cm;
-        float radius;
-        if (fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
+        const Vector2f &center_pos_cm = _fence.circles[i].center_pos_cm;
+        const float radius = _fence.circles[i].radius;
 
-            // calculate start and ends distance from the center of the circle
-            const float start_dist_sq = (start_NE - center_pos_cm).length_squared();
-            const float end_dist_sq = (end_NE - center_pos_cm).length_squared();
+        // calculate start and ends distance from the center of the circle
+        const float start_dist_sq = (start_NE - center_pos_cm).length_squared();
+        const float end_dist_sq = (end_NE - center_pos_cm).length_squared();
 
-            // margin is fence radius minus the longer of start or end distance
-            const float margin_new = (radius + fence_margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
+        // margin is fence radius minus the longer of start or end distance
+        const float margin_new = (radius + fence_margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
 
-            // update margin with lowest value so far
-            if (!margin_updated || (margin_new < margin)) {
-                margin_updated = true;
-                margin = margin_new;
-            }
+        // update margin with lowest value so far
+        if (!margin_updated || (margin_new < margin)) {
+            margin_updated = true;
+            margin = margin_new;
         }
     }
 
     // iterate through exclusion circles and calculate minimum margin
     for (uint8_t i = 0; i < num_exclusion_circles; i++) {
-        Vector2f center_pos_cm;
-        float radius;
-        if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+        const Vector2f &center_pos_cm = _fence.circles[num_inclusion_circles + i].center_pos_cm;
+        const float radius = _fence.circles[num_inclusion_circles + i].radius;
 
-            // first calculate distance between circle's center and segment
-            const float dist_cm = Vector2f::closest_distance_between_line_and_point(start_NE, end_NE, center_pos_cm);
+        // first calculate distance between circle's center and segment
+        const float dist_cm = Vector2f::closest_distance_between_line_and_point(start_NE, end_NE, center_pos_cm);
 
-            // margin is distance to the center minus the radius
-            const float margin_new = (dist_cm * 0.01f) - (radius + fence_margin);
+        // margin is distance to the center minus the radius
+        const float margin_new = (dist_cm * 0.01f) - (radius + fence_margin);
 
-            // update margin with lowest value so far
-            if (!margin_updated || (margin_new < margin)) {
-                margin_updated = true;
-                margin = margin_new;
-            }
+        // update margin with lowest value so far
+        if (!margin_updated || (margin_new < margin)) {
+            margin_updated = true;
+            margin = margin_new;
         }
     }
 
@@ -688,23 +906,6 @@ bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, co
         return false;
     }
 
-    // check each obstacle's distance from segment
-    float smallest_margin = FLT_MAX;
-    for (uint16_t i=0; i<oaDb->database_count(); i++) {
-        const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
-        const Vector3f point_cm = item.pos * 100.0f;
-        // margin is distance between line segment and obstacle minus obstacle's radius
-        const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end_NEU, point_cm) * 0.01f - item.radius;
-        if (m < smallest_margin) {
-            smallest_margin = m;
-        }
-    }
-
-    // return smallest margin
-    if (smallest_margin < FLT_MAX) {
-        margin = smallest_margin;
-        return true;
-    }
-
-    return false;
+    // database positions are in meters
+    return oaDb->calc_margin_from_segment(start_NEU * 0.01f, end_NEU * 0.01f, margin);
 }
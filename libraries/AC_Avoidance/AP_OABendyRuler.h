@@ -3,7 +3,22 @@
 #include <AP_Common/AP_Common.h>
 #include <AP_Common/Location.h>
 #include <AP_Math/AP_Math.h>
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_HAL/Semaphores.h>
 #include <AP_Logger/AP_Logger_config.h>
+#include <AC_Fence/AC_Fence_config.h>
+
+// number of threads that help the avoidance thread evaluate bearings
+#ifndef AP_OABENDYRULER_NUM_WORKERS
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define AP_OABENDYRULER_NUM_WORKERS 3
+#else
+#define AP_OABENDYRULER_NUM_WORKERS 0
+#endif
+#endif
+
+// number of bearings checked by the horizontal search, straight ahead plus 5 degree steps out to 170 degrees either side
+#define OA_BENDYRULER_XY_BEARINGS 69
 
 /*
  * BendyRuler avoidance algorithm for avoiding the polygon and circular fence and dynamic objects detected by the proximity sensor
@@ -41,6 +56,27 @@ private:
     // search for path in the Vertical directions
     bool search_vertical_path(const Location &current_loc, const Location &destination, Location &destination_new, float lookahead_step1_dist, float lookahead_step2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only);
 
+    // calculate the step1 margin for one bearing of the horizontal search described by _xy_search
+    // and, if the bearing is clear, the first num_step2 of its second stage margins
+    void calc_xy_bearing(uint8_t index, uint8_t num_step2);
+
+    // calculate the second stage margin in direction j for a bearing that is clear for step1
+    float calc_xy_margin2(uint8_t index, uint8_t j) const;
+
+#if AP_OABENDYRULER_NUM_WORKERS > 0
+    // start worker threads, returns true if at least one is available
+    bool init_workers();
+
+    // calculate all margins for bearings start to end-1, sharing the work with the worker threads
+    void calc_xy_bearings_parallel(uint8_t start, uint8_t end);
+
+    // calculate all margins for every (_num_workers+1)th bearing of the current batch beginning at stripe
+    void calc_xy_bearings_stripe(uint8_t stripe);
+#endif
+
+    // copy the fence so margins can be calculated without holding the fence semaphore
+    void update_fence_snapshot();
+
     // calculate minimum distance between a path and any obstacle
     float calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const;
 
@@ -74,6 +110,22 @@ private:
     void Write_OABendyRuler(const uint8_t type, const bool active, const float target_yaw, const float target_pitch, const bool resist_chg, const float margin, const Location &final_dest, const Location &oa_dest) const {}
 #endif
 
+#if AP_OABENDYRULER_NUM_WORKERS > 0
+    // thread evaluating every (_num_workers+1)th bearing of each batch of the horizontal search
+    class Worker {
+    public:
+        void thread();
+
+        AP_OABendyRuler *bendy;
+        uint8_t stripe;             // offset within each batch of the first bearing this worker evaluates
+        HAL_BinarySemaphore start;  // signalled by the avoidance thread when bearings are ready to evaluate
+        HAL_BinarySemaphore done;   // signalled by the worker when its bearings have been evaluated
+    };
+    Worker _workers[AP_OABENDYRULER_NUM_WORKERS];
+    uint8_t _num_workers;           // number of worker threads successfully started
+    bool _workers_init_done;        // true once we have attempted to start the worker threads
+#endif
+
     // OA common parameters
     float _margin_max;              // object avoidance will ignore objects more than this many meters from vehicle
     
@@ -87,4 +139,61 @@ private:
     float _current_lookahead;       // distance (in meters) ahead of the vehicle we are looking for obstacles
     float _bearing_prev;            // stored bearing in degrees 
     Location _destination_prev;     // previous destination, to check if there has been a change in destination
+    uint32_t _update_start_us;      // system time the latest update started, used to log planner latency
+
+    // inputs shared by all bearings of the latest horizontal search
+    struct {
+        Location current_loc;
+        Location destination;
+        float bearing_to_dest;
+        float lookahead_step1_dist;
+        float lookahead_step2_dist;
+        bool proximity_only;
+        uint8_t batch_start;        // first bearing being evaluated by the worker threads
+        uint8_t batch_end;          // one past the last bearing being evaluated by the worker threads
+    } _xy_search;
+
+    // margins for each bearing of the latest horizontal search, in search order
+    struct {
+        Location test_loc;          // location lookahead_step1_dist along the bearing
+        float bearing;              // bearing in degrees
+        float margin;               // margin from obstacles on the path to test_loc
+        float bearing_to_dest2;     // bearing from test_loc to the destination
+        float distance2;            // length of the second stage paths
+        float margin2[3];           // margins of the three second stage paths, only calculated if margin > _margin_max
+        uint8_t num_margin2;        // number of margin2 calculated
+        bool valid;                 // true once the step1 margin has been calculated
+    } _xy_results[OA_BENDYRULER_XY_BEARINGS];
+
+#if AP_FENCE_ENABLED
+    struct FenceSnapshotPolygon {
+        uint16_t start;             // index of the polygon's first point
+        uint16_t num_points;
+    };
+    struct FenceSnapshotCircle {
+        Vector2f center_pos_cm;     // offset in cm from EKF origin
+        float radius;               // radius in meters
+    };
+
+    // copy of the fence, refreshed at the start of each update
+    struct {
+        uint8_t enabled_fences;     // bitmask of AC_FENCE_TYPE_ fences enabled
+        float margin;               // fence margin in meters
+        float circle_radius;        // circular fence radius in meters
+        float safe_alt_max;         // altitude fence less the margin in meters
+        Location home;              // centre of the circular fence
+        uint32_t load_time_ms;      // load time of the polygon fence copied
+        bool ok;                    // false if memory for the copy could not be allocated
+        Vector2f *points;           // points of all polygons, inclusion polygons first. offsets in cm from EKF origin
+        uint16_t points_max;        // number of points allocated
+        FenceSnapshotPolygon *polygons; // inclusion polygons followed by exclusion polygons
+        uint16_t polygons_max;      // number of polygons allocated
+        uint8_t num_inclusion_polygons;
+        uint8_t num_exclusion_polygons;
+        FenceSnapshotCircle *circles;   // inclusion circles followed by exclusion circles
+        uint16_t circles_max;       // number of circles allocated
+        uint8_t num_inclusion_circles;
+        uint8_t num_exclusion_circles;
+    } _fence;
+#endif
 };
@@ -36,6 +36,13 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#ifndef AP_OADATABASE_GRID_CELL_SIZE
+    #define AP_OADATABASE_GRID_CELL_SIZE 5.0f       // size in meters of the spatial index's horizontal grid cells
+#endif
+
+#define AP_OADATABASE_GRID_BUCKETS_MIN  16
+#define AP_OADATABASE_GRID_BUCKETS_MAX  512
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
@@ -119,6 +126,7 @@ AP_OADatabase::AP_OADatabase()
 void AP_OADatabase::init()
 {
     init_database();
+    init_grid();
     init_queue();
 
     // initialise scalar using beam width of at least 1deg
@@ -128,6 +136,8 @@ void AP_OADatabase::init()
         GCS_SEND_TEXT(MAV_SEVERITY_INFO, "DB init failed . Sizes queue:%u, db:%u", (unsigned int)_queue.size, (unsigned int)_database.size);
         delete _queue.items;
         delete[] _database.items;
+        delete[] _grid.buckets;
+        delete[] _grid.next;
         return;
     }
 }
@@ -204,6 +214,34 @@ void AP_OADatabase::init_database()
     _database.items = new OA_DbItem[_database.size];
 }
 
+void AP_OADatabase::init_grid()
+{
+    if (_database.items == nullptr) {
+        return;
+    }
+
+    // aim for a few items per bucket when the database is full
+    uint16_t num_buckets = AP_OADATABASE_GRID_BUCKETS_MIN;
+    while ((num_buckets < AP_OADATABASE_GRID_BUCKETS_MAX) && (num_buckets * 4 < _database.size)) {
+        num_buckets *= 2;
+    }
+
+    _grid.buckets = new GridBucket[num_buckets];
+    _grid.next = new uint16_t[_database.size];
+    if (_grid.buckets == nullptr || _grid.next == nullptr) {
+        delete[] _grid.buckets;
+        delete[] _grid.next;
+        _grid.buckets = nullptr;
+        _grid.next = nullptr;
+        return;
+    }
+
+    _grid.num_buckets = num_buckets;
+    for (uint16_t i=0; i<num_buckets; i++) {
+        _grid.buckets[i].head = _database.size;
+    }
+}
+
 // get bitmask of gcs channels item should be sent to based on its importance
 // returns 0xFF (send to all channels) if should be sent, 0 if it should not be sent
 uint8_t AP_OADatabase::get_send_to_gcs_flags(const OA_DbItemImportance importance)
@@ -261,17 +299,11 @@ bool AP_OADatabase::process_queue()
 
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (is_close_to_item_in_database(i, item)) {
-                database_item_refresh(i, item.timestamp_ms, item.radius);
-                found = true;
-                break;
-            }
-        }
-
-        if (!found) {
+        // compare item to nearby items in database. If found a similar item, update the existing, else add it as a new one
+        uint16_t index;
+        if (find_close_item_in_database(item, index)) {
+            database_item_refresh(index, item.timestamp_ms, item.radius);
+        } else {
             database_item_add(item);
         }
     }
@@ -285,6 +317,7 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     }
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    grid_insert(_database.count);
     _database.count++;
 }
 
@@ -295,19 +328,24 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         return;
     }
 
+    grid_remove(index);
+
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
 
     _database.count--;
     if (_database.count == 0) {
+        _grid.radius_max = 0;
         return;
     }
 
     if (index != _database.count) {
         // copy last object in array over expired object
+        grid_remove(_database.count);
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        grid_insert(index);
     }
 }
 
@@ -328,6 +366,11 @@ void AP_OADatabase::database_item_refresh(const uint16_t index, const uint32_t t
         _database.items[index].timestamp_ms = timestamp_ms;
         _database.items[index].radius = radius;
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+
+        // keep the spatial index's radius bounds valid
+        GridBucket &bucket = _grid.buckets[grid_bucket(_database.items[index].pos)];
+        bucket.radius_max = MAX(bucket.radius_max, radius);
+        _grid.radius_max = MAX(_grid.radius_max, radius);
     }
 }
 
@@ -365,6 +408,128 @@ bool AP_OADatabase::is_close_to_item_in_database(const uint16_t index, const OA_
     return ((distance_sq < sq(item.radius)) || (distance_sq < sq(_database.items[index].radius)));
 }
 
+// find a database item close to "item" using the spatial index, returns false if there is none
+bool AP_OADatabase::find_close_item_in_database(const OA_DbItem &item, uint16_t &index) const
+{
+    // items are close if within either item's radius so search all cells within the largest radius
+    const float range = MAX(item.radius, _grid.radius_max);
+    const int32_t x_min = floorf((item.pos.x - range) / AP_OADATABASE_GRID_CELL_SIZE);
+    const int32_t x_max = floorf((item.pos.x + range) / AP_OADATABASE_GRID_CELL_SIZE);
+    const int32_t y_min = floorf((item.pos.y - range) / AP_OADATABASE_GRID_CELL_SIZE);
+    const int32_t y_max = floorf((item.pos.y + range) / AP_OADATABASE_GRID_CELL_SIZE);
+    const uint32_t num_x = x_max - x_min + 1;
+    const uint32_t num_y = y_max - y_min + 1;
+
+    if ((num_x >= _grid.num_buckets) || (num_y >= _grid.num_buckets) || (num_x * num_y >= _grid.num_buckets)) {
+        // the search area covers more cells than there are buckets so check every item
+        for (uint16_t i=0; i<_database.count; i++) {
+            if (is_close_to_item_in_database(i, item)) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (int32_t x = x_min; x <= x_max; x++) {
+        for (int32_t y = y_min; y <= y_max; y++) {
+            const GridBucket &bucket = _grid.buckets[grid_bucket(x, y)];
+            for (uint16_t i = bucket.head; i != _database.size; i = _grid.next[i]) {
+                if (is_close_to_item_in_database(i, item)) {
+                    index = i;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// calculate the smallest margin between a line segment and the objects in the database
+// start and end are offsets in meters from the EKF origin, returns false if the database is empty
+bool AP_OADatabase::calc_margin_from_segment(const Vector3f &start, const Vector3f &end, float &margin) const
+{
+    if (!healthy() || (_database.count == 0)) {
+        return false;
+    }
+
+    // buckets are skipped if their bounds show they cannot beat the smallest margin found so far.
+    // Buckets near the segment are checked first so the smallest margin shrinks quickly
+    float smallest_margin = FLT_MAX;
+    for (uint8_t pass=0; pass<2; pass++) {
+        for (uint16_t b=0; b<_grid.num_buckets; b++) {
+            const GridBucket &bucket = _grid.buckets[b];
+            if (bucket.head == _database.size) {
+                continue;
+            }
+            // the horizontal distance to the bucket's bounds is never more than the distance to its items
+            const Vector2f centre = (bucket.pos_min + bucket.pos_max) * 0.5f;
+            const float bucket_margin = Vector2f::closest_distance_between_line_and_point(start.xy(), end.xy(), centre) -
+                                        (bucket.pos_max - bucket.pos_min).length() * 0.5f - bucket.radius_max;
+            const bool near = bucket_margin <= AP_OADATABASE_GRID_CELL_SIZE;
+            if ((near != (pass == 0)) || (bucket_margin >= smallest_margin)) {
+                continue;
+            }
+            for (uint16_t i = bucket.head; i != _database.size; i = _grid.next[i]) {
+                const OA_DbItem &item = _database.items[i];
+                // margin is distance between line segment and obstacle minus obstacle's radius
+                const float m = Vector3f::closest_distance_between_line_and_point(start, end, item.pos) - item.radius;
+                smallest_margin = MIN(smallest_margin, m);
+            }
+        }
+    }
+
+    margin = smallest_margin;
+    return true;
+}
+
+// return the spatial index bucket for a horizontal grid cell
+uint16_t AP_OADatabase::grid_bucket(int32_t cell_x, int32_t cell_y) const
+{
+    const uint32_t hash = ((uint32_t)cell_x * 73856093U) ^ ((uint32_t)cell_y * 19349663U);
+    return hash & (_grid.num_buckets - 1);
+}
+
+// return the spatial index bucket for a position
+uint16_t AP_OADatabase::grid_bucket(const Vector3f &pos) const
+{
+    return grid_bucket(floorf(pos.x / AP_OADATABASE_GRID_CELL_SIZE), floorf(pos.y / AP_OADATABASE_GRID_CELL_SIZE));
+}
+
+// add database item "index" to the spatial index
+void AP_OADatabase::grid_insert(const uint16_t index)
+{
+    const OA_DbItem &item = _database.items[index];
+    GridBucket &bucket = _grid.buckets[grid_bucket(item.pos)];
+    if (bucket.head == _database.size) {
+        // bucket was empty so reset its bounds
+        bucket.radius_max = 0;
+        bucket.pos_min = bucket.pos_max = item.pos.xy();
+    } else {
+        bucket.pos_min.x = MIN(bucket.pos_min.x, item.pos.x);
+        bucket.pos_min.y = MIN(bucket.pos_min.y, item.pos.y);
+        bucket.pos_max.x = MAX(bucket.pos_max.x, item.pos.x);
+        bucket.pos_max.y = MAX(bucket.pos_max.y, item.pos.y);
+    }
+    bucket.radius_max = MAX(bucket.radius_max, item.radius);
+    _grid.radius_max = MAX(_grid.radius_max, item.radius);
+
+    _grid.next[index] = bucket.head;
+    bucket.head = index;
+}
+
+// remove database item "index" from the spatial index
+void AP_OADatabase::grid_remove(const uint16_t index)
+{
+    GridBucket &bucket = _grid.buckets[grid_bucket(_database.items[index].pos)];
+    for (uint16_t *link = &bucket.head; *link != _database.size; link = &_grid.next[*link]) {
+        if (*link == index) {
+            *link = _grid.next[index];
+            return;
+        }
+    }
+}
+
 #if HAL_GCS_ENABLED
 // send ADSB_VEHICLE mavlink messages
 void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms)
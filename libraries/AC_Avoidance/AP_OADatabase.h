@@ -38,7 +38,7 @@ public:
     void queue_push(const Vector3f &pos, uint32_t timestamp_ms, float distance);
 
     // returns true if database is healthy
-    bool healthy() const { return (_queue.items != nullptr) && (_database.items != nullptr); }
+    bool healthy() const { return (_queue.items != nullptr) && (_database.items != nullptr) && (_grid.buckets != nullptr); }
 
     // fetch an item in database. Undefined result when i >= _database.count.
     const OA_DbItem& get_item(uint32_t i) const { return _database.items[i]; }
@@ -49,6 +49,11 @@ public:
     // empty queue and try and put into database. Return true if there's more work to do
     bool process_queue();
 
+    // calculate the smallest margin between a line segment and the objects in the database.  Margin is the distance
+    // from the segment to the edge of the object.  start and end are offsets in meters from the EKF origin
+    // returns false if the database is empty
+    bool calc_margin_from_segment(const Vector3f &start, const Vector3f &end, float &margin) const;
+
     // send ADSB_VEHICLE mavlink messages
     void send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms);
 
@@ -59,6 +64,7 @@ private:
     // initialise
     void init_queue();
     void init_database();
+    void init_grid();
 
     // database item management
     void database_item_add(const OA_DbItem &item);
@@ -73,6 +79,15 @@ private:
     // returns true if database item "index" is close to "item"
     bool is_close_to_item_in_database(const uint16_t index, const OA_DbItem &item) const;
 
+    // find a database item close to "item", returns false if there is none
+    bool find_close_item_in_database(const OA_DbItem &item, uint16_t &index) const;
+
+    // spatial index management
+    uint16_t grid_bucket(int32_t cell_x, int32_t cell_y) const;
+    uint16_t grid_bucket(const Vector3f &pos) const;
+    void grid_insert(const uint16_t index);
+    void grid_remove(const uint16_t index);
+
     // enum for use with _OUTPUT parameter
     enum class OutputLevel {
         NONE = 0,
@@ -104,6 +119,21 @@ private:
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
     } _database;
 
+    // spatial index of the database.  Items are hashed into buckets by their horizontal grid cell
+    // and each bucket holds a linked list of items along with bounds used to skip it in searches
+    struct GridBucket {
+        uint16_t        head;                               // index of first item in bucket, _database.size if empty
+        float           radius_max;                         // largest item radius since the bucket was last empty
+        Vector2f        pos_min;                            // horizontal bounds of items since the bucket was last empty
+        Vector2f        pos_max;
+    };
+    struct {
+        GridBucket      *buckets;                           // hash table of buckets
+        uint16_t        *next;                              // index of next item in the same bucket, parallel to _database.items
+        uint16_t        num_buckets;                        // number of buckets, always a power of two
+        float           radius_max;                         // largest item radius since the database was last empty
+    } _grid;
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
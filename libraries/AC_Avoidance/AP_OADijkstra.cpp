@@ -27,6 +27,8 @@
 #define OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK  32      // expanding arrays for fence points and paths to destination will grow in increments of 20 elements
 #define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        255     // index use to indicate we do not have a tentative short path for a node
 #define OA_DIJKSTRA_ERROR_REPORTING_INTERVAL_MS         5000    // failure messages sent to GCS every 5 seconds
+#define OA_DIJKSTRA_VISGRAPH_INDEX_ELEMENTS_PER_CHUNK   256     // expanding arrays indexing the fence visgraph grow in increments of 256 elements
+#define OA_DIJKSTRA_OPEN_HEAP_NOTSET                    UINT16_MAX  // open_heap_idx of nodes not in the open set
 
 /// Constructor
 AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
@@ -34,6 +36,8 @@ AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
         _inclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _fence_visgraph_adj(OA_DIJKSTRA_VISGRAPH_INDEX_ELEMENTS_PER_CHUNK),
+        _fence_visgraph_adj_start(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK)
 {
@@ -125,6 +129,8 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
 
     // create visgraph for all fence (with margin) points
     if (!_polyfence_visgraph_ok) {
+        // fence points have changed so the destination's visgraph must also be recreated
+        _destination_visgraph_ok = false;
         _polyfence_visgraph_ok = create_fence_visgraph(error_id);
         if (!_polyfence_visgraph_ok) {
             _shortest_path_ok = false;
@@ -715,6 +721,56 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
         }
     }
 
+    // index graph so the shortest path search does not need to scan the whole graph for each node
+    if (!index_fence_visgraph()) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+
+    return true;
+}
+
+// index the fence visibility graph by intermediate point so the items visible from a point can be found directly
+// returns true on success, false if out of memory
+bool AP_OADijkstra::index_fence_visgraph()
+{
+    // each item appears in the index once for each end
+    const uint16_t num_points = total_numpoints();
+    const uint32_t num_entries = _fence_visgraph.num_items() * 2U;
+    if ((num_entries > UINT16_MAX) ||
+        !_fence_visgraph_adj.expand_to_hold(num_entries) ||
+        !_fence_visgraph_adj_start.expand_to_hold(num_points + 1)) {
+        return false;
+    }
+
+    // count the items visible from each point, point i's count is held in the entry after its start
+    for (uint16_t i = 0; i <= num_points; i++) {
+        _fence_visgraph_adj_start[i] = 0;
+    }
+    for (uint16_t i = 0; i < _fence_visgraph.num_items(); i++) {
+        const AP_OAVisGraph::VisGraphItem &item = _fence_visgraph[i];
+        _fence_visgraph_adj_start[item.id1.id_num + 1]++;
+        _fence_visgraph_adj_start[item.id2.id_num + 1]++;
+    }
+
+    // convert counts to start positions
+    for (uint16_t i = 1; i <= num_points; i++) {
+        _fence_visgraph_adj_start[i] += _fence_visgraph_adj_start[i - 1];
+    }
+
+    // add items advancing each point's start as we go, so afterwards each start holds the next point's start
+    for (uint16_t i = 0; i < _fence_visgraph.num_items(); i++) {
+        const AP_OAVisGraph::VisGraphItem &item = _fence_visgraph[i];
+        _fence_visgraph_adj[_fence_visgraph_adj_start[item.id1.id_num]++] = i;
+        _fence_visgraph_adj[_fence_visgraph_adj_start[item.id2.id_num]++] = i;
+    }
+
+    // shift starts back into place
+    for (uint16_t i = num_points; i > 0; i--) {
+        _fence_visgraph_adj_start[i] = _fence_visgraph_adj_start[i - 1];
+    }
+    _fence_visgraph_adj_start[0] = 0;
+
     return true;
 }
 
@@ -761,38 +817,44 @@ void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
         return;
     }
 
-    // get current node for convenience
+    // only intermediate points are expanded, the source is handled separately and the search stops at the destination
     const ShortPathNode &curr_node = _short_path_data[curr_node_idx];
+    if (curr_node.id.id_type != AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT) {
+        return;
+    }
 
-    // for each visibility graph
-    const AP_OAVisGraph* visgraphs[] = {&_fence_visgraph, &_destination_visgraph};
-    for (uint8_t v=0; v<ARRAY_SIZE(visgraphs); v++) {
-
-        // skip if empty
-        const AP_OAVisGraph &curr_visgraph = *visgraphs[v];
-        if (curr_visgraph.num_items() == 0) {
-            continue;
-        }
-
-        // search visibility graph for items visible from current_node
-        for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
-            const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
-            // match if current node's id matches either of the id's in the graph (i.e. either end of the vector)
-            if ((curr_node.id == item.id1) || (curr_node.id == item.id2)) {
-                AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
-                // find item's id in node array
-                node_index item_node_idx;
-                if (find_node_from_id(matching_id, item_node_idx)) {
-                    // if current node's distance + distance to item is less than item's current distance, update item's distance
-                    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
-                    if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
-                        // update item's distance and set "distance_from_idx" to current node's index
-                        _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
-                        _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
-                    }
-                }
+    // update a node's distance and add it to the open set if the path via the current node is shorter
+    auto update_node = [this, curr_node_idx](node_index item_node_idx, float item_distance_cm) {
+        const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item_distance_cm;
+        ShortPathNode &item_node = _short_path_data[item_node_idx];
+        if (dist_to_item_via_current_node < item_node.distance_cm) {
+            // update item's distance and set "distance_from_idx" to current node's index
+            item_node.distance_cm = dist_to_item_via_current_node;
+            item_node.distance_from_idx = curr_node_idx;
+            if (!item_node.visited) {
+                open_heap_update(item_node_idx);
             }
         }
+    };
+
+    // fence points visible from current node
+    const uint8_t curr_point = curr_node.id.id_num;
+    for (uint16_t i = _fence_visgraph_adj_start[curr_point]; i < _fence_visgraph_adj_start[curr_point + 1]; i++) {
+        const AP_OAVisGraph::VisGraphItem &item = _fence_visgraph[_fence_visgraph_adj[i]];
+        const AP_OAVisGraph::OAItemID &matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
+        // find item's id in node array
+        node_index item_node_idx;
+        if (find_node_from_id(matching_id, item_node_idx)) {
+            update_node(item_node_idx, item.distance_cm);
+        }
+    }
+
+    // destination if visible from current node
+    if (curr_node.dest_distance_cm < FLT_MAX) {
+        node_index dest_node_idx;
+        if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION, 0}, dest_node_idx)) {
+            update_node(dest_node_idx, curr_node.dest_distance_cm);
+        }
     }
 }
 
@@ -828,45 +890,83 @@ bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_in
     return false;
 }
 
-// find index of node with lowest tentative distance (ignore visited nodes)
-// returns true if successful and node_idx argument is updated
-bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
+// returns true if node a should be searched before node b.  ties go to the lowest index
+bool AP_OADijkstra::open_heap_before(node_index a, node_index b) const
 {
-    node_index lowest_idx = 0;
-    float lowest_dist = FLT_MAX;
-
-    // scan through all nodes looking for closest
-    for (node_index i=0; i<_short_path_data_numpoints; i++) {
-        const ShortPathNode &node = _short_path_data[i];
-        if (node.visited || is_equal(_short_path_data[i].distance_cm, FLT_MAX)) {
-            // if node is already visited OR cannot be reached yet, we can't use it
-            continue;
-        }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
-            return false;
+    // heuristic is simple Euclidean distance from the node to the destination
+    // This should be admissible, therefore optimal path is guaranteed
+    const float dist_with_heuristics_a = _short_path_data[a].distance_cm + _short_path_data[a].heuristic_cm;
+    const float dist_with_heuristics_b = _short_path_data[b].distance_cm + _short_path_data[b].heuristic_cm;
+    if (dist_with_heuristics_a < dist_with_heuristics_b) {
+        return true;
+    }
+    if (dist_with_heuristics_b < dist_with_heuristics_a) {
+        return false;
+    }
+    return a < b;
+}
+
+// add a node to the open set or, if it is already in the open set, update its position after its distance was reduced
+void AP_OADijkstra::open_heap_update(node_index node_idx)
+{
+    uint16_t pos = _short_path_data[node_idx].open_heap_idx;
+    if (pos == OA_DIJKSTRA_OPEN_HEAP_NOTSET) {
+        if (_open_heap_numpoints >= ARRAY_SIZE(_open_heap)) {
+            // should never happen as each node is only added once
+            return;
         }
-        if (dist_with_heuristics < lowest_dist) {
-            // for NOW, this is the closest node
-            lowest_idx = i;
-            lowest_dist = dist_with_heuristics;
+        pos = _open_heap_numpoints++;
+    }
+
+    // move node towards top of heap until its parent should be searched first
+    while (pos > 0) {
+        const uint16_t parent = (pos - 1) / 2;
+        if (!open_heap_before(node_idx, _open_heap[parent])) {
+            break;
         }
+        _open_heap[pos] = _open_heap[parent];
+        _short_path_data[_open_heap[pos]].open_heap_idx = pos;
+        pos = parent;
     }
+    _open_heap[pos] = node_idx;
+    _short_path_data[node_idx].open_heap_idx = pos;
+}
 
-    if (lowest_dist < FLT_MAX) {
-        // found the closest node
-        node_idx = lowest_idx;
+// remove the node with lowest tentative distance plus heuristic from the open set
+// returns true if successful and node_idx argument is updated
+bool AP_OADijkstra::open_heap_pop(node_index &node_idx)
+{
+    if (_open_heap_numpoints == 0) {
+        return false;
+    }
+    node_idx = _open_heap[0];
+    _short_path_data[node_idx].open_heap_idx = OA_DIJKSTRA_OPEN_HEAP_NOTSET;
+
+    // move last node to the top and then down the heap until both children should be searched after it
+    _open_heap_numpoints--;
+    if (_open_heap_numpoints == 0) {
         return true;
     }
-    return false;
+    const node_index last = _open_heap[_open_heap_numpoints];
+    uint16_t pos = 0;
+    while (true) {
+        uint16_t child = pos * 2 + 1;
+        if (child >= _open_heap_numpoints) {
+            break;
+        }
+        if ((child + 1 < _open_heap_numpoints) && open_heap_before(_open_heap[child + 1], _open_heap[child])) {
+            child++;
+        }
+        if (!open_heap_before(_open_heap[child], last)) {
+            break;
+        }
+        _open_heap[pos] = _open_heap[child];
+        _short_path_data[_open_heap[pos]].open_heap_idx = pos;
+        pos = child;
+    }
+    _open_heap[pos] = last;
+    _short_path_data[last].open_heap_idx = pos;
+    return true;
 }
 
 // calculate shortest path from origin to destination
@@ -886,29 +986,58 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
-    if (!update_visgraph(_destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, _path_destination)) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-        return false;
+
+    // destination's visgraph can be reused if only the origin has changed
+    if (!_destination_visgraph_ok || (_path_destination != _destination_visgraph_pos)) {
+        _destination_visgraph_ok = update_visgraph(_destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, _path_destination);
+        if (!_destination_visgraph_ok) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        _destination_visgraph_pos = _path_destination;
     }
 
+    return find_shortest_path(err_id);
+}
+
+// search the visibility graphs for the shortest path from _path_source to _path_destination using A*
+// requires the fence, source and destination visgraphs to be up to date
+// returns true on success.  returns false on failure and err_id is updated
+bool AP_OADijkstra::find_shortest_path(AP_OADijkstra_Error &err_id)
+{
     // expand _short_path_data if necessary
     if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
 
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm, heuristic_cm, dest_distance_cm, open_heap_idx) to short_path_data array
+    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0, (_path_source - _path_destination).length(), FLT_MAX, OA_DIJKSTRA_OPEN_HEAP_NOTSET};
+    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, 0, FLT_MAX, OA_DIJKSTRA_OPEN_HEAP_NOTSET};
     _short_path_data_numpoints = 2;
 
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
+    // add all inclusion and exclusion fence points to short_path_data array
     for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+        Vector2f point;
+        if (!get_point(i, point)) {
+            // shouldn't happen
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
+            return false;
+        }
+        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, (point - _path_destination).length(), FLT_MAX, OA_DIJKSTRA_OPEN_HEAP_NOTSET};
+    }
+
+    // record which points can see the destination
+    for (uint16_t i = 0; i < _destination_visgraph.num_items(); i++) {
+        node_index node_idx;
+        if (find_node_from_id(_destination_visgraph[i].id2, node_idx)) {
+            _short_path_data[node_idx].dest_distance_cm = _destination_visgraph[i].distance_cm;
+        }
     }
 
     // start algorithm from source point
     node_index current_node_idx = 0;
+    _open_heap_numpoints = 0;
 
     // update nodes visible from source point
     for (uint16_t i = 0; i < _source_visgraph.num_items(); i++) {
@@ -916,6 +1045,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         if (find_node_from_id(_source_visgraph[i].id2, node_idx)) {
             _short_path_data[node_idx].distance_cm = _source_visgraph[i].distance_cm;
             _short_path_data[node_idx].distance_from_idx = current_node_idx;
+            open_heap_update(node_idx);
         } else {
             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
             return false;
@@ -925,7 +1055,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
     _short_path_data[current_node_idx].visited = true;
 
     // move current_node_idx to node with lowest distance
-    while (find_closest_node_idx(current_node_idx)) {
+    while (open_heap_pop(current_node_idx)) {
         node_index dest_node;
         // See if this next "closest" node is actually the destination
         if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, dest_node) && current_node_idx == dest_node) {
@@ -11,6 +11,9 @@
  */
 
 class AP_OADijkstra {
+    // benchmark example sets up fences directly rather than through AC_Fence
+    friend class AP_OADijkstra_Bench;
+
 public:
 
     AP_OADijkstra(AP_Int16 &options);
@@ -119,12 +122,21 @@ private:
     // returns true on success.  returns false on failure and err_id is updated
     bool create_fence_visgraph(AP_OADijkstra_Error &err_id);
 
+    // index the fence visibility graph by intermediate point so the items visible from a point can be found directly
+    // returns true on success, false if out of memory
+    bool index_fence_visgraph();
+
     // calculate shortest path from origin to destination
     // returns true on success.  returns false on failure and err_id is updated
     // requires create_polygon_fence_with_margin and create_polygon_fence_visgraph to have been run
     // resulting path is stored in _shortest_path array as vector offsets from EKF origin
     bool calc_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id);
 
+    // search the visibility graphs for the shortest path from _path_source to _path_destination using A*
+    // requires the fence, source and destination visgraphs to be up to date
+    // returns true on success.  returns false on failure and err_id is updated
+    bool find_shortest_path(AP_OADijkstra_Error &err_id);
+
     // shortest path state variables
     bool _inclusion_polygon_with_margin_ok;
     bool _exclusion_polygon_with_margin_ok;
@@ -157,6 +169,13 @@ private:
     AP_OAVisGraph _fence_visgraph;          // holds distances between all inclusion/exclusion fence points (with margin)
     AP_OAVisGraph _source_visgraph;         // holds distances from source point to all other nodes
     AP_OAVisGraph _destination_visgraph;    // holds distances from the destination to all other nodes
+    bool _destination_visgraph_ok;          // true if _destination_visgraph is valid for _destination_visgraph_pos and the current fence
+    Vector2f _destination_visgraph_pos;     // destination used to create _destination_visgraph (offset in cm from EKF origin)
+
+    // fence visgraph index. items visible from intermediate point i are found at
+    // _fence_visgraph_adj[_fence_visgraph_adj_start[i]] up to (but not including) _fence_visgraph_adj[_fence_visgraph_adj_start[i+1]]
+    AP_ExpandingArray<uint16_t> _fence_visgraph_adj;        // indexes into _fence_visgraph grouped by intermediate point
+    AP_ExpandingArray<uint16_t> _fence_visgraph_adj_start;  // index of each intermediate point's first entry in _fence_visgraph_adj
 
     // updates visibility graph for a given position which is an offset (in cm) from the ekf origin
     // to add an additional position (i.e. the destination) set add_extra_position = true and provide the position in the extra_position argument
@@ -170,6 +189,9 @@ private:
         bool visited;                   // true if all this node's neighbour's distances have been updated
         node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
         float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
+        float heuristic_cm;             // straight line distance to the destination
+        float dest_distance_cm;         // distance to the destination if visible, FLT_MAX if not
+        uint16_t open_heap_idx;         // position in _open_heap or OA_DIJKSTRA_OPEN_HEAP_NOTSET if not in the open set
     };
     AP_ExpandingArray<ShortPathNode> _short_path_data;
     node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
@@ -182,9 +204,19 @@ private:
     // returns true if successful and node_idx is updated
     bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
 
-    // find index of node with lowest tentative distance (ignore visited nodes)
+    // open set of nodes with tentative distances held as a binary heap ordered by distance plus heuristic
+    node_index _open_heap[UINT8_MAX + 1];
+    uint16_t _open_heap_numpoints;
+
+    // returns true if node a should be searched before node b.  ties go to the lowest index
+    bool open_heap_before(node_index a, node_index b) const;
+
+    // add a node to the open set or, if it is already in the open set, update its position after its distance was reduced
+    void open_heap_update(node_index node_idx);
+
+    // remove the node with lowest tentative distance plus heuristic from the open set
     // returns true if successful and node_idx argument is updated
-    bool find_closest_node_idx(node_index &node_idx) const;
+    bool open_heap_pop(node_index &node_idx);
 
     // final path variables and functions
     AP_ExpandingArray<AP_OAVisGraph::OAItemID> _path;   // ids of points on return path in reverse order (i.e. destination is first element)
@@ -24,6 +24,7 @@
 // @Field: OLt: Intermediate location chosen for avoidance
 // @Field: OLg: Intermediate location chosen for avoidance
 // @Field: OAlt: Intermediate alt chosen for avoidance above EKF origin
+// @Field: PTime: Time taken by the planner to choose this path
 struct PACKED log_OABendyRuler {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -40,6 +41,7 @@ struct PACKED log_OABendyRuler {
     int32_t oa_lat;
     int32_t oa_lng;
     int32_t oa_alt;
+    uint32_t latency_us;
 };
 
 // @LoggerMessage: OADJ
@@ -108,7 +110,7 @@ struct PACKED log_OD_Visgraph {
 
 #define LOG_STRUCTURE_FROM_AVOIDANCE \
     { LOG_OA_BENDYRULER_MSG, sizeof(log_OABendyRuler), \
-      "OABR","QBBHHHBfLLiLLi","TimeUS,Type,Act,DYaw,Yaw,DP,RChg,Mar,DLt,DLg,DAlt,OLt,OLg,OAlt", "s--ddd-mDUmDUm", "F-------GGBGGB" , true }, \
+      "OABR","QBBHHHBfLLiLLiI","TimeUS,Type,Act,DYaw,Yaw,DP,RChg,Mar,DLt,DLg,DAlt,OLt,OLg,OAlt,PTime", "s--ddd-mDUmDUms", "F-------GGBGGBF" , true }, \
     { LOG_OA_DIJKSTRA_MSG, sizeof(log_OADijkstra), \
       "OADJ","QBBBBLLLL","TimeUS,State,Err,CurrPoint,TotPoints,DLat,DLng,OALat,OALng", "s----DUDU", "F----GGGG" , true }, \
     { LOG_SIMPLE_AVOID_MSG, sizeof(log_SimpleAvoid), \
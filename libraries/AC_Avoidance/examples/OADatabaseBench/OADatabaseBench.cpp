@@ -0,0 +1,136 @@
+/*
+  Benchmark of the object avoidance database with a dense obstacle field
+
+  Fills the database with lidar-like returns from a field of walls and posts, then
+  times BendyRuler style margin queries against the spatial index and checks them
+  against a search of every item.
+
+  on SITL run with
+    ./waf configure --board sitl
+    ./waf build --targets examples/OADatabaseBench
+    ./build/sitl/examples/OADatabaseBench
+*/
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AC_Avoidance/AP_OADatabase.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static AP_OADatabase oadb;
+
+#define DATABASE_SIZE       5000
+#define QUEUE_SIZE          200
+#define FIELD_SIZE_M        200.0f
+#define NUM_RETURNS         20000
+#define NUM_BEARINGS        72
+#define LOOKAHEAD_M         15.0f
+
+// margin from a segment by checking every item in the database
+static bool calc_margin_linear(const Vector3f &start, const Vector3f &end, float &margin)
+{
+    float smallest_margin = FLT_MAX;
+    for (uint16_t i=0; i<oadb.database_count(); i++) {
+        const AP_OADatabase::OA_DbItem &item = oadb.get_item(i);
+        const float m = Vector3f::closest_distance_between_line_and_point(start, end, item.pos) - item.radius;
+        smallest_margin = MIN(smallest_margin, m);
+    }
+    if (smallest_margin < FLT_MAX) {
+        margin = smallest_margin;
+        return true;
+    }
+    return false;
+}
+
+// lidar return from a random point on one of the walls or posts of the field
+static Vector3f random_return()
+{
+    const uint8_t obstacle = get_random16() % 40;
+    const float t = rand_float();
+    // odd obstacles are walls running north or east, even are small posts
+    Vector3f pos { (obstacle % 8) * FIELD_SIZE_M / 8.0f - FIELD_SIZE_M * 0.5f,
+                   (obstacle / 8) * FIELD_SIZE_M / 5.0f - FIELD_SIZE_M * 0.5f,
+                   rand_float() * 2.0f };
+    if (obstacle & 1) {
+        if (obstacle & 2) {
+            pos.x += t * 10.0f;
+        } else {
+            pos.y += t * 10.0f;
+        }
+    } else {
+        pos.x += t * 0.5f;
+        pos.y += rand_float() * 0.5f;
+    }
+    return pos;
+}
+
+void setup()
+{
+    AP_Param::set_object_value(&oadb, AP_OADatabase::var_info, "SIZE", DATABASE_SIZE);
+    AP_Param::set_object_value(&oadb, AP_OADatabase::var_info, "QUEUE_SIZE", QUEUE_SIZE);
+    AP_Param::set_object_value(&oadb, AP_OADatabase::var_info, "EXPIRE", 0);
+    oadb.init();
+    if (!oadb.healthy()) {
+        ::printf("Database init failed\n");
+        exit(1);
+    }
+
+    // fill the database
+    uint64_t start_us = AP_HAL::micros64();
+    for (uint32_t i=0; i<NUM_RETURNS; i += QUEUE_SIZE) {
+        for (uint16_t j=0; j<QUEUE_SIZE; j++) {
+            oadb.queue_push(random_return(), AP_HAL::millis(), 1.0f + fabsf(rand_float()) * 20.0f);
+        }
+        while (oadb.process_queue()) {}
+    }
+    ::printf("Processed %u returns into %u items in %.1fms\n",
+             (unsigned)NUM_RETURNS, (unsigned)oadb.database_count(), (AP_HAL::micros64() - start_us) * 0.001f);
+
+    // BendyRuler style queries from vehicle positions across the field
+    uint32_t indexed_us = 0;
+    uint32_t linear_us = 0;
+    uint32_t mismatches = 0;
+    uint32_t queries = 0;
+    for (float x = -FIELD_SIZE_M * 0.5f; x < FIELD_SIZE_M * 0.5f; x += FIELD_SIZE_M / 10.0f) {
+        for (float y = -FIELD_SIZE_M * 0.5f; y < FIELD_SIZE_M * 0.5f; y += FIELD_SIZE_M / 10.0f) {
+            const Vector3f vehicle { x, y, 1.0f };
+            for (uint16_t b=0; b<NUM_BEARINGS; b++) {
+                const float bearing = radians(b * 360.0f / NUM_BEARINGS);
+                const Vector3f end = vehicle + Vector3f(cosf(bearing), sinf(bearing), 0.0f) * LOOKAHEAD_M;
+
+                float margin_indexed = 0, margin_linear = 0;
+                start_us = AP_HAL::micros64();
+                const bool ok_indexed = oadb.calc_margin_from_segment(vehicle, end, margin_indexed);
+                indexed_us += AP_HAL::micros64() - start_us;
+
+                start_us = AP_HAL::micros64();
+                const bool ok_linear = calc_margin_linear(vehicle, end, margin_linear);
+                linear_us += AP_HAL::micros64() - start_us;
+
+                if (ok_indexed != ok_linear || !is_equal(margin_indexed, margin_linear)) {
+                    mismatches++;
+                }
+                queries++;
+            }
+        }
+    }
+    ::printf("%u margin queries: indexed %.1fms, linear %.1fms, %u mismatches\n",
+             (unsigned)queries, indexed_us * 0.001f, linear_us * 0.001f, (unsigned)mismatches);
+
+    exit(mismatches == 0 ? 0 : 1);
+}
+
+void loop()
+{
+}
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+AP_HAL_MAIN();
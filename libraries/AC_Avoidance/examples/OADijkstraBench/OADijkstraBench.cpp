@@ -0,0 +1,309 @@
+/*
+  Benchmark of Dijkstra's path planner on a large synthetic fence
+
+  Builds an inclusion polygon with many points containing a grid of
+  exclusion polygons, then times shortest path searches between random
+  points and checks the path lengths against a simple search that scans
+  every node and every visibility graph item at each step.
+
+  on SITL run with
+    ./waf configure --board sitl
+    ./waf build --targets examples/OADijkstraBench
+    ./build/sitl/examples/OADijkstraBench
+*/
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AC_Avoidance/AP_OADijkstra.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define INCLUSION_POINTS        64      // points in the inclusion polygon
+#define INCLUSION_RADIUS_CM     100000  // radius of the inclusion polygon
+#define EXCLUSION_GRID          5       // exclusion polygons are placed on a grid this many wide
+#define EXCLUSION_POINTS        7       // points in each exclusion polygon
+#define EXCLUSION_RADIUS_CM     6000    // radius of each exclusion polygon
+#define MARGIN_CM               500     // fence margin
+#define NUM_QUERIES             200
+
+static const uint16_t num_exclusion_polygons = EXCLUSION_GRID * EXCLUSION_GRID;
+static Vector2f inclusion_polygon[INCLUSION_POINTS];
+static Vector2f exclusion_polygons[num_exclusion_polygons][EXCLUSION_POINTS];
+
+static AP_Int16 options;
+static AP_OADijkstra dijkstra(options);
+
+// points on a regular polygon
+static void fill_polygon(Vector2f *points, uint8_t num_points, const Vector2f &center, float radius)
+{
+    for (uint8_t i = 0; i < num_points; i++) {
+        const float angle = M_2PI * i / num_points;
+        points[i] = center + Vector2f(cosf(angle), sinf(angle)) * radius;
+    }
+}
+
+// returns true if segment crosses the fence
+static bool intersects_fence(const Vector2f &start, const Vector2f &end)
+{
+    Vector2f intersection;
+    if (Polygon_intersects(inclusion_polygon, INCLUSION_POINTS, start, end, intersection)) {
+        return true;
+    }
+    for (uint16_t i = 0; i < num_exclusion_polygons; i++) {
+        if (Polygon_intersects(exclusion_polygons[i], EXCLUSION_POINTS, start, end, intersection)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// returns true if point is inside the inclusion polygon and outside all exclusion polygons
+static bool inside_fence(const Vector2f &point)
+{
+    if (Polygon_outside(point, inclusion_polygon, INCLUSION_POINTS)) {
+        return false;
+    }
+    for (uint16_t i = 0; i < num_exclusion_polygons; i++) {
+        if (!Polygon_outside(point, exclusion_polygons[i], EXCLUSION_POINTS)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class AP_OADijkstra_Bench {
+public:
+    // set up fence points with margin and the fence visibility graph
+    static bool create_fence()
+    {
+        // scale so lines between margin points do not cut the polygons' corners
+        const float inclusion_scale = cosf(M_PI / INCLUSION_POINTS);
+        const float exclusion_scale = 1.0f / cosf(M_PI / EXCLUSION_POINTS);
+
+        fill_polygon(inclusion_polygon, INCLUSION_POINTS, Vector2f(), INCLUSION_RADIUS_CM);
+        if (!dijkstra._inclusion_polygon_pts.expand_to_hold(INCLUSION_POINTS)) {
+            return false;
+        }
+        Vector2f points[INCLUSION_POINTS];
+        fill_polygon(points, INCLUSION_POINTS, Vector2f(), (INCLUSION_RADIUS_CM - MARGIN_CM) * inclusion_scale);
+        for (uint8_t i = 0; i < INCLUSION_POINTS; i++) {
+            dijkstra._inclusion_polygon_pts[i] = points[i];
+        }
+        dijkstra._inclusion_polygon_numpoints = INCLUSION_POINTS;
+
+        if (!dijkstra._exclusion_polygon_pts.expand_to_hold(num_exclusion_polygons * EXCLUSION_POINTS)) {
+            return false;
+        }
+        dijkstra._exclusion_polygon_numpoints = 0;
+        const float spacing = INCLUSION_RADIUS_CM * 1.2f / EXCLUSION_GRID;
+        for (uint16_t i = 0; i < num_exclusion_polygons; i++) {
+            const Vector2f center { ((i % EXCLUSION_GRID) - (EXCLUSION_GRID - 1) * 0.5f) * spacing,
+                                    ((i / EXCLUSION_GRID) - (EXCLUSION_GRID - 1) * 0.5f) * spacing };
+            fill_polygon(exclusion_polygons[i], EXCLUSION_POINTS, center, EXCLUSION_RADIUS_CM);
+            fill_polygon(points, EXCLUSION_POINTS, center, (EXCLUSION_RADIUS_CM + MARGIN_CM) * exclusion_scale);
+            for (uint8_t j = 0; j < EXCLUSION_POINTS; j++) {
+                dijkstra._exclusion_polygon_pts[dijkstra._exclusion_polygon_numpoints++] = points[j];
+            }
+        }
+        dijkstra._exclusion_circle_numpoints = 0;
+
+        // same as create_fence_visgraph but against the synthetic fence
+        dijkstra._fence_visgraph.clear();
+        const uint16_t num_points = dijkstra.total_numpoints();
+        for (uint8_t i = 0; i < num_points - 1; i++) {
+            Vector2f start_seg;
+            if (!dijkstra.get_point(i, start_seg)) {
+                return false;
+            }
+            for (uint8_t j = i + 1; j < num_points; j++) {
+                Vector2f end_seg;
+                if (!dijkstra.get_point(j, end_seg)) {
+                    return false;
+                }
+                if (!intersects_fence(start_seg, end_seg)) {
+                    if (!dijkstra._fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i},
+                                                           {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
+                                                           (start_seg - end_seg).length())) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return dijkstra.index_fence_visgraph();
+    }
+
+    // same as update_visgraph but against the synthetic fence
+    static bool update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph::OAItemID& oaid, const Vector2f &position, bool add_extra_position = false, Vector2f extra_position = Vector2f(0,0))
+    {
+        visgraph.clear();
+        for (uint8_t i = 0; i < dijkstra.total_numpoints(); i++) {
+            Vector2f seg_end;
+            if (dijkstra.get_point(i, seg_end) && !intersects_fence(position, seg_end)) {
+                if (!visgraph.add_item(oaid, {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, (position - seg_end).length())) {
+                    return false;
+                }
+            }
+        }
+        if (add_extra_position && !intersects_fence(position, extra_position)) {
+            if (!visgraph.add_item(oaid, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, (position - extra_position).length())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // search for the shortest path, returns path length or -1 on failure
+    static float find_shortest_path(const Vector2f &source, const Vector2f &destination, bool update_destination)
+    {
+        dijkstra._path_source = source;
+        dijkstra._path_destination = destination;
+        if (!update_visgraph(dijkstra._source_visgraph, {AP_OAVisGraph::OATYPE_SOURCE, 0}, source, true, destination)) {
+            return -1;
+        }
+        if (update_destination &&
+            !update_visgraph(dijkstra._destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, destination)) {
+            return -1;
+        }
+        AP_OADijkstra::AP_OADijkstra_Error err_id;
+        if (!dijkstra.find_shortest_path(err_id)) {
+            return -1;
+        }
+        return dijkstra._short_path_data[1].distance_cm;
+    }
+
+    // search scanning all nodes for the closest and all graph items for neighbours at each step
+    // requires find_shortest_path to have been run for the same source and destination
+    static float find_shortest_path_scan()
+    {
+        const uint16_t num_nodes = dijkstra.total_numpoints() + 2;
+        float distance[UINT8_MAX + 1];
+        float heuristic[UINT8_MAX + 1];
+        bool visited[UINT8_MAX + 1];
+        if (num_nodes > ARRAY_SIZE(distance)) {
+            return -1;
+        }
+        for (uint16_t i = 0; i < num_nodes; i++) {
+            distance[i] = FLT_MAX;
+            visited[i] = false;
+            Vector2f pos;
+            if (i == 0) {
+                pos = dijkstra._path_source;
+            } else if (i == 1) {
+                pos = dijkstra._path_destination;
+            } else if (!dijkstra.get_point(i - 2, pos)) {
+                return -1;
+            }
+            heuristic[i] = (pos - dijkstra._path_destination).length();
+        }
+        // source is node 0, destination node 1 and intermediate points follow
+        auto node_of = [](const AP_OAVisGraph::OAItemID &id) -> uint16_t {
+            return (id.id_type == AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT) ? id.id_num + 2 : (uint16_t)id.id_type;
+        };
+
+        visited[0] = true;
+        for (uint16_t i = 0; i < dijkstra._source_visgraph.num_items(); i++) {
+            distance[node_of(dijkstra._source_visgraph[i].id2)] = dijkstra._source_visgraph[i].distance_cm;
+        }
+        while (true) {
+            uint16_t current = 0;
+            float lowest = FLT_MAX;
+            for (uint16_t i = 0; i < num_nodes; i++) {
+                if (!visited[i] && (distance[i] < FLT_MAX) && (distance[i] + heuristic[i] < lowest)) {
+                    current = i;
+                    lowest = distance[i] + heuristic[i];
+                }
+            }
+            if ((lowest >= FLT_MAX) || (current == 1)) {
+                break;
+            }
+            const AP_OAVisGraph* visgraphs[] = {&dijkstra._fence_visgraph, &dijkstra._destination_visgraph};
+            for (const AP_OAVisGraph *visgraph : visgraphs) {
+                for (uint16_t i = 0; i < visgraph->num_items(); i++) {
+                    const AP_OAVisGraph::VisGraphItem &item = (*visgraph)[i];
+                    const uint16_t id1 = node_of(item.id1);
+                    const uint16_t id2 = node_of(item.id2);
+                    if ((id1 == current) || (id2 == current)) {
+                        const uint16_t other = (id1 == current) ? id2 : id1;
+                        distance[other] = MIN(distance[other], distance[current] + item.distance_cm);
+                    }
+                }
+            }
+            visited[current] = true;
+        }
+        return (distance[1] < FLT_MAX) ? distance[1] : -1;
+    }
+};
+
+// random point within the fence
+static Vector2f random_point()
+{
+    while (true) {
+        const Vector2f point { rand_float() * INCLUSION_RADIUS_CM, rand_float() * INCLUSION_RADIUS_CM };
+        if (inside_fence(point)) {
+            return point;
+        }
+    }
+}
+
+void setup()
+{
+    uint64_t start_us = AP_HAL::micros64();
+    if (!AP_OADijkstra_Bench::create_fence()) {
+        ::printf("Failed to create fence\n");
+        exit(1);
+    }
+    ::printf("Fence with %u points and %u visible pairs created in %.1fms\n",
+             (unsigned)dijkstra.total_numpoints(), (unsigned)dijkstra._fence_visgraph.num_items(),
+             (AP_HAL::micros64() - start_us) * 0.001f);
+
+    uint32_t search_us = 0;
+    uint32_t replan_us = 0;
+    uint32_t scan_us = 0;
+    uint32_t mismatches = 0;
+    uint32_t failures = 0;
+    for (uint16_t i = 0; i < NUM_QUERIES; i++) {
+        const Vector2f source = random_point();
+        const Vector2f destination = random_point();
+
+        // new destination
+        start_us = AP_HAL::micros64();
+        const float length = AP_OADijkstra_Bench::find_shortest_path(source, destination, true);
+        search_us += AP_HAL::micros64() - start_us;
+
+        // vehicle has moved towards the same destination
+        const Vector2f moved = source + (destination - source) * 0.01f;
+        start_us = AP_HAL::micros64();
+        const float length_moved = AP_OADijkstra_Bench::find_shortest_path(moved, destination, false);
+        replan_us += AP_HAL::micros64() - start_us;
+
+        start_us = AP_HAL::micros64();
+        const float length_scan = AP_OADijkstra_Bench::find_shortest_path_scan();
+        scan_us += AP_HAL::micros64() - start_us;
+
+        if ((length < 0) || (length_moved < 0)) {
+            failures++;
+        } else if (fabsf(length_moved - length_scan) > 1.0f) {
+            mismatches++;
+        }
+    }
+    ::printf("%u paths: new destination %.2fms, replan %.2fms, search scanning all nodes %.2fms per path, %u failures, %u mismatches\n",
+             (unsigned)NUM_QUERIES, search_us * 0.001f / NUM_QUERIES, replan_us * 0.001f / NUM_QUERIES,
+             scan_us * 0.001f / NUM_QUERIES, (unsigned)failures, (unsigned)mismatches);
+
+    exit((failures == 0 && mismatches == 0) ? 0 : 1);
+}
+
+void loop()
+{
+}
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+AP_HAL_MAIN();
@@ -241,7 +241,7 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     // check we are inside each inclusion zone:
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (boundary.index_lla.outside(pos)) {
             num_inclusion_outside++;
         }
     }
@@ -249,7 +249,7 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     // check we are outside each exclusion zone:
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (!boundary.index_lla.outside(pos)) {
             return true;
         }
     }
@@ -733,6 +733,9 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
+            // failing to build the indexes only makes checks slower
+            boundary.index.init(boundary.points, boundary.count);
+            boundary.index_lla.init(boundary.points_lla, boundary.count);
             _num_loaded_inclusion_boundaries++;
             break;
         }
@@ -752,6 +755,9 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
+            // failing to build the indexes only makes checks slower
+            boundary.index.init(boundary.points, boundary.count);
+            boundary.index_lla.init(boundary.points_lla, boundary.count);
             _num_loaded_exclusion_boundaries++;
             break;
         }
@@ -865,6 +871,15 @@ Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+/// returns the edge index of an exclusion polygon's points, nullptr if there is no such polygon
+const PolygonIndex<float>* AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const
+{
+    if (index >= _num_loaded_exclusion_boundaries) {
+        return nullptr;
+    }
+    return &_loaded_exclusion_boundary[index].index;
+}
+
 /// returns pointer to array of inclusion polygon points and num_points is filled in with the number of points in the polygon
 /// points are offsets in cm from EKF origin in NE frame
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const
@@ -879,6 +894,15 @@ Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+/// returns the edge index of an inclusion polygon's points, nullptr if there is no such polygon
+const PolygonIndex<float>* AC_PolyFence_loader::get_inclusion_polygon_index(uint16_t index) const
+{
+    if (index >= _num_loaded_inclusion_boundaries) {
+        return nullptr;
+    }
+    return &_loaded_inclusion_boundary[index].index;
+}
+
 /// returns the specified exclusion circle
 /// circle center offsets in cm from EKF origin in NE frame, radius is in meters
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const
@@ -1042,6 +1066,14 @@ uint16_t AC_PolyFence_loader::fence_storage_space_required(const AC_PolyFenceIte
     return ret;
 }
 
+// append a value to a fence storage image, in the same byte order as the StorageAccess write_* methods
+template <typename T>
+static void image_put(uint8_t *image, uint16_t &offset, const T value)
+{
+    memcpy(&image[offset], &value, sizeof(value));
+    offset += sizeof(value);
+}
+
 bool AC_PolyFence_loader::write_fence(const AC_PolyFenceItem *new_items, uint16_t count)
 {
     if (!validate_fence(new_items, count)) {
@@ -1049,17 +1081,27 @@ bool AC_PolyFence_loader::write_fence(const AC_PolyFenceItem *new_items, uint16_
         return false;
     }
 
-    if (fence_storage_space_required(new_items, count) > fence_storage.size()) {
+    // space for the items plus the end-of-storage marker
+    const uint16_t image_size = fence_storage_space_required(new_items, count) + 1;
+    if (image_size > fence_storage.size()) {
         gcs().send_text(MAV_SEVERITY_WARNING, "Fence exceeds storage size");
         return false;
     }
 
-    if (!format()) {
+    // the new fence is built in memory and replaces the old one in a
+    // single storage write rather than one write per field
+    uint8_t *image = new uint8_t[image_size];
+    if (image == nullptr) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "Out of memory for fence");
         return false;
     }
 
+    // format header, as written by format()
+    uint16_t offset = 0;
+    image_put(image, offset, uint32_t(0));
+    image[0] = new_fence_storage_magic;
+
     uint8_t total_vertex_count = 0;
-    uint16_t offset = 4; // skipping magic
     uint8_t vertex_count = 0;
     for (uint16_t i=0; i<count; i++) {
         const AC_PolyFenceItem new_item = new_items[i];
@@ -1070,26 +1112,24 @@ bool AC_PolyFence_loader::write_fence(const AC_PolyFenceItem *new_items, uint16_
                 // write out new polygon count
                 vertex_count = new_item.vertex_count;
                 total_vertex_count += vertex_count;
-                if (!write_type_to_storage(offset, new_item.type)) {
-                    return false;
-                }
-                fence_storage.write_uint8(offset, vertex_count);
-                offset++;
+                image_put(image, offset, uint8_t(new_item.type));
+                image_put(image, offset, vertex_count);
             }
             vertex_count--;
-            if (!write_latlon_to_storage(offset, new_item.loc)) {
-                return false;
-            }
+            image_put(image, offset, new_item.loc.x);
+            image_put(image, offset, new_item.loc.y);
             break;
         case AC_PolyFenceType::END_OF_STORAGE:
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
             AP_HAL::panic("asked to store end-of-storage marker");
 #endif
+            delete[] image;
             return false;
         case AC_PolyFenceType::CIRCLE_INCLUSION_INT:
         case AC_PolyFenceType::CIRCLE_EXCLUSION_INT:
             // should never have AC_PolyFenceItems of these types
             INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+            delete[] image;
             return false;
         case AC_PolyFenceType::CIRCLE_INCLUSION:
         case AC_PolyFenceType::CIRCLE_EXCLUSION: {
@@ -1104,36 +1144,43 @@ bool AC_PolyFence_loader::write_fence(const AC_PolyFenceItem *new_items, uint16_
                 }
             }
 
-            if (!write_type_to_storage(offset, store_type)) {
-                return false;
-            }
-            if (!write_latlon_to_storage(offset, new_item.loc)) {
-                return false;
-            }
+            image_put(image, offset, uint8_t(store_type));
+            image_put(image, offset, new_item.loc.x);
+            image_put(image, offset, new_item.loc.y);
             // store the radius.  If the radius is very close to an
             // integer then we store it as an integer so users moving
             // from 4.1 back to 4.0 might be less-disrupted.
             if (store_as_int) {
-                fence_storage.write_uint32(offset, new_item.radius);
+                image_put(image, offset, uint32_t(new_item.radius));
             } else {
-                fence_storage.write_float(offset, new_item.radius);
+                image_put(image, offset, float(new_item.radius));
             }
-            offset += 4;
             break;
         }
         case AC_PolyFenceType::RETURN_POINT:
-            if (!write_type_to_storage(offset, new_item.type)) {
-                return false;
-            }
-            if (!write_latlon_to_storage(offset, new_item.loc)) {
-                return false;
-            }
+            image_put(image, offset, uint8_t(new_item.type));
+            image_put(image, offset, new_item.loc.x);
+            image_put(image, offset, new_item.loc.y);
             break;
         }
     }
-    if (!write_eos_to_storage(offset)) {
+    image_put(image, offset, uint8_t(AC_PolyFenceType::END_OF_STORAGE));
+
+    if (offset != image_size) {
+        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        delete[] image;
+        return false;
+    }
+
+    void_index();
+    _eeprom_fence_count = 0;
+    _eeprom_item_count = 0;
+    const bool written = fence_storage.write_block(0, image, image_size);
+    delete[] image;
+    if (!written) {
         return false;
     }
+    _eos_offset = image_size - 1;
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     // sanity-check the EEPROM in SITL to make sure we can read what
@@ -1648,6 +1695,8 @@ bool AC_PolyFence_loader::get_item(const uint16_t seq, AC_PolyFenceItem &item) {
 
 Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
+const PolygonIndex<float>* AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const { return nullptr; }
+const PolygonIndex<float>* AC_PolyFence_loader::get_inclusion_polygon_index(uint16_t index) const { return nullptr; }
 
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
 bool AC_PolyFence_loader::get_inclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
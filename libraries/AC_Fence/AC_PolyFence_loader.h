@@ -70,6 +70,9 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_exclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the edge index of an exclusion polygon's points, nullptr if there is no such polygon
+    const PolygonIndex<float>* get_exclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the exclusion polygon points
     uint32_t get_exclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -87,6 +90,9 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_inclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the edge index of an inclusion polygon's points, nullptr if there is no such polygon
+    const PolygonIndex<float>* get_inclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the inclusion polygon points
     uint32_t get_inclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -287,6 +293,8 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+        PolygonIndex<float> index; // edge index of points
+        PolygonIndex<int32_t> index_lla; // edge index of points_lla
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -297,6 +305,8 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+        PolygonIndex<float> index; // edge index of points
+        PolygonIndex<int32_t> index_lla; // edge index of points_lla
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
@@ -67,6 +67,7 @@ void AP_AHRS_View::update()
         rot_body_to_ned = rot_body_to_ned * rot_view_T;
         gyro = rot_view * gyro;
     }
+    _quat_valid = false;
 
     rot_body_to_ned.to_euler(&roll, &pitch, &yaw);
 
@@ -82,6 +83,16 @@ void AP_AHRS_View::update()
                    trig.sin_roll, trig.sin_pitch, trig.sin_yaw);
 }
 
+// return a Quaternion representing our current attitude in this view
+void AP_AHRS_View::get_quat_body_to_ned(Quaternion &quat) const
+{
+    if (!_quat_valid) {
+        _quat.from_rotation_matrix(rot_body_to_ned);
+        _quat_valid = true;
+    }
+    quat = _quat;
+}
+
 // return a smoothed and corrected gyro vector using the latest ins data (which may not have been consumed by the EKF yet)
 Vector3f AP_AHRS_View::get_gyro_latest(void) const {
     return rot_view * ahrs.get_gyro_latest();
@@ -53,9 +53,7 @@ public:
     }
 
     // return a Quaternion representing our current attitude in this view
-    void get_quat_body_to_ned(Quaternion &quat) const {
-        quat.from_rotation_matrix(rot_body_to_ned);
-    }
+    void get_quat_body_to_ned(Quaternion &quat) const;
 
     // apply pitch trim
     void set_pitch_trim(float trim_deg);
@@ -218,6 +216,12 @@ private:
         float sin_yaw;
     } trig;
 
+    // quaternion of rot_body_to_ned, calculated on first use after
+    // each update as the attitude controllers ask for it several
+    // times per loop
+    mutable Quaternion _quat;
+    mutable bool _quat_valid = false;
+
     float y_angle;
     float _pitch_trim_deg;
 };
@@ -1825,6 +1825,14 @@ bool AP_Arming::arm(AP_Arming::Method method, const bool do_arming_checks)
 #endif
 #if defined(HAL_ARM_GPIO_PIN)
     update_arm_gpio();
+#endif
+#if AP_SCRIPTING_ENABLED
+    if (armed) {
+        AP_Scripting *scripting = AP_Scripting::get_singleton();
+        if (scripting != nullptr) {
+            scripting->notify_event(AP_Scripting::EVENT_ARMING);
+        }
+    }
 #endif
     return armed;
 }
@@ -1838,6 +1846,13 @@ bool AP_Arming::disarm(const AP_Arming::Method method, bool do_disarm_checks)
     armed = false;
     _last_disarm_method = method;
 
+#if AP_SCRIPTING_ENABLED
+    AP_Scripting *scripting = AP_Scripting::get_singleton();
+    if (scripting != nullptr) {
+        scripting->notify_event(AP_Scripting::EVENT_ARMING);
+    }
+#endif
+
 #if HAL_LOGGING_ENABLED
     Log_Write_Disarm(!do_disarm_checks, method);  // Log_Write_Disarm takes "force"
 
@@ -204,6 +204,37 @@ void CanardInterface::processTestRx() {
 }
 #endif
 
+/*
+  send a batch of frames to an interface, clearing the interface from
+  the mask of the frames it accepted
+ */
+bool CanardInterface::send_tx_batch(uint8_t iface, uint8_t num_frames, bool iface_down)
+{
+    const int16_t ret = ifaces[iface]->send_batch(tx_batch, num_frames, 0);
+    const uint8_t num_sent = ret > 0 ? ret : 0;
+    for (uint8_t i = 0; i < num_sent; i++) {
+        tx_batch_frames[i]->iface_mask &= ~(1U<<iface);
+    }
+    if (num_sent == num_frames) {
+        return true;
+    }
+    if (!iface_down) {
+        // if there is no space then we need to start from the
+        // top of the queue, so wait for the next loop
+        return false;
+    }
+    // don't hold frames for an interface which is down
+    for (uint8_t i = num_sent; i < num_frames; i++) {
+        tx_batch_frames[i]->iface_mask &= ~(1U<<iface);
+    }
+    return true;
+}
+
+/*
+  send pending frames, the frames for each interface are copied into
+  a staging array and handed over in batches, so the interface
+  lock is taken once per batch rather than once per frame
+ */
 void CanardInterface::processTx(bool raw_commands_only = false) {
     WITH_SEMAPHORE(_sem_tx);
 
@@ -230,54 +261,38 @@ void CanardInterface::processTx(bool raw_commands_only = false) {
             iface_down = false;
         } 
         // scan through list of pending transfers
-        while (true) {
+        const uint64_t now_us = AP_HAL::micros64();
+        uint8_t num_frames = 0;
+        for (; txq != nullptr; txq = txq->next) {
             auto txf = &txq->frame;
             if (raw_commands_only &&
                 CANARD_MSG_TYPE_FROM_ID(txf->id) != UAVCAN_EQUIPMENT_ESC_RAWCOMMAND_ID &&
                 CANARD_MSG_TYPE_FROM_ID(txf->id) != COM_HOBBYWING_ESC_RAWCOMMAND_ID) {
-                // look at next transfer
-                txq = txq->next;
-                if (txq == nullptr) {
-                    break;
-                }
                 continue;
             }
-            AP_HAL::CANFrame txmsg {};
+            if (!(txf->iface_mask & (1U<<iface)) || now_us >= txf->deadline_usec) {
+                continue;
+            }
+            auto &item = tx_batch[num_frames];
+            AP_HAL::CANFrame &txmsg = item.frame;
             txmsg.dlc = AP_HAL::CANFrame::dataLengthToDlc(txf->data_len);
             memcpy(txmsg.data, txf->data, txf->data_len);
+            memset(&txmsg.data[txf->data_len], 0, sizeof(txmsg.data) - txf->data_len);
             txmsg.id = (txf->id | AP_HAL::CANFrame::FlagEFF);
 #if HAL_CANFD_SUPPORTED
             txmsg.canfd = txf->canfd;
 #endif
-            bool write = true;
-            bool read = false;
-            ifaces[iface]->select(read, write, &txmsg, 0);
-            if (!write) {
-                // if there is no space then we need to start from the
-                // top of the queue, so wait for the next loop
-                if (!iface_down) {
+            item.deadline = txf->deadline_usec;
+            tx_batch_frames[num_frames++] = txf;
+            if (num_frames == ARRAY_SIZE(tx_batch)) {
+                if (!send_tx_batch(iface, num_frames, iface_down)) {
                     break;
-                } else {
-                    txf->iface_mask &= ~(1U<<iface);
-                }
-            } else if ((txf->iface_mask & (1U<<iface)) && (AP_HAL::micros64() < txf->deadline_usec)) {
-                // try sending to interfaces, clearing the mask if we succeed
-                if (ifaces[iface]->send(txmsg, txf->deadline_usec, 0) > 0) {
-                    txf->iface_mask &= ~(1U<<iface);
-                } else {
-                    // if we fail to send then we try sending on next interface
-                    if (!iface_down) {
-                        break;
-                    } else {
-                        txf->iface_mask &= ~(1U<<iface);
-                    }
                 }
+                num_frames = 0;
             }
-            // look at next transfer
-            txq = txq->next;
-            if (txq == nullptr) {
-                break;
-            }
+        }
+        if (txq == nullptr && num_frames > 0) {
+            send_tx_batch(iface, num_frames, iface_down);
         }
     }
 
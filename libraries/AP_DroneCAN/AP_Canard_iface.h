@@ -4,6 +4,11 @@
 #include <canard/interface.h>
 #include <dronecan_msgs.h>
 
+// number of frames handed to an interface at a time
+#ifndef CANARD_TX_BATCH_SIZE
+#define CANARD_TX_BATCH_SIZE 8
+#endif
+
 class AP_DroneCAN;
 class CANSensor;
 
@@ -65,6 +70,10 @@ public:
 
     uint8_t get_node_id() const override { return canard.node_id; }
 private:
+    // send a batch of frames to an interface, returns false if the
+    // interface has no more space
+    bool send_tx_batch(uint8_t iface, uint8_t num_frames, bool iface_down);
+
     CanardInstance canard;
     AP_HAL::CANIface* ifaces[HAL_NUM_CAN_IFACES];
 #if AP_TEST_DRONECAN_DRIVERS
@@ -77,6 +86,12 @@ private:
     HAL_Semaphore _sem_tx;
     HAL_Semaphore _sem_rx;
     CanardTxTransfer tx_transfer;
+
+    // staging array of frames for one send_batch() call from
+    // processTx, protected by _sem_tx
+    AP_HAL::CANIface::CanTxItem tx_batch[CANARD_TX_BATCH_SIZE];
+    CanardCANFrame *tx_batch_frames[CANARD_TX_BATCH_SIZE];
+
     dronecan_protocol_Stats protocol_stats;
 
     // auxillary 11 bit CANSensor
@@ -24,6 +24,7 @@
 #include "AP_Filesystem_Param.h"
 #include <AP_Param/AP_Param.h>
 #include <AP_Math/AP_Math.h>
+#include <AP_Math/crc.h>
 #include <ctype.h>
 
 #define PACKED_NAME "param.pck"
@@ -59,6 +60,7 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
     r.file_ofs = 0;
     r.open = true;
     r.with_defaults = false;
+    r.with_hash = false;
     r.start = 0;
     r.count = 0;
     r.read_size = 0;
@@ -74,6 +76,10 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
         }
     }
 
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+    uint32_t base_hash = 0;
+#endif
+
     /*
       allow for URI style arguments param.pck?start=N&count=C
      */
@@ -112,17 +118,57 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
             continue;
         }
 #endif
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+        if (strncmp(c, "changed_since=", 14) == 0) {
+            base_hash = strtoul(c+14, nullptr, 16);
+            r.with_hash = true;
+            c += 14;
+            c = strchr(c, '&');
+            continue;
+        }
+#endif
+    }
+
+    r.header_len = r.with_hash ? sizeof(struct header_with_hash) : sizeof(struct header);
+
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+    if (r.with_hash) {
+        if (!read_only || r.start != 0 || r.count != 0) {
+            // a delta is always against the full list
+            goto failed;
+        }
+        if (!setup_snapshot(r, base_hash)) {
+            free_file(r);
+            errno = ENOMEM;
+            return -1;
+        }
     }
+#endif
 
     return idx;
 
 failed:
-    delete [] r.cursors;
-    r.open = false;
+    free_file(r);
     errno = EINVAL;
     return -1;
 }
 
+/*
+  release the buffers of a file and mark it closed
+ */
+void AP_Filesystem_Param::free_file(struct rfile &r)
+{
+    r.open = false;
+    delete [] r.cursors;
+    r.cursors = nullptr;
+    delete r.writebuf;
+    r.writebuf = nullptr;
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+    delete [] r.changed;
+    r.changed = nullptr;
+#endif
+}
+
 int AP_Filesystem_Param::close(int fd)
 {
     if (fd < 0 || fd >= max_open_file || !file[fd].open) {
@@ -135,14 +181,95 @@ int AP_Filesystem_Param::close(int fd)
         errno = EINVAL;
         ret = -1;
     }
-    r.open = false;
-    delete [] r.cursors;
-    r.cursors = nullptr;
-    delete r.writebuf;
-    r.writebuf = nullptr;
+    free_file(r);
     return ret;
 }
 
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+/*
+  take a snapshot of the parameter values for a download which asked
+  for the hash. If base_hash is the hash of the previous snapshot then
+  the file only lists the parameters changed since that snapshot,
+  otherwise it lists all of them
+ */
+bool AP_Filesystem_Param::setup_snapshot(struct rfile &r, uint32_t base_hash)
+{
+    const uint16_t count = AP_Param::count_parameters();
+    uint32_t *values = new uint32_t[count];
+    if (values == nullptr) {
+        return false;
+    }
+
+    // the hash covers the parameter keys and types as well as the
+    // values so a delta is never taken against a different list
+    AP_Param::ParamToken token;
+    enum ap_var_type ptype;
+    uint32_t key_hash = 0;
+    uint16_t n = 0;
+    for (AP_Param *ap = AP_Param::first(&token, &ptype);
+         ap != nullptr && n < count;
+         ap = AP_Param::next_scalar(&token, &ptype), n++) {
+        const uint32_t key = token.key | (token.idx<<9) | (token.group_element<<13);
+        const uint8_t type = ptype;
+        key_hash = crc_crc32(key_hash, (const uint8_t *)&key, sizeof(key));
+        key_hash = crc_crc32(key_hash, &type, sizeof(type));
+        uint32_t v = 0;
+        memcpy(&v, ap, MIN(AP_Param::type_size(ptype), sizeof(v)));
+        values[n] = v;
+    }
+    key_hash = crc_crc32(key_hash, (const uint8_t *)&n, sizeof(n));
+    uint32_t hash = crc_crc32(key_hash, (const uint8_t *)values, n*sizeof(values[0]));
+    if (hash == 0) {
+        // zero asks for a full list
+        hash = 1;
+    }
+
+    r.hash = hash;
+    r.base_hash = 0;
+    r.num_changed = 0;
+    r.snapshot_count = n;
+    if (base_hash != 0 &&
+        snapshot.values != nullptr &&
+        base_hash == snapshot.hash &&
+        key_hash == snapshot.key_hash) {
+        r.changed = new uint8_t[(n+7)/8];
+        if (r.changed == nullptr) {
+            delete [] values;
+            return false;
+        }
+        for (uint16_t i=0; i<n; i++) {
+            if (values[i] != snapshot.values[i]) {
+                r.changed[i/8] |= 1U<<(i%8);
+                r.num_changed++;
+            }
+        }
+        r.base_hash = base_hash;
+    }
+
+    // keep the new snapshot for the next delta
+    if (hash != snapshot.hash) {
+        delete [] snapshot.values;
+        snapshot.values = values;
+        snapshot.hash = hash;
+        snapshot.key_hash = key_hash;
+    } else {
+        delete [] values;
+    }
+    return true;
+}
+
+/*
+  return true if a parameter belongs in a delta list
+ */
+bool AP_Filesystem_Param::param_changed(const struct rfile &r, uint16_t param_idx) const
+{
+    if (param_idx >= r.snapshot_count) {
+        return false;
+    }
+    return (r.changed[param_idx/8] & (1U<<(param_idx%8))) != 0;
+}
+#endif // AP_FILESYSTEM_PARAM_DELTA_ENABLED
+
 /*
   packed format:
     file header:
@@ -177,6 +304,7 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
 
     if (c.token_ofs == 0) {
         c.idx = 0;
+        c.param_idx = 0;
         ap = AP_Param::first(&c.token, &ptype, &default_val);
         uint16_t idx = 0;
         while (idx < r.start && ap) {
@@ -185,10 +313,22 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
         }
     } else {
         c.idx++;
+        c.param_idx++;
         ap = AP_Param::next_scalar(&c.token, &ptype, &default_val);
     }
+    bool full_list = r.count == 0;
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+    if (r.changed != nullptr) {
+        // skip the parameters which haven't changed
+        while (ap != nullptr && !param_changed(r, c.param_idx)) {
+            c.param_idx++;
+            ap = AP_Param::next_scalar(&c.token, &ptype, &default_val);
+        }
+        full_list = false;
+    }
+#endif
     if (ap == nullptr || (r.count && c.idx >= r.count)) {
-        if (r.count == 0 && c.idx != AP_Param::count_parameters()) {
+        if (full_list && c.idx != AP_Param::count_parameters()) {
             // the parameter count is incorrect, invalidate so a
             // repeated param download avoids an error
             AP_Param::invalidate_count();
@@ -226,7 +366,7 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
       won't get a corrupt value for a parameter
      */
     if (type_len > 1) {
-        const uint32_t ofs = c.token_ofs + sizeof(struct header) + packed_len;
+        const uint32_t ofs = c.token_ofs + r.header_len + packed_len;
         const uint32_t ofs_mod = ofs % r.read_size;
         if (ofs_mod > 0 && ofs_mod < type_len) {
             const uint8_t pad = type_len - ofs_mod;
@@ -353,8 +493,10 @@ int32_t AP_Filesystem_Param::read(int fd, void *buf, uint32_t count)
         }
     }
 
-    if (r.file_ofs < sizeof(struct header)) {
-        struct header hdr;
+    if (r.file_ofs < r.header_len) {
+        // the plain header is the start of the hash header
+        static_assert(sizeof(struct header_with_hash) == sizeof(struct header) + 8, "bad header size");
+        struct header_with_hash hdr {};
         hdr.total_params = AP_Param::count_parameters();
         if (hdr.total_params <= r.start) {
             errno = EINVAL;
@@ -364,10 +506,19 @@ int32_t AP_Filesystem_Param::read(int fd, void *buf, uint32_t count)
         if (r.count > 0 && hdr.num_params > r.count) {
             hdr.num_params = r.count;
         }
-        uint8_t n = MIN(sizeof(hdr) - r.file_ofs, count);
-        if (r.with_defaults) {
-            hdr.magic = pmagic_with_default;
+        uint8_t n = MIN(r.header_len - r.file_ofs, count);
+        if (r.with_hash) {
+            hdr.magic = r.with_defaults ? pmagic_hash_with_default : pmagic_hash;
+        } else {
+            hdr.magic = r.with_defaults ? pmagic_with_default : pmagic;
+        }
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+        if (r.changed != nullptr) {
+            hdr.num_params = r.num_changed;
         }
+        hdr.hash = r.hash;
+        hdr.base_hash = r.base_hash;
+#endif
         const uint8_t *b = (const uint8_t *)&hdr;
         memcpy(buf, &b[r.file_ofs], n);
         count -= n;
@@ -379,7 +530,7 @@ int32_t AP_Filesystem_Param::read(int fd, void *buf, uint32_t count)
         }
     }
 
-    uint32_t data_ofs = r.file_ofs - sizeof(struct header);
+    uint32_t data_ofs = r.file_ofs - r.header_len;
     uint8_t best_i = 0;
     uint32_t best_ofs = r.cursors[0].token_ofs;
     size_t total = 0;
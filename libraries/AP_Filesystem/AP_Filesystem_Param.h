@@ -49,6 +49,9 @@ private:
     // Support both protocol versions
     static constexpr uint16_t pmagic = 0x671b;
     static constexpr uint16_t pmagic_with_default = 0x671c;
+    // the same formats with a snapshot hash in the header
+    static constexpr uint16_t pmagic_hash = 0x671d;
+    static constexpr uint16_t pmagic_hash_with_default = 0x671e;
 
     // header at front of the file
     struct header {
@@ -57,6 +60,15 @@ private:
         uint16_t total_params; // for upload this is total file length
     };
 
+    // header used when the snapshot hash is requested
+    struct PACKED header_with_hash {
+        uint16_t magic = pmagic_hash;
+        uint16_t num_params;
+        uint16_t total_params;
+        uint32_t hash;      // hash of the parameter snapshot
+        uint32_t base_hash; // hash this is a delta from, zero for a full list
+    };
+
     struct cursor {
         AP_Param::ParamToken token;
         uint32_t token_ofs;
@@ -64,11 +76,14 @@ private:
         uint8_t trailer_len;
         uint8_t trailer[max_pack_len];
         uint16_t idx;
+        uint16_t param_idx; // index of the parameter in the full list
     };
 
     struct rfile {
         bool open;
         bool with_defaults;
+        bool with_hash;
+        uint8_t header_len;
         uint16_t read_size;
         uint16_t start;
         uint16_t count;
@@ -76,11 +91,36 @@ private:
         uint32_t file_size;
         struct cursor *cursors;
         ExpandingString *writebuf; // for upload
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+        uint32_t hash;
+        uint32_t base_hash;
+        uint16_t num_changed;
+        uint16_t snapshot_count;
+        uint8_t *changed;   // bitmask of parameters in a delta list
+#endif
     } file[max_open_file];
 
+#if AP_FILESYSTEM_PARAM_DELTA_ENABLED
+    /*
+      the parameter values as of the last download which asked for
+      the hash. A download can ask for only the parameters changed
+      since that snapshot by giving its hash
+     */
+    struct {
+        uint32_t hash;      // hash of the keys, types and values
+        uint32_t key_hash;  // hash of the keys and types only
+        uint16_t count;
+        uint32_t *values;
+    } snapshot;
+
+    bool setup_snapshot(struct rfile &r, uint32_t base_hash);
+    bool param_changed(const struct rfile &r, uint16_t param_idx) const;
+#endif
+
     bool token_seek(const struct rfile &r, const uint32_t data_ofs, struct cursor &c);
     uint8_t pack_param(const struct rfile &r, struct cursor &c, uint8_t *buf);
     bool check_file_name(const char *fname);
+    void free_file(struct rfile &r);
 
     // finish uploading parameters
     bool finish_upload(const rfile &r);
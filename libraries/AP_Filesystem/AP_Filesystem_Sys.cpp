@@ -26,6 +26,8 @@
 #include <AP_CANManager/AP_CANManager.h>
 #include <AP_Scheduler/AP_Scheduler.h>
 #include <AP_Common/ExpandingString.h>
+#include <GCS_MAVLink/GCS.h>
+#include <AP_GPS/AP_GPS.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -40,6 +42,15 @@ static const SysFileList sysfs_file_list[] = {
     {"memory.txt"},
     {"uarts.txt"},
     {"timers.txt"},
+#if HAL_GCS_ENABLED
+    {"routing.txt"},
+#endif
+#if AP_MAVLINK_MESSAGE_CACHE_ENABLED
+    {"msgcache.txt"},
+#endif
+#if AP_GPS_RTCM_STREAM_ENABLED
+    {"rtcm.txt"},
+#endif
 #if HAL_MAX_CAN_PROTOCOL_DRIVERS
     {"can_log.txt"},
 #endif
@@ -120,6 +131,21 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
     if (strcmp(fname, "timers.txt") == 0) {
         hal.util->timer_info(*r.str);
     }
+#if HAL_GCS_ENABLED
+    if (strcmp(fname, "routing.txt") == 0) {
+        GCS_MAVLINK::routing_info(*r.str);
+    }
+#endif
+#if AP_MAVLINK_MESSAGE_CACHE_ENABLED
+    if (strcmp(fname, "msgcache.txt") == 0) {
+        GCS_MAVLINK::message_cache_info(*r.str);
+    }
+#endif
+#if AP_GPS_RTCM_STREAM_ENABLED
+    if (strcmp(fname, "rtcm.txt") == 0) {
+        AP::gps().rtcm_stream_info(*r.str);
+    }
+#endif
 #if HAL_CANMANAGER_ENABLED
     if (strcmp(fname, "can_log.txt") == 0) {
         AP::can().log_retrieve(*r.str);
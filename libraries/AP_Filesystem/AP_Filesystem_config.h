@@ -22,6 +22,12 @@
 #define AP_FILESYSTEM_PARAM_ENABLED 1
 #endif
 
+// keep a snapshot of the parameter values so a GCS can download just
+// the parameters changed since its last download of @PARAM/param.pck
+#ifndef AP_FILESYSTEM_PARAM_DELTA_ENABLED
+#define AP_FILESYSTEM_PARAM_DELTA_ENABLED (AP_FILESYSTEM_PARAM_ENABLED && HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
 #ifndef AP_FILESYSTEM_POSIX_ENABLED
 #define AP_FILESYSTEM_POSIX_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
 #endif
@@ -41,6 +41,8 @@
 #include "AP_GPS_MSP.h"
 #include "AP_GPS_ExternalAHRS.h"
 #include "GPS_Backend.h"
+#include "RTCM3_Stream.h"
+#include <AP_Common/ExpandingString.h>
 #if HAL_SIM_GPS_ENABLED
 #include "AP_GPS_SITL.h"
 #endif
@@ -351,7 +353,7 @@ const AP_Param::GroupInfo AP_GPS::var_info[] = {
     // @Param: _DRV_OPTIONS
     // @DisplayName: driver options
     // @Description: Additional backend specific options
-    // @Bitmask: 0:Use UART2 for moving baseline on ublox,1:Use base station for GPS yaw on SBF,2:Use baudrate 115200,3:Use dedicated CAN port b/w GPSes for moving baseline,4:Use ellipsoid height instead of AMSL, 5:Override GPS satellite health of L5 band from L1 health, 6:Enable RTCM full parse even for a single channel, 7:Disable automatic full RTCM parsing when RTCM seen on more than one channel
+    // @Bitmask: 0:Use UART2 for moving baseline on ublox,1:Use base station for GPS yaw on SBF,2:Use baudrate 115200,3:Use dedicated CAN port b/w GPSes for moving baseline,4:Use ellipsoid height instead of AMSL, 5:Override GPS satellite health of L5 band from L1 health, 6:Enable RTCM full parse even for a single channel, 7:Disable automatic full RTCM parsing when RTCM seen on more than one channel, 8:Stream RTCM injection with observations sent ahead of other messages
     // @User: Advanced
     AP_GROUPINFO("_DRV_OPTIONS", 22, AP_GPS, _driver_options, 0),
 
@@ -1155,6 +1157,13 @@ void AP_GPS::update(void)
 #endif  // HAL_LOGING_ENABLED
 #endif  // GPS_MAX_RECEIVERS > 1
 
+#if AP_GPS_RTCM_STREAM_ENABLED
+    if (rtcm_stream != nullptr) {
+        // send corrections the receivers had no space for when they arrived
+        send_rtcm_stream();
+    }
+#endif
+
 #ifndef HAL_BUILD_AP_PERIPH
     // update notify with gps status. We always base this on the primary_instance
     AP_Notify::flags.gps_status = state[primary_instance].status;
@@ -1414,20 +1423,35 @@ void AP_GPS::lock_port(uint8_t instance, bool lock)
     }
 }
 
-// Inject a packet of raw binary to a GPS
-void AP_GPS::inject_data(const uint8_t *data, uint16_t len)
+// mask of the instances injected data is sent to
+uint8_t AP_GPS::inject_mask(void) const
 {
     //Support broadcasting to all GPSes.
     if (_inject_to == GPS_RTK_INJECT_TO_ALL) {
+        uint8_t mask = 0;
         for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
             if ((_type[i] == GPS_TYPE_UBLOX_RTK_ROVER) || (_type[i] == GPS_TYPE_UAVCAN_RTK_ROVER)) {
                 // we don't externally inject to moving baseline rover
                 continue;
             }
+            mask |= (1U<<i);
+        }
+        return mask;
+    }
+    if (_inject_to < GPS_MAX_RECEIVERS) {
+        return (1U<<_inject_to);
+    }
+    return 0;
+}
+
+// Inject a packet of raw binary to a GPS
+void AP_GPS::inject_data(const uint8_t *data, uint16_t len)
+{
+    const uint8_t mask = inject_mask();
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (mask & (1U<<i)) {
             inject_data(i, data, len);
         }
-    } else {
-        inject_data(_inject_to, data, len);
     }
 }
 
@@ -1689,6 +1713,19 @@ void AP_GPS::handle_gps_rtcm_data(mavlink_channel_t chan, const mavlink_message_
         return;
     }
 
+#if AP_GPS_RTCM_STREAM_ENABLED
+    if (option_set(DriverOptions::StreamRTCM)) {
+        if (rtcm_stream == nullptr) {
+            rtcm_stream = new RTCM3_Stream();
+        }
+        if (rtcm_stream != nullptr) {
+            rtcm_stream->handle_fragment(chan, packet.flags, packet.data, packet.len, inject_mask());
+            send_rtcm_stream();
+            return;
+        }
+    }
+#endif
+
 #if AP_GPS_RTCM_DECODE_ENABLED
     if (!option_set(DriverOptions::DisableRTCMDecode)) {
         const uint16_t mask = (1U << unsigned(chan));
@@ -1709,6 +1746,40 @@ void AP_GPS::handle_gps_rtcm_data(mavlink_channel_t chan, const mavlink_message_
     handle_gps_rtcm_fragment(packet.flags, packet.data, packet.len);
 }
 
+#if AP_GPS_RTCM_STREAM_ENABLED
+/*
+  send queued RTCM messages to each receiver while it has space for
+  them, observations first
+ */
+void AP_GPS::send_rtcm_stream(void)
+{
+    uint8_t buf[RTCM3_STREAM_BUF_LEN];
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (drivers[i] == nullptr) {
+            continue;
+        }
+        uint16_t len;
+        while ((len = rtcm_stream->peek(i, buf, sizeof(buf))) > 0) {
+            if (drivers[i]->inject_space() <= len) {
+                // try again on the next update
+                break;
+            }
+            drivers[i]->inject_data(buf, len);
+            rtcm_stream->pop(i);
+        }
+    }
+}
+
+void AP_GPS::rtcm_stream_info(ExpandingString &str) const
+{
+    if (rtcm_stream == nullptr) {
+        str.printf("RTCM streaming not active\n");
+        return;
+    }
+    rtcm_stream->info(str);
+}
+#endif  // AP_GPS_RTCM_STREAM_ENABLED
+
 #if AP_GPS_RTCM_DECODE_ENABLED
 /*
   fully parse RTCM data coming in from a MAVLink channel, when we have
@@ -69,6 +69,8 @@
 
 class AP_GPS_Backend;
 class RTCM3_Parser;
+class RTCM3_Stream;
+class ExpandingString;
 
 /// @class AP_GPS
 /// GPS driver main class
@@ -247,6 +249,10 @@ public:
 
     // Pass mavlink data to message handlers (for MAV type)
     void handle_msg(mavlink_channel_t chan, const mavlink_message_t &msg);
+#if AP_GPS_RTCM_STREAM_ENABLED
+    // report RTCM streaming stats for @SYS/rtcm.txt
+    void rtcm_stream_info(ExpandingString &str) const;
+#endif
 #if HAL_MSP_GPS_ENABLED
     void handle_msp(const MSP::msp_gps_data_message_t &pkt);
 #endif
@@ -628,11 +634,12 @@ protected:
         GPSL5HealthOverride = (1U << 5),
         AlwaysRTCMDecode = (1U << 6),
         DisableRTCMDecode = (1U << 7),
+        StreamRTCM = (1U << 8),
     };
 
     // check if an option is set
     bool option_set(const DriverOptions option) const {
-        return (uint8_t(_driver_options.get()) & uint8_t(option)) != 0;
+        return (uint16_t(_driver_options.get()) & uint16_t(option)) != 0;
     }
 
 private:
@@ -739,6 +746,15 @@ private:
     void inject_data(const uint8_t *data, uint16_t len);
     void inject_data(uint8_t instance, const uint8_t *data, uint16_t len);
 
+    // mask of the instances injected data is sent to
+    uint8_t inject_mask(void) const;
+
+#if AP_GPS_RTCM_STREAM_ENABLED
+    // streaming RTCM injection, enabled with the StreamRTCM option
+    RTCM3_Stream *rtcm_stream;
+    void send_rtcm_stream(void);
+#endif
+
 #if defined(GPS_BLENDED_INSTANCE)
     // GPS blending and switching
     Vector3f _blended_antenna_offset; // blended antenna offset
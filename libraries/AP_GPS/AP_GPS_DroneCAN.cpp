@@ -822,6 +822,15 @@ void AP_GPS_DroneCAN::inject_data(const uint8_t *data, uint16_t len)
     }
 }
 
+uint32_t AP_GPS_DroneCAN::inject_space(void)
+{
+    if (_rtcm_stream.buf == nullptr) {
+        // allocated on the first injection
+        return UINT32_MAX;
+    }
+    return _rtcm_stream.buf->space();
+}
+
 /*
     handle param get/set response
 */
@@ -66,3 +66,7 @@
 #ifndef AP_GPS_RTCM_DECODE_ENABLED
   #define AP_GPS_RTCM_DECODE_ENABLED BOARD_FLASH_SIZE > 1024
 #endif
+
+#ifndef AP_GPS_RTCM_STREAM_ENABLED
+  #define AP_GPS_RTCM_STREAM_ENABLED (AP_GPS_ENABLED && AP_GPS_RTCM_DECODE_ENABLED && HAL_GCS_ENABLED && HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
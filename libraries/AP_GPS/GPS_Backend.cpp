@@ -129,6 +129,12 @@ AP_GPS_Backend::inject_data(const uint8_t *data, uint16_t len)
     }
 }
 
+uint32_t AP_GPS_Backend::inject_space(void)
+{
+    // backends without a port discard injected data
+    return port != nullptr ? port->txspace() : UINT32_MAX;
+}
+
 void AP_GPS_Backend::_detection_message(char *buffer, const uint8_t buflen) const
 {
     const uint8_t instance = state.instance;
@@ -68,6 +68,9 @@ public:
 
     virtual void inject_data(const uint8_t *data, uint16_t len);
 
+    // number of bytes inject_data() can take now
+    virtual uint32_t inject_space(void);
+
 #if HAL_GCS_ENABLED
     //MAVLink methods
     virtual bool supports_mavlink_gps_rtk_message() const { return false; }
@@ -0,0 +1,299 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  streaming injection of RTCMv3 corrections from GPS_RTCM_DATA
+*/
+
+#include "RTCM3_Stream.h"
+
+#if AP_GPS_RTCM_STREAM_ENABLED
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Common/ExpandingString.h>
+
+// a fragment this long after the last one on a channel starts a new block
+#define RTCM3_STREAM_BLOCK_TIMEOUT_MS 1000
+
+// a message with the same CRC as one received this recently on
+// another channel is a duplicate. Base stations repeat some messages,
+// such as 1005 and 1230, unchanged several times a second, so this is
+// kept shorter than any repeat interval
+#define RTCM3_STREAM_DUPLICATE_MS 150
+
+/*
+  return true for the messages needed with every fix: observations,
+  the reference station position and GLONASS biases
+ */
+bool RTCM3_Stream::is_observation(uint16_t id)
+{
+    // legacy GPS and GLONASS observations
+    if ((id >= 1001 && id <= 1004) || (id >= 1009 && id <= 1012)) {
+        return true;
+    }
+    // MSM1 to MSM7 for each constellation, 1071 to 1137
+    if (id >= 1071 && id <= 1137 && (id % 10) >= 1 && (id % 10) <= 7) {
+        return true;
+    }
+    return id == 1005 || id == 1006 || id == 1230;
+}
+
+/*
+  handle a GPS_RTCM_DATA fragment. The 8 bit flags field is interpreted as:
+          1 bit for "is fragmented"
+          2 bits for fragment number
+          5 bits for sequence number
+ */
+void RTCM3_Stream::handle_fragment(mavlink_channel_t chan, uint8_t flags, const uint8_t *data, uint8_t len, uint8_t instance_mask)
+{
+    if (chan >= MAVLINK_COMM_NUM_BUFFERS || len > MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN) {
+        return;
+    }
+    if (chans[chan] == nullptr) {
+        chans[chan] = new chan_state;
+        if (chans[chan] == nullptr) {
+            return;
+        }
+        chans[chan]->chan = chan;
+    }
+    struct chan_state &c = *chans[chan];
+
+    if ((flags & 1) == 0) {
+        // it is not fragmented
+        parse(c, data, len, instance_mask);
+        return;
+    }
+
+    const uint8_t fragment = (flags >> 1U) & 0x03;
+    const uint8_t sequence = (flags >> 3U) & 0x1F;
+    const uint32_t now_ms = AP_HAL::millis();
+    if (sequence != c.sequence || now_ms - c.last_ms > RTCM3_STREAM_BLOCK_TIMEOUT_MS) {
+        // start of a new block, fragments held from the last block are
+        // parsed and the parser resyncs at the next message after a gap
+        flush_held(c, instance_mask);
+        c.sequence = sequence;
+        c.next_fragment = 0;
+    }
+    c.last_ms = now_ms;
+
+    if (fragment < c.next_fragment || (c.held_mask & (1U<<fragment))) {
+        stats.fragments_duplicate++;
+        return;
+    }
+    if (fragment > c.next_fragment) {
+        // hold it until the fragments before it arrive
+        memcpy(c.held[fragment], data, len);
+        c.held_len[fragment] = len;
+        c.held_mask |= (1U<<fragment);
+        return;
+    }
+
+    parse(c, data, len, instance_mask);
+    stats.fragments_used++;
+    c.next_fragment++;
+
+    // parse held fragments which now follow on
+    while (c.next_fragment < ARRAY_SIZE(c.held) && (c.held_mask & (1U<<c.next_fragment))) {
+        parse(c, c.held[c.next_fragment], c.held_len[c.next_fragment], instance_mask);
+        c.held_mask &= ~(1U<<c.next_fragment);
+        stats.fragments_used++;
+        c.next_fragment++;
+    }
+}
+
+/*
+  parse the held fragments of a block which won't be completed,
+  counting the missing fragments before them as lost
+ */
+void RTCM3_Stream::flush_held(struct chan_state &c, uint8_t instance_mask)
+{
+    for (uint8_t f = c.next_fragment; f < ARRAY_SIZE(c.held) && c.held_mask != 0; f++) {
+        if (c.held_mask & (1U<<f)) {
+            parse(c, c.held[f], c.held_len[f], instance_mask);
+            c.held_mask &= ~(1U<<f);
+            stats.fragments_used++;
+        } else {
+            stats.fragments_lost++;
+        }
+    }
+    c.held_mask = 0;
+}
+
+/*
+  parse bytes from a channel, queueing each new message for the
+  receivers in instance_mask
+ */
+void RTCM3_Stream::parse(struct chan_state &c, const uint8_t *data, uint16_t len, uint8_t instance_mask)
+{
+    for (uint16_t i=0; i<len; i++) {
+        if (!c.parser.read(data[i])) {
+            continue;
+        }
+        const uint8_t *msg = nullptr;
+        const uint16_t msg_len = c.parser.get_len(msg);
+        stats.messages++;
+
+        // the parser has checked the CRC24 at the end of the message,
+        // use it to spot messages already received on another
+        // channel. Repeats on the same channel are always sent
+        const uint32_t now_ms = AP_HAL::millis();
+        const uint32_t crc = (msg[msg_len-3] << 16) | (msg[msg_len-2] << 8) | msg[msg_len-1];
+        bool duplicate = false;
+        for (const auto &s : sent) {
+            if (s.crc == crc && s.chan != c.chan && now_ms - s.time_ms < RTCM3_STREAM_DUPLICATE_MS) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            stats.messages_duplicate++;
+            continue;
+        }
+        sent[sent_idx].crc = crc;
+        sent[sent_idx].time_ms = now_ms;
+        sent[sent_idx].chan = c.chan;
+        sent_idx = (sent_idx+1) % ARRAY_SIZE(sent);
+
+        const uint8_t queue = is_observation(c.parser.get_id()) ? QUEUE_OBS : QUEUE_OTHER;
+        for (uint8_t instance=0; instance<GPS_MAX_RECEIVERS; instance++) {
+            if (instance_mask & (1U<<instance)) {
+                queue_msg(instance, queue, msg, msg_len);
+            }
+        }
+    }
+}
+
+/*
+  queue a message for a receiver. Old corrections are of no use, so
+  when the queue is full the oldest messages are dropped
+ */
+void RTCM3_Stream::queue_msg(uint8_t instance, uint8_t queue, const uint8_t *msg, uint16_t len)
+{
+    struct receiver &r = receivers[instance];
+    if (r.queue[queue] == nullptr) {
+        r.queue[queue] = new ByteBuffer(queue == QUEUE_OBS ? RTCM3_STREAM_OBS_QUEUE_SIZE : RTCM3_STREAM_OTHER_QUEUE_SIZE);
+        if (r.queue[queue] == nullptr) {
+            r.dropped++;
+            return;
+        }
+    }
+    ByteBuffer &q = *r.queue[queue];
+    const queued_msg hdr { AP_HAL::millis(), len };
+    const uint32_t needed = sizeof(hdr) + len;
+    if (needed >= q.get_size()) {
+        r.dropped++;
+        return;
+    }
+    while (q.space() < needed) {
+        queued_msg old;
+        if (q.peekbytes((uint8_t *)&old, sizeof(old)) != sizeof(old)) {
+            q.clear();
+            break;
+        }
+        q.advance(sizeof(old) + old.len);
+        r.dropped++;
+    }
+    q.write((const uint8_t *)&hdr, sizeof(hdr));
+    q.write(msg, len);
+}
+
+/*
+  copy the next message for a receiver into buf, observations first
+ */
+uint16_t RTCM3_Stream::peek(uint8_t instance, uint8_t *buf, uint16_t buflen)
+{
+    if (instance >= GPS_MAX_RECEIVERS) {
+        return 0;
+    }
+    struct receiver &r = receivers[instance];
+    for (uint8_t i=0; i<NUM_QUEUES; i++) {
+        ByteBuffer *q = r.queue[i];
+        if (q == nullptr) {
+            continue;
+        }
+        queued_msg hdr;
+        if (q->peekbytes((uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr)) {
+            continue;
+        }
+        const uint16_t total = sizeof(hdr) + hdr.len;
+        if (total > buflen || q->peekbytes(buf, total) != total) {
+            // can't be sent
+            q->advance(total);
+            r.dropped++;
+            return 0;
+        }
+        memmove(buf, &buf[sizeof(hdr)], hdr.len);
+        r.peek_queue = i;
+        return hdr.len;
+    }
+    return 0;
+}
+
+/*
+  remove the message returned by peek() once it has been sent
+ */
+void RTCM3_Stream::pop(uint8_t instance)
+{
+    if (instance >= GPS_MAX_RECEIVERS) {
+        return;
+    }
+    struct receiver &r = receivers[instance];
+    ByteBuffer *q = r.queue[r.peek_queue];
+    queued_msg hdr;
+    if (q == nullptr || q->peekbytes((uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return;
+    }
+    q->advance(sizeof(hdr) + hdr.len);
+
+    const uint32_t now_ms = AP_HAL::millis();
+    const uint32_t age_ms = now_ms - hdr.time_ms;
+    r.sent++;
+    r.age_sum_ms += age_ms;
+    r.age_count++;
+    r.age_max_ms = MAX(r.age_max_ms, age_ms);
+    if (r.peek_queue == QUEUE_OBS) {
+        r.last_obs_ms = now_ms;
+    }
+}
+
+void RTCM3_Stream::info(ExpandingString &str) const
+{
+    str.printf("Fragments: used %u lost %u duplicate %u\n",
+               unsigned(stats.fragments_used),
+               unsigned(stats.fragments_lost),
+               unsigned(stats.fragments_duplicate));
+    str.printf("Messages: %u duplicate %u\n",
+               unsigned(stats.messages),
+               unsigned(stats.messages_duplicate));
+    const uint32_t now_ms = AP_HAL::millis();
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        const struct receiver &r = receivers[i];
+        if (r.queue[QUEUE_OBS] == nullptr && r.queue[QUEUE_OTHER] == nullptr) {
+            continue;
+        }
+        // queue age is from a message being parsed to it being sent,
+        // obs age is the time since an observation was last sent
+        str.printf("GPS%u: sent %u dropped %u queued %u/%u age avg %ums max %ums obs age %ums\n",
+                   unsigned(i+1),
+                   unsigned(r.sent),
+                   unsigned(r.dropped),
+                   unsigned(r.queue[QUEUE_OBS] ? r.queue[QUEUE_OBS]->available() : 0),
+                   unsigned(r.queue[QUEUE_OTHER] ? r.queue[QUEUE_OTHER]->available() : 0),
+                   unsigned(r.age_count ? r.age_sum_ms / r.age_count : 0),
+                   unsigned(r.age_max_ms),
+                   unsigned(r.last_obs_ms ? now_ms - r.last_obs_ms : 0));
+    }
+}
+
+#endif  // AP_GPS_RTCM_STREAM_ENABLED
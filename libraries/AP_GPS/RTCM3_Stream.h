@@ -0,0 +1,137 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  streaming injection of RTCMv3 corrections from GPS_RTCM_DATA
+*/
+#pragma once
+
+#include "AP_GPS_config.h"
+
+#if AP_GPS_RTCM_STREAM_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/utility/RingBuffer.h>
+#include "AP_GPS.h"
+#include "RTCM3_Parser.h"
+
+// bytes queued for each receiver, observations and other messages
+#ifndef RTCM3_STREAM_OBS_QUEUE_SIZE
+#define RTCM3_STREAM_OBS_QUEUE_SIZE 2048
+#endif
+#ifndef RTCM3_STREAM_OTHER_QUEUE_SIZE
+#define RTCM3_STREAM_OTHER_QUEUE_SIZE 1024
+#endif
+
+// size of the buffer passed to peek()
+#define RTCM3_STREAM_BUF_LEN (RTCM3_MAX_PACKET_LEN + 6)
+
+class ExpandingString;
+
+/*
+  GPS_RTCM_DATA fragments are fed to a per channel RTCM3_Parser as they
+  arrive, so messages are sent to the receivers without waiting for the
+  rest of a fragmented block. Fragments which arrive ahead of a missing
+  one are held until the gap is filled or the next block starts.
+
+  Each complete message is queued for each receiver it is for.
+  Observation messages have their own queue which is sent first, so
+  that ephemeris and other slowly changing messages don't delay them.
+  When a queue is full the oldest messages are dropped.
+ */
+class RTCM3_Stream {
+public:
+    // handle a GPS_RTCM_DATA fragment from a MAVLink channel. Complete
+    // messages are queued for the receivers in instance_mask
+    void handle_fragment(mavlink_channel_t chan, uint8_t flags, const uint8_t *data, uint8_t len, uint8_t instance_mask);
+
+    // copy the next message to send to a receiver into buf, of at
+    // least RTCM3_STREAM_BUF_LEN bytes, without removing it from its
+    // queue. Returns the length, or 0 if there is none
+    uint16_t peek(uint8_t instance, uint8_t *buf, uint16_t buflen);
+
+    // remove the message returned by peek() for a receiver once it
+    // has been sent
+    void pop(uint8_t instance);
+
+    // report correction age and loss for @SYS/rtcm.txt
+    void info(ExpandingString &str) const;
+
+private:
+    enum {
+        QUEUE_OBS = 0,
+        QUEUE_OTHER = 1,
+        NUM_QUEUES
+    };
+
+    // header of each queued message
+    struct PACKED queued_msg {
+        uint32_t time_ms;
+        uint16_t len;
+    };
+
+    struct chan_state {
+        RTCM3_Parser parser;
+        uint8_t chan;
+        uint32_t last_ms;       // time of last fragment
+        uint8_t sequence;
+        uint8_t next_fragment;  // next fragment to parse in this block
+        uint8_t held_mask;      // fragments which arrived ahead of next_fragment
+        uint8_t held_len[4];
+        uint8_t held[4][MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN];
+    } *chans[MAVLINK_COMM_NUM_BUFFERS];
+
+    struct receiver {
+        ByteBuffer *queue[NUM_QUEUES];
+        uint8_t peek_queue;     // queue of the message returned by peek()
+        uint32_t last_obs_ms;   // time the last observation was sent
+        uint32_t sent;
+        uint32_t dropped;
+        uint32_t age_sum_ms;
+        uint32_t age_count;
+        uint32_t age_max_ms;
+    } receivers[GPS_MAX_RECEIVERS];
+
+    // recently queued messages, to drop copies of a message which
+    // arrive on another channel
+    struct {
+        uint32_t crc;
+        uint32_t time_ms;
+        uint8_t chan;
+    } sent[32];
+    uint8_t sent_idx;
+
+    struct {
+        uint32_t fragments_used;
+        uint32_t fragments_lost;
+        uint32_t fragments_duplicate;
+        uint32_t messages;
+        uint32_t messages_duplicate;
+    } stats;
+
+    // pass held fragments of the current block to the parser
+    void flush_held(struct chan_state &c, uint8_t instance_mask);
+
+    // parse bytes from a channel, queueing complete messages
+    void parse(struct chan_state &c, const uint8_t *data, uint16_t len, uint8_t instance_mask);
+
+    // queue a message for a receiver, dropping the oldest messages if
+    // there is no space
+    void queue_msg(uint8_t instance, uint8_t queue, const uint8_t *msg, uint16_t len);
+
+    // true for observation messages and others needed with every fix
+    static bool is_observation(uint16_t id);
+};
+
+#endif  // AP_GPS_RTCM_STREAM_ENABLED
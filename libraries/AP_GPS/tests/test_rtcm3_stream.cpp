@@ -0,0 +1,127 @@
+#include <AP_gtest.h>
+
+#include <AP_GPS/RTCM3_Stream.h>
+#include <AP_Math/crc.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+#if AP_GPS_RTCM_STREAM_ENABLED
+
+// build an RTCMv3 message with the given id and payload length
+static uint16_t make_msg(uint8_t *buf, uint16_t id, uint16_t payload_len, uint8_t fill)
+{
+    buf[0] = 0xD3;
+    buf[1] = payload_len >> 8;
+    buf[2] = payload_len & 0xFF;
+    memset(&buf[3], fill, payload_len);
+    buf[3] = id >> 4;
+    buf[4] = ((id & 0x0F) << 4) | (fill & 0x0F);
+    const uint32_t crc = crc_crc24(buf, payload_len+3);
+    buf[payload_len+3] = crc >> 16;
+    buf[payload_len+4] = crc >> 8;
+    buf[payload_len+5] = crc;
+    return payload_len+6;
+}
+
+static uint16_t msg_id(const uint8_t *buf)
+{
+    return (buf[3]<<8 | buf[4]) >> 4;
+}
+
+// send a block of data as GPS_RTCM_DATA fragments, in the order given
+static void send_block(RTCM3_Stream &stream, mavlink_channel_t chan, uint8_t sequence,
+                       const uint8_t *data, uint16_t len, const uint8_t *order, uint8_t num_fragments)
+{
+    const uint8_t frag_len = MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN;
+    for (uint8_t i=0; i<num_fragments; i++) {
+        const uint8_t f = order[i];
+        const uint16_t ofs = f * frag_len;
+        const uint8_t flen = MIN(len - ofs, frag_len);
+        const uint8_t flags = 1 | (f << 1) | (sequence << 3);
+        stream.handle_fragment(chan, flags, &data[ofs], flen, 1);
+    }
+}
+
+TEST(RTCM3_Stream, ObservationsFirst)
+{
+    RTCM3_Stream stream {};
+    uint8_t block[400];
+    uint16_t len = make_msg(block, 1019, 61, 0x11);
+    len += make_msg(&block[len], 1077, 250, 0x22);
+
+    const uint8_t order[] { 0, 1 };
+    send_block(stream, MAVLINK_COMM_0, 1, block, len, order, 2);
+
+    uint8_t buf[RTCM3_STREAM_BUF_LEN];
+    EXPECT_EQ(256, stream.peek(0, buf, sizeof(buf)));
+    EXPECT_EQ(1077, msg_id(buf));
+    stream.pop(0);
+    EXPECT_EQ(67, stream.peek(0, buf, sizeof(buf)));
+    EXPECT_EQ(1019, msg_id(buf));
+    EXPECT_EQ(0, memcmp(buf, block, 67));
+    stream.pop(0);
+    EXPECT_EQ(0, stream.peek(0, buf, sizeof(buf)));
+    EXPECT_EQ(0, stream.peek(1, buf, sizeof(buf)));
+}
+
+TEST(RTCM3_Stream, ReorderedFragments)
+{
+    RTCM3_Stream stream {};
+    uint8_t block[400];
+    uint16_t len = make_msg(block, 1005, 19, 0x33);
+    len += make_msg(&block[len], 1087, 300, 0x44);
+
+    // the second fragment is held until the first arrives
+    const uint8_t order[] { 1, 0 };
+    uint8_t buf[RTCM3_STREAM_BUF_LEN];
+    send_block(stream, MAVLINK_COMM_0, 2, block, len, order, 1);
+    EXPECT_EQ(0, stream.peek(0, buf, sizeof(buf)));
+    send_block(stream, MAVLINK_COMM_0, 2, block, len, &order[1], 1);
+
+    EXPECT_EQ(25, stream.peek(0, buf, sizeof(buf)));
+    EXPECT_EQ(1005, msg_id(buf));
+    stream.pop(0);
+    EXPECT_EQ(306, stream.peek(0, buf, sizeof(buf)));
+    EXPECT_EQ(1087, msg_id(buf));
+    EXPECT_EQ(0, memcmp(buf, &block[25], 306));
+    stream.pop(0);
+    EXPECT_EQ(0, stream.peek(0, buf, sizeof(buf)));
+}
+
+TEST(RTCM3_Stream, DuplicateChannel)
+{
+    RTCM3_Stream stream {};
+    uint8_t msg[100];
+    const uint16_t len = make_msg(msg, 1127, 80, 0x55);
+
+    // the same message on two channels is only queued once
+    stream.handle_fragment(MAVLINK_COMM_0, 0, msg, len, 1);
+    stream.handle_fragment(MAVLINK_COMM_1, 0, msg, len, 1);
+
+    uint8_t buf[RTCM3_STREAM_BUF_LEN];
+    EXPECT_EQ(len, stream.peek(0, buf, sizeof(buf)));
+    stream.pop(0);
+    EXPECT_EQ(0, stream.peek(0, buf, sizeof(buf)));
+}
+
+TEST(RTCM3_Stream, RepeatSameChannel)
+{
+    RTCM3_Stream stream {};
+    uint8_t msg[30];
+    const uint16_t len = make_msg(msg, 1005, 19, 0x66);
+
+    // a base station repeating a message on one channel is not a duplicate
+    stream.handle_fragment(MAVLINK_COMM_0, 0, msg, len, 1);
+    stream.handle_fragment(MAVLINK_COMM_0, 0, msg, len, 1);
+
+    uint8_t buf[RTCM3_STREAM_BUF_LEN];
+    EXPECT_EQ(len, stream.peek(0, buf, sizeof(buf)));
+    stream.pop(0);
+    EXPECT_EQ(len, stream.peek(0, buf, sizeof(buf)));
+    stream.pop(0);
+    EXPECT_EQ(0, stream.peek(0, buf, sizeof(buf)));
+}
+
+#endif  // AP_GPS_RTCM_STREAM_ENABLED
+
+AP_GTEST_MAIN()
@@ -57,6 +57,7 @@ extern const AP_HAL::HAL& hal;
 #define FFT_HARMONIC_FIT_MULT       50.0f
 #define FFT_HARMONIC_FIT_TRACK_ROLL    4
 #define FFT_HARMONIC_FIT_TRACK_PITCH   5
+#define FFT_TRACKING_FULL_CYCLES    8       // number of peak tracking frames between full FFT frames
 
 // table of user settable parameters
 const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
@@ -169,8 +170,8 @@ const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
 
     // @Param: OPTIONS
     // @DisplayName: FFT options
-    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference
-    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise
+    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference,4:Once noise peaks are found only track the bins around them between full FFT frames, this significantly reduces CPU usage. Not compatible with FFT_NUM_FRAMES.,8:Analyse all three axes together in every frame rather than one axis per frame, this requires three times the DSP memory but allows the transforms to be batched and keeps the axes in step
+    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise,2:Track noise peaks between full FFT frames,3:Analyse all axes every frame
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("OPTIONS", 15, AP_GyroFFT, _options, 0),
@@ -234,7 +235,9 @@ void AP_GyroFFT::init(uint16_t loop_rate_hz)
 
     // check that we have enough memory for the window size requested
     // INS: XYZ_AXIS_COUNT * INS_MAX_INSTANCES * _window_size, DSP: 3 * _window_size, FFT: XYZ_AXIS_COUNT + 3 * _window_size
-    const uint32_t allocation_count = (XYZ_AXIS_COUNT * INS_MAX_INSTANCES + 3 + XYZ_AXIS_COUNT + 3 + _num_frames) * sizeof(float);
+    // analysing all axes together requires a DSP engine per axis
+    const uint8_t num_engines = using_all_axes() ? XYZ_AXIS_COUNT : 1;
+    const uint32_t allocation_count = (XYZ_AXIS_COUNT * INS_MAX_INSTANCES + (3 + _num_frames) * num_engines + XYZ_AXIS_COUNT + 3) * sizeof(float);
     if (allocation_count * FFT_DEFAULT_WINDOW_SIZE > hal.util->available_memory() / 2) {
         gcs().send_text(MAV_SEVERITY_WARNING, "AP_GyroFFT: disabled, required %u bytes", (unsigned int)allocation_count * FFT_DEFAULT_WINDOW_SIZE);
         return;
@@ -316,6 +319,22 @@ void AP_GyroFFT::init(uint16_t loop_rate_hz)
         return;
     }
 
+    _update_state = _state;
+
+    // give each axis its own engine if they are to be analysed together
+    if (using_all_axes()) {
+        _axis_state[0] = _state;
+        _all_axes = true;
+        for (uint8_t axis = 1; axis < XYZ_AXIS_COUNT; axis++) {
+            _axis_state[axis] = hal.dsp->fft_init(_window_size, _fft_sampling_rate_hz, _num_frames);
+            if (_axis_state[axis] == nullptr) {
+                gcs().send_text(MAV_SEVERITY_WARNING, "AP_GyroFFT: analysing one axis per frame");
+                _all_axes = false;
+                break;
+            }
+        }
+    }
+
     // per-axis frame time
     _frame_time_ms = _samples_per_frame * 1000 / _fft_sampling_rate_hz;
     // The update rate for the output, defaults are 1Khz / (1 - 0.5) * 32 == 62hz
@@ -440,7 +459,7 @@ uint16_t AP_GyroFFT::run_cycle()
 
     // do we have enough samples for another pass?
     if (!start_analysis()) {
-        uint16_t new_sample_count =  get_available_samples(_update_axis);
+        uint16_t new_sample_count = get_frame_samples();
         _sem.give();
         return new_sample_count;
     }
@@ -452,26 +471,103 @@ uint16_t AP_GyroFFT::run_cycle()
 
     uint32_t now = AP_HAL::micros();
 
+    if (_all_axes) {
+        // analyse every axis in one pass so that the DSP engine can batch the transforms
+        AP_HAL::DSP::FFTWindowState* batch_states[XYZ_AXIS_COUNT];
+        uint16_t batch_bins[XYZ_AXIS_COUNT];
+        uint8_t batch_axes[XYZ_AXIS_COUNT];
+        uint8_t batch_count = 0;
+        uint16_t bin_max[XYZ_AXIS_COUNT] {};
+
+        for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            FloatBuffer& gyro_buffer = get_gyro_window(axis);
+            // if the peaks are known just track them, otherwise queue a full FFT
+            if (_tracking_cycles[axis] > 0) {
+                bin_max[axis] = hal.dsp->fft_track(_axis_state[axis], gyro_buffer, _samples_per_frame, _tracking_bins[axis],
+                    config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+            }
+            if (bin_max[axis] == 0) {
+                hal.dsp->fft_start(_axis_state[axis], gyro_buffer, _samples_per_frame);
+                batch_states[batch_count] = _axis_state[axis];
+                batch_axes[batch_count++] = axis;
+            }
+        }
+
+        // calculate FFTs and update filters outside the semaphore
+        bool tracking[XYZ_AXIS_COUNT] { true, true, true };
+        hal.dsp->fft_analyse_batch(batch_states, batch_count, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff, batch_bins);
+        for (uint8_t i = 0; i < batch_count; i++) {
+            bin_max[batch_axes[i]] = batch_bins[i];
+            tracking[batch_axes[i]] = false;
+        }
+
+        for (_update_axis = 0; _update_axis < XYZ_AXIS_COUNT; _update_axis++) {
+            _update_state = _axis_state[_update_axis];
+            update_axis(bin_max[_update_axis], tracking[_update_axis], config, now);
+        }
+        _update_axis = 0;
+        _update_state = _state;
+    } else {
+        // get the appropriate gyro buffer
+        FloatBuffer& gyro_buffer = get_gyro_window(_update_axis);
+        // if the peaks are known just track them, otherwise do a full FFT
+        uint16_t bin_max = 0;
+        if (_tracking_cycles[_update_axis] > 0) {
+            bin_max = hal.dsp->fft_track(_state, gyro_buffer, _samples_per_frame, _tracking_bins[_update_axis],
+                config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+        }
+        const bool tracking = bin_max > 0;
+
+        if (bin_max == 0) {
+            // let's go!
+            hal.dsp->fft_start(_state, gyro_buffer, _samples_per_frame);
+
+            // calculate FFT and update filters outside the semaphore
+            bin_max = hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+        }
+
+        update_axis(bin_max, tracking, config, now);
+
+        // move onto the next axis
+        _update_axis = (_update_axis + 1) % XYZ_AXIS_COUNT;
+    }
+
+    // ready to receive another frame, because lock contention is so expensive we don't lock
+    // around this flag but rather rely on the semaphore at the beginning of the loop to
+    // ensure eventual visibility to the main loop
+    _thread_state._analysis_started = false;
+
+    // samples remaining in the next frame
+    return get_frame_samples();
+}
+
+// return the gyro window for an axis, dropping samples if the FFT thread is falling behind
+// called from FFT thread
+FloatBuffer& AP_GyroFFT::get_gyro_window(uint8_t axis)
+{
     // get the appropriate gyro buffer
-    FloatBuffer& gyro_buffer = (_sample_mode == 0 ?_ins->get_raw_gyro_window(_update_axis) : _downsampled_gyro_data[_update_axis]);
+    FloatBuffer& gyro_buffer = (_sample_mode == 0 ?_ins->get_raw_gyro_window(axis) : _downsampled_gyro_data[axis]);
     // if we have many more samples than the window size then we are struggling to 
     // stay ahead of the gyro loop so drop samples so that this cycle will use all available samples
     if (gyro_buffer.available() > uint32_t(_state->_window_size + uint16_t(_samples_per_frame >> 1))) { // half the frame size is a heuristic
         gyro_buffer.advance(gyro_buffer.available() - _state->_window_size);
     }
-    // let's go!
-    hal.dsp->fft_start(_state, gyro_buffer, _samples_per_frame);
-
-    // calculate FFT and update filters outside the semaphore
-    uint16_t bin_max = hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+    return gyro_buffer;
+}
 
+// update the peak frequency and associated metrics for the current axis from the analysed frame
+// called from FFT thread
+void AP_GyroFFT::update_axis(uint16_t bin_max, bool tracking, const EngineConfig& config, uint32_t start_us)
+{
     // something has been detected, update the peak frequency and associated metrics
+    const uint8_t health = _thread_state._health[_update_axis];
     update_ref_energy(bin_max);
     calculate_noise(false, config);
+    update_tracking_state(tracking, health, config);
 
     // record how we are doing
     _thread_state._last_output_us[_update_axis] = AP_HAL::micros();
-    _output_cycle_micros = _thread_state._last_output_us[_update_axis] - now;
+    _output_cycle_micros = _thread_state._last_output_us[_update_axis] - start_us;
 
 #if AP_SIM_ENABLED && HAL_LOGGING_ENABLED
     // extra logging when running simulations
@@ -483,27 +579,60 @@ uint16_t AP_GyroFFT::run_cycle()
         "QBfffffffff",
         AP_HAL::micros64(),
         _update_axis,
-        _state->_peak_data[0]._freq_hz,
-        _state->_peak_data[1]._freq_hz,
-        _state->_peak_data[2]._freq_hz,
-        _state->_peak_data[0]._noise_width_hz,
-        _state->_peak_data[1]._noise_width_hz,
-        _state->_peak_data[2]._noise_width_hz,
-        _state->_freq_bins[_state->_peak_data[0]._bin],
-        _state->_freq_bins[_state->_peak_data[1]._bin],
-        _state->_freq_bins[_state->_peak_data[2]._bin]);
+        _update_state->_peak_data[0]._freq_hz,
+        _update_state->_peak_data[1]._freq_hz,
+        _update_state->_peak_data[2]._freq_hz,
+        _update_state->_peak_data[0]._noise_width_hz,
+        _update_state->_peak_data[1]._noise_width_hz,
+        _update_state->_peak_data[2]._noise_width_hz,
+        _update_state->_freq_bins[_update_state->_peak_data[0]._bin],
+        _update_state->_freq_bins[_update_state->_peak_data[1]._bin],
+        _update_state->_freq_bins[_update_state->_peak_data[2]._bin]);
 #endif
+}
 
-    // move onto the next axis
-    _update_axis = (_update_axis + 1) % XYZ_AXIS_COUNT;
+// return the number of samples available for the next frame
+uint16_t AP_GyroFFT::get_frame_samples()
+{
+    if (!_all_axes) {
+        return get_available_samples(_update_axis);
+    }
+    // all axes are analysed together so wait for the slowest
+    uint16_t samples = get_available_samples(0);
+    for (uint8_t axis = 1; axis < XYZ_AXIS_COUNT; axis++) {
+        samples = MIN(samples, get_available_samples(axis));
+    }
+    return samples;
+}
 
-    // ready to receive another frame, because lock contention is so expensive we don't lock
-    // around this flag but rather rely on the semaphore at the beginning of the loop to
-    // ensure eventual visibility to the main loop
-    _thread_state._analysis_started = false;
+// decide whether the next frame on the current axis can track the detected peaks or needs a full FFT
+// called from FFT thread
+void AP_GyroFFT::update_tracking_state(bool tracking, uint8_t last_health, const EngineConfig& config)
+{
+    const uint8_t health = _thread_state._health[_update_axis];
 
-    // samples remaining in the next axis
-    return get_available_samples(_update_axis);
+    if (!tracking) {
+        // only start tracking once noise is calibrated and there are peaks to lock onto
+        if (!using_peak_tracking() || _thread_state._noise_needs_calibration || health == 0) {
+            _tracking_cycles[_update_axis] = 0;
+            return;
+        }
+        for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
+            _tracking_bins[_update_axis][i] = _update_state->_peak_data[i]._bin;
+        }
+        _tracking_cycles[_update_axis] = FFT_TRACKING_FULL_CYCLES;
+        return;
+    }
+
+    // the center peak has dropped below the SNR threshold or a peak has been lost,
+    // it may have moved too far so search again
+    if (_thread_state._center_freq_snr[FrequencyPeak::CENTER][_update_axis] < config._snr_threshold_db
+        || health < last_health) {
+        _tracking_cycles[_update_axis] = 0;
+        return;
+    }
+
+    _tracking_cycles[_update_axis]--;
 }
 
 // whether analysis can be run again or not
@@ -517,7 +646,7 @@ bool AP_GyroFFT::start_analysis() {
         return false;
     }
 
-    if (get_available_samples(_update_axis) >= _state->_window_size) {
+    if (get_frame_samples() >= _state->_window_size) {
         _thread_state._analysis_started = true;
         return true;
     }
@@ -701,6 +830,12 @@ void AP_GyroFFT::start_notch_tune()
     if (!hal.dsp->fft_start_average(_state)) {
         gcs().send_text(MAV_SEVERITY_WARNING, "FFT: Unable to start FFT averaging");
     }
+    // when analysing all axes together each engine averages its own axis
+    if (_all_axes) {
+        for (uint8_t axis = 1; axis < XYZ_AXIS_COUNT; axis++) {
+            hal.dsp->fft_start_average(_axis_state[axis]);
+        }
+    }
     // throttle averaging for average fft calculation
     _avg_throttle_out = 0.0f;
 #if APM_BUILD_COPTER_OR_HELI || APM_BUILD_TYPE(APM_BUILD_ArduPlane)
@@ -745,6 +880,22 @@ void AP_GyroFFT::stop_notch_tune()
 
     float freqs[FrequencyPeak::MAX_TRACKED_PEAKS] {};
 
+    // combine the averages from all the engines so that the result covers all axes
+    if (_all_axes) {
+        for (uint8_t axis = 1; axis < XYZ_AXIS_COUNT; axis++) {
+            AP_HAL::DSP::FFTWindowState* state = _axis_state[axis];
+            if (state->_averaging && _state->_averaging && _state->_avg_freq_bins != nullptr) {
+                for (uint16_t i = 0; i < _state->_bin_count; i++) {
+                    _state->_avg_freq_bins[i] += state->_avg_freq_bins[i];
+                }
+                _state->_averaging_samples += state->_averaging_samples;
+            }
+            // the peaks of the individual axes are not used, but stopping resets the averaging state
+            float axis_freqs[FrequencyPeak::MAX_TRACKED_PEAKS] {};
+            hal.dsp->fft_stop_average(state, _config._fft_start_bin, _config._fft_end_bin, axis_freqs);
+        }
+    }
+
     uint16_t numpeaks = hal.dsp->fft_stop_average(_state, _config._fft_start_bin, _config._fft_end_bin, freqs);
 
     if (numpeaks == 0) {
@@ -1074,7 +1225,7 @@ void AP_GyroFFT::calculate_noise(bool calibrating, const EngineConfig& config)
 
     uint8_t num_peaks = calculate_tracking_peaks(weighted_center_freq_hz, calibrating, config);
 
-    _thread_state._center_freq_bin[_update_axis] = _state->_peak_data[_thread_state._center_peak[_update_axis]]._bin;
+    _thread_state._center_freq_bin[_update_axis] = _update_state->_peak_data[_thread_state._center_peak[_update_axis]]._bin;
     _thread_state._center_freq_hz[_update_axis] = weighted_center_freq_hz;
     // record the last time we had a good signal on this axis
     if (num_peaks > 0) {
@@ -1121,10 +1272,10 @@ void AP_GyroFFT::calculate_noise(bool calibrating, const EngineConfig& config)
 #if DEBUG_FFT
     WITH_SEMAPHORE(_sem);
     _debug_state = _thread_state;
-    _debug_max_freq_bin = _state->get_freq_bin(_state->_peak_data[FrequencyPeak::CENTER]._bin);
-    _debug_max_bin_freq = _state->_peak_data[FrequencyPeak::CENTER]._freq_hz;
+    _debug_max_freq_bin = _update_state->get_freq_bin(_update_state->_peak_data[FrequencyPeak::CENTER]._bin);
+    _debug_max_bin_freq = _update_state->_peak_data[FrequencyPeak::CENTER]._freq_hz;
     _debug_snr = snr;
-    _debug_max_bin = _state->_peak_data[FrequencyPeak::CENTER]._bin;
+    _debug_max_bin = _update_state->_peak_data[FrequencyPeak::CENTER]._bin;
 #endif
 }
 
@@ -1151,9 +1302,9 @@ uint8_t AP_GyroFFT::calculate_tracking_peaks(float& weighted_center_freq_hz, boo
         num_peaks = calculate_tracking_peaks(weighted_center_freq_hz, freqs, config);
 #if DEBUG_FFT
         printf("Skipped update, order would have been is %d/%.1f(%.1f) %d/%.1f(%.1f) %d/%.1f(%.1f) n = %d\n",
-            center, _state->_peak_data[center]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis),
-            lower, _state->_peak_data[lower]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::LOWER_SHOULDER, _update_axis),
-            upper, _state->_peak_data[upper]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::UPPER_SHOULDER, _update_axis), num_peaks);
+            center, _update_state->_peak_data[center]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis),
+            lower, _update_state->_peak_data[lower]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::LOWER_SHOULDER, _update_axis),
+            upper, _update_state->_peak_data[upper]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::UPPER_SHOULDER, _update_axis), num_peaks);
 #endif
         return num_peaks;
     }
@@ -1231,13 +1382,13 @@ bool AP_GyroFFT::calculate_filtered_noise(FrequencyPeak target_peak, FrequencyPe
         return false;
     }
 
-    AP_HAL::DSP::FrequencyPeakData* peak_data = &_state->_peak_data[source_peak];
+    AP_HAL::DSP::FrequencyPeakData* peak_data = &_update_state->_peak_data[source_peak];
 
     const uint16_t nb = peak_data->_bin;
 
     if (freqs.is_valid(FrequencyPeak(source_peak))) {
         // total peak energy requires an integration, as an approximation use amplitude * noise width * 5/6
-        update_tl_center_freq_energy(target_peak, _update_axis, _state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);
+        update_tl_center_freq_energy(target_peak, _update_axis, _update_state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);
         update_tl_noise_center_bandwidth_hz(target_peak, _update_axis, peak_data->_noise_width_hz);
         update_tl_noise_center_freq_hz(target_peak, _update_axis, freqs.get_weighted_frequency(FrequencyPeak(source_peak)));
         _missed_cycles[_update_axis][target_peak] = 0;
@@ -1250,7 +1401,7 @@ bool AP_GyroFFT::calculate_filtered_noise(FrequencyPeak target_peak, FrequencyPe
     }
 
     // we failed to find a signal for more than FFT_MAX_MISSED_UPDATES cycles
-    update_tl_center_freq_energy(target_peak, _update_axis, _state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);     // use the actual energy detected rather than 0
+    update_tl_center_freq_energy(target_peak, _update_axis, _update_state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);     // use the actual energy detected rather than 0
     update_tl_noise_center_bandwidth_hz(target_peak, _update_axis, _bandwidth_hover_hz);
     update_tl_noise_center_freq_hz(target_peak, _update_axis, config._fft_min_hz);
 
@@ -1289,17 +1440,17 @@ AP_GyroFFT::FrequencyData::FrequencyData(const AP_GyroFFT& gyrofft, const Engine
 // calculate noise frequencies from FFT data provided by the HAL subsystem
 bool AP_GyroFFT::get_weighted_frequency(FrequencyPeak peak, float& weighted_peak_freq_hz, float& snr, const EngineConfig& config) const
 {
-    AP_HAL::DSP::FrequencyPeakData* peak_data = &_state->_peak_data[peak];
+    AP_HAL::DSP::FrequencyPeakData* peak_data = &_update_state->_peak_data[peak];
 
     const uint16_t bin = peak_data->_bin;
 
     // calculate the SNR and center frequency energy
-    const float max_energy = MAX(1.0f, _state->get_freq_bin(bin));
+    const float max_energy = MAX(1.0f, _update_state->get_freq_bin(bin));
     const float ref_energy = MAX(1.0f, _ref_energy[bin][_update_axis]);
     snr = 10.f * (log10f(max_energy) - log10f(ref_energy));
 
     // if the bin energy is above the noise threshold then we have a signal
-    if (!_thread_state._noise_needs_calibration && isfinite(_state->get_freq_bin(bin)) && snr > config._snr_threshold_db) {
+    if (!_thread_state._noise_needs_calibration && isfinite(_update_state->get_freq_bin(bin)) && snr > config._snr_threshold_db) {
         weighted_peak_freq_hz = constrain_float(peak_data->_freq_hz, (float)config._fft_min_hz, (float)config._fft_max_hz);
         return true;
     }
@@ -1354,11 +1505,11 @@ void AP_GyroFFT::update_ref_energy(uint16_t max_bin)
     // according to https://www.tcd.ie/Physics/research/groups/magnetism/files/lectures/py5021/MagneticSensors3.pdf sensor noise is not necessarily gaussian
     // determine a PS noise reference at each of the possible center frequencies
     if (_noise_cycles == 0 && _noise_calibration_cycles[_update_axis] > 0) {
-        for (uint16_t i = 1; i < _state->_bin_count; i++) {
-            _ref_energy[i][_update_axis] += _state->get_freq_bin(i);
+        for (uint16_t i = 1; i < _update_state->_bin_count; i++) {
+            _ref_energy[i][_update_axis] += _update_state->get_freq_bin(i);
         }
         if (--_noise_calibration_cycles[_update_axis] == 0) {
-            for (uint16_t i = 1; i < _state->_bin_count; i++) {
+            for (uint16_t i = 1; i < _update_state->_bin_count; i++) {
                 const float cycles = (static_cast<float>(_window_size) / static_cast<float>(_samples_per_frame)) * 2;
                 // overall random noise is reduced by sqrt(N) when averaging periodigrams so adjust for that
                 _ref_energy[i][_update_axis] = (_ref_energy[i][_update_axis] / cycles) * sqrtf(cycles);
@@ -40,7 +40,9 @@ public:
 
     enum class Options : uint32_t {
         FFTPostFilter = 1 << 0,
-        ESCNoiseCheck = 1 << 1
+        ESCNoiseCheck = 1 << 1,
+        PeakTracking = 1 << 2,
+        AllAxes = 1 << 3
     };
 
     AP_GyroFFT();
@@ -111,6 +113,10 @@ public:
     bool using_post_filter_samples() const { return (_options & uint32_t(Options::FFTPostFilter)) != 0; }
     // post filter mask of IMUs
     bool check_esc_noise() const { return (_options & uint32_t(Options::ESCNoiseCheck)) != 0; }
+    // track known peaks between full FFT frames
+    bool using_peak_tracking() const { return (_options & uint32_t(Options::PeakTracking)) != 0; }
+    // analyse all axes in every frame
+    bool using_all_axes() const { return (_options & uint32_t(Options::AllAxes)) != 0; }
     // look for a frequency in the detected noise
     float has_noise_at_frequency_hz(float freq) const;
     static float calculate_notch_frequency(float* freqs, uint16_t numpeaks, float harmonic_fit, uint8_t& harmonics);
@@ -220,6 +226,14 @@ private:
     bool analysis_enabled() const { return _initialized && _analysis_enabled && _thread_created; };
     // whether analysis can be run again or not
     bool start_analysis();
+    // return the gyro window for an axis ready for analysis
+    FloatBuffer& get_gyro_window(uint8_t axis);
+    // update the peak frequency and associated metrics for the current axis
+    void update_axis(uint16_t bin_max, bool tracking, const EngineConfig& config, uint32_t start_us);
+    // return samples available for the next frame
+    uint16_t get_frame_samples();
+    // decide whether the next frame can track the detected peaks
+    void update_tracking_state(bool tracking, uint8_t last_health, const EngineConfig& config);
     // return samples available in the gyro window
     uint16_t get_available_samples(uint8_t axis) {
         return _sample_mode == 0 ?_ins->get_raw_gyro_window(axis).available() : _downsampled_gyro_data[axis].available();
@@ -283,8 +297,18 @@ private:
 
     // state of the FFT engine
     AP_HAL::DSP::FFTWindowState* _state;
+    // state of the FFT engine for the axis being updated, only differs from _state when analysing all axes together
+    AP_HAL::DSP::FFTWindowState* _update_state;
+    // per-axis FFT engines when analysing all axes together, the first is _state
+    AP_HAL::DSP::FFTWindowState* _axis_state[XYZ_AXIS_COUNT];
+    // whether all axes are analysed in every frame
+    bool _all_axes;
     // update state machine step information
     uint8_t _update_axis;
+    // peak bins being tracked on each axis between full FFT frames
+    uint16_t _tracking_bins[XYZ_AXIS_COUNT][FrequencyPeak::MAX_TRACKED_PEAKS];
+    // number of tracking frames remaining on each axis before a full FFT is required
+    uint8_t _tracking_cycles[XYZ_AXIS_COUNT];
     // noise base of the gyros
     Vector3f* _ref_energy;
     // the number of cycles required to have a proper noise reference
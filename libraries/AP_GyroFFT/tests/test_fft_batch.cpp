@@ -0,0 +1,63 @@
+#include <AP_gtest.h>
+#include <AP_HAL/HAL.h>
+#include <AP_HAL/Util.h>
+#include <AP_GyroFFT/AP_GyroFFT.h>
+#include <stdio.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_WITH_DSP
+
+#define WINDOW_SIZE 64
+#define SAMPLE_RATE 1000
+#define START_BIN   2
+#define END_BIN     30
+
+static void fill_window(FloatBuffer& samples, float freq, float amplitude)
+{
+    samples.clear();
+    for (uint16_t i = 0; i < WINDOW_SIZE; i++) {
+        samples.push(sinf(2.0f * M_PI * freq * i / SAMPLE_RATE) * amplitude + 0.5f);
+    }
+}
+
+// a batched analysis of three axes should give the same answer as analysing each axis separately
+TEST(fft_batch_Test, MatchesSingle)
+{
+    const float freqs[XYZ_AXIS_COUNT] { 120.0f, 210.0f, 77.0f };
+    AP_HAL::DSP::FFTWindowState* states[XYZ_AXIS_COUNT];
+    FloatBuffer* samples[XYZ_AXIS_COUNT];
+    uint16_t single_bins[XYZ_AXIS_COUNT];
+    float single_freqs[XYZ_AXIS_COUNT];
+    float single_energy[XYZ_AXIS_COUNT];
+
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        states[axis] = hal.dsp->fft_init(WINDOW_SIZE, SAMPLE_RATE);
+        ASSERT_NE(states[axis], nullptr);
+        samples[axis] = new FloatBuffer(WINDOW_SIZE);
+        fill_window(*samples[axis], freqs[axis], 10.0f + axis);
+
+        hal.dsp->fft_start(states[axis], *samples[axis], 0);
+        single_bins[axis] = hal.dsp->fft_analyse(states[axis], START_BIN, END_BIN, 0.03f);
+        single_freqs[axis] = states[axis]->_peak_data[AP_HAL::DSP::CENTER]._freq_hz;
+        single_energy[axis] = states[axis]->_freq_bins[single_bins[axis]];
+    }
+
+    uint16_t batch_bins[XYZ_AXIS_COUNT];
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        hal.dsp->fft_start(states[axis], *samples[axis], 0);
+    }
+    hal.dsp->fft_analyse_batch(states, XYZ_AXIS_COUNT, START_BIN, END_BIN, 0.03f, batch_bins);
+
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        EXPECT_EQ(batch_bins[axis], single_bins[axis]);
+        EXPECT_NEAR(states[axis]->_peak_data[AP_HAL::DSP::CENTER]._freq_hz, single_freqs[axis], 0.1f);
+        EXPECT_NEAR(states[axis]->_freq_bins[batch_bins[axis]], single_energy[axis], single_energy[axis] * 1e-3f);
+        delete states[axis];
+        delete samples[axis];
+    }
+}
+
+#endif // HAL_WITH_DSP
+
+AP_GTEST_MAIN()
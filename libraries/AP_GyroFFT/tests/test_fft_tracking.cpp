@@ -0,0 +1,83 @@
+#include <AP_gtest.h>
+#include <AP_HAL/HAL.h>
+#include <AP_HAL/Util.h>
+#include <AP_GyroFFT/AP_GyroFFT.h>
+#include <stdio.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_WITH_DSP
+
+#define WINDOW_SIZE 128
+#define SAMPLE_RATE 1000
+#define START_BIN   2
+#define END_BIN     60
+
+static void fill_window(FloatBuffer& samples, float freq1, float freq2)
+{
+    samples.clear();
+    for (uint16_t i = 0; i < WINDOW_SIZE; i++) {
+        samples.push(sinf(2.0f * M_PI * freq1 * i / SAMPLE_RATE) * 20.0f + sinf(2.0f * M_PI * freq2 * i / SAMPLE_RATE) * 8.0f);
+    }
+}
+
+// tracking the peaks found by a full FFT should give the same answer as a full FFT
+TEST(fft_tracking_Test, MatchesFullFFT)
+{
+    AP_HAL::DSP::FFTWindowState* state = hal.dsp->fft_init(WINDOW_SIZE, SAMPLE_RATE);
+    ASSERT_NE(state, nullptr);
+    FloatBuffer samples(WINDOW_SIZE);
+
+    // lock onto the peaks
+    fill_window(samples, 180.0f, 90.0f);
+    hal.dsp->fft_start(state, samples, 0);
+    hal.dsp->fft_analyse(state, START_BIN, END_BIN, 0.03f);
+
+    uint16_t peak_bins[AP_HAL::DSP::MAX_TRACKED_PEAKS];
+    for (uint8_t i = 0; i < AP_HAL::DSP::MAX_TRACKED_PEAKS; i++) {
+        peak_bins[i] = state->_peak_data[i]._bin;
+    }
+
+    // move the peaks by around a bin and compare tracking against a full FFT
+    fill_window(samples, 187.0f, 94.0f);
+    hal.dsp->fft_start(state, samples, 0);
+    const uint16_t full_bin = hal.dsp->fft_analyse(state, START_BIN, END_BIN, 0.03f);
+    AP_HAL::DSP::FrequencyPeakData full_peaks[AP_HAL::DSP::MAX_TRACKED_PEAKS];
+    memcpy(full_peaks, state->_peak_data, sizeof(full_peaks));
+    const float full_energy = state->_freq_bins[full_bin];
+
+    const uint16_t tracked_bin = hal.dsp->fft_track(state, samples, 0, peak_bins, START_BIN, END_BIN, 0.03f);
+    EXPECT_EQ(tracked_bin, full_bin);
+    EXPECT_NEAR(state->_freq_bins[tracked_bin], full_energy, full_energy * 1e-3f);
+    EXPECT_NEAR(state->_peak_data[AP_HAL::DSP::CENTER]._freq_hz, full_peaks[AP_HAL::DSP::CENTER]._freq_hz, 0.1f);
+    EXPECT_NEAR(state->_peak_data[AP_HAL::DSP::CENTER]._freq_hz, 187.0f, state->_bin_resolution * 0.5f);
+
+    // the lower peak should also have been followed
+    for (uint8_t i = 1; i < AP_HAL::DSP::MAX_TRACKED_PEAKS; i++) {
+        if (full_peaks[i]._bin == peak_bins[i]) {
+            EXPECT_NEAR(state->_peak_data[i]._freq_hz, full_peaks[i]._freq_hz, 0.1f);
+        }
+    }
+
+    delete state;
+}
+
+// averaging needs every bin so tracking must be refused
+TEST(fft_tracking_Test, RefusedWhenAveraging)
+{
+    AP_HAL::DSP::FFTWindowState* state = hal.dsp->fft_init(WINDOW_SIZE, SAMPLE_RATE, 4);
+    ASSERT_NE(state, nullptr);
+    FloatBuffer samples(WINDOW_SIZE);
+    fill_window(samples, 180.0f, 90.0f);
+
+    uint16_t peak_bins[AP_HAL::DSP::MAX_TRACKED_PEAKS] { 23, 12, 30 };
+    EXPECT_EQ(hal.dsp->fft_track(state, samples, 0, peak_bins, START_BIN, END_BIN, 0.03f), 0U);
+    // the samples must not have been consumed
+    EXPECT_EQ(samples.available(), uint32_t(WINDOW_SIZE));
+
+    delete state;
+}
+
+#endif // HAL_WITH_DSP
+
+AP_GTEST_MAIN()
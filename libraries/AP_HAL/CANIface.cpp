@@ -85,6 +85,27 @@ int16_t AP_HAL::CANIface::send(const CANFrame& frame, uint64_t tx_deadline, CanI
     return 1;
 }
 
+/*
+  send a batch of frames one at a time
+ */
+int16_t AP_HAL::CANIface::send_batch(const CanTxItem *items, uint16_t num_items, CanIOFlags flags)
+{
+    uint16_t i;
+    for (i = 0; i < num_items; i++) {
+        bool read_select = false;
+        bool write_select = true;
+        select(read_select, write_select, &items[i].frame, 0);
+        if (!write_select) {
+            break;
+        }
+        const int16_t ret = send(items[i].frame, items[i].deadline, flags);
+        if (ret <= 0) {
+            return i > 0 ? i : ret;
+        }
+    }
+    return i;
+}
+
 /*
   register a callback for for sending CAN_FRAME messages
  */
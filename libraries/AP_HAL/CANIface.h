@@ -196,6 +196,13 @@ public:
     // must be called on child class
     virtual int16_t send(const CANFrame& frame, uint64_t tx_deadline, CanIOFlags flags);
 
+    // Put a batch of frames in queue to be sent, in order, stopping at the first
+    // frame there is no space for. Returns the number of frames accepted, or
+    // negative if an error occurred before any frame was accepted. The default
+    // calls send() for each frame, backends which can queue several frames more
+    // cheaply than one at a time should override this
+    virtual int16_t send_batch(const CanTxItem *items, uint16_t num_items, CanIOFlags flags);
+
     // Non blocking receive frame that pops the frames received inside the buffer, return negative if error occurred, 
     // 0 if no frame available, 1 if successful
     // must be called on child class
@@ -187,6 +187,102 @@ uint16_t DSP::step_calc_frequencies(FFTWindowState* fft, uint16_t start_bin, uin
     return fft->_peak_data[CENTER]._bin;
 }
 
+// perform several FFT analyses, backends that can share work between the transforms should override this
+void DSP::fft_analyse_batch(FFTWindowState** states, uint8_t count, uint16_t start_bin, uint16_t end_bin,
+    float noise_att_cutoff, uint16_t* bins)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        bins[i] = fft_analyse(states[i], start_bin, end_bin, noise_att_cutoff);
+    }
+}
+
+// track previously detected peaks by only calculating the bins around each of them using the Goertzel algorithm
+// once the peaks are known this is much cheaper than a full FFT plus peak search, the results in _freq_bins and
+// _rfft_data are identical to the full FFT for the bins that are calculated, all other bins are zero
+// peak_bins holds the bins to track on entry and the updated bins on exit
+// returns the center peak bin or 0 if tracking is not possible and a full FFT is required
+uint16_t DSP::fft_track(FFTWindowState* fft, FloatBuffer& samples, uint16_t advance, uint16_t* peak_bins,
+    uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
+{
+    // averaging requires every bin
+    if (fft->_sliding_window != nullptr || fft->_averaging) {
+        return 0;
+    }
+
+    // windowed samples are now in _freq_bins
+    fft_start(fft, samples, advance);
+
+    // _derivative_freq_bins is used as scratch space for the bin power, negative means not yet calculated
+    float* power = fft->_derivative_freq_bins;
+    for (uint16_t i = 0; i < fft->_num_stored_freqs; i++) {
+        power[i] = -1.0f;
+    }
+
+    // calculate two bins either side of each peak, this allows the peak to move by one bin and still
+    // have the neighbouring complex values required by the frequency interpolator
+    for (uint8_t i = 0; i < MAX_TRACKED_PEAKS; i++) {
+        peak_bins[i] = constrain_int16(peak_bins[i], start_bin, end_bin);
+        const uint16_t lower = peak_bins[i] > 2 ? peak_bins[i] - 2 : 0;
+        const uint16_t upper = MIN(peak_bins[i] + 2, fft->_bin_count);
+        for (uint16_t b = lower; b <= upper; b++) {
+            if (power[b] >= 0.0f) {
+                continue;
+            }
+            float& real = fft->_rfft_data[b * 2];
+            float& imag = fft->_rfft_data[b * 2 + 1];
+            calculate_goertzel(fft, b, real, imag);
+            power[b] = sq(real) + sq(imag);
+        }
+    }
+
+    // replace the time domain data with the scaled power so that the rest of the pipeline sees normal FFT output
+    for (uint16_t i = 0; i < fft->_num_stored_freqs; i++) {
+        fft->_freq_bins[i] = MAX(power[i], 0.0f) * fft->_window_scale;
+    }
+
+    for (uint8_t i = 0; i < MAX_TRACKED_PEAKS; i++) {
+        const uint16_t bin = peak_bins[i];
+        // the peak may have drifted into an adjacent bin
+        uint16_t peak = bin;
+        if (bin > start_bin && fft->_freq_bins[bin - 1] > fft->_freq_bins[peak]) {
+            peak = bin - 1;
+        }
+        if (bin < end_bin && fft->_freq_bins[bin + 1] > fft->_freq_bins[peak]) {
+            peak = bin + 1;
+        }
+        // the width is limited to the calculated bins
+        uint16_t top = 0, bottom = 0;
+        fft->_peak_data[i]._bin = peak;
+        fft->_peak_data[i]._noise_width_hz = find_noise_width(fft->_freq_bins, MAX(bin - 2, start_bin), MIN(bin + 2, end_bin),
+            peak, noise_att_cutoff, fft->_bin_resolution, top, bottom);
+        fft->_peak_data[i]._freq_hz = calc_frequency(fft, start_bin, peak, end_bin);
+        peak_bins[i] = peak;
+    }
+
+    return fft->_peak_data[CENTER]._bin;
+}
+
+// calculate a single DFT bin of the windowed samples held in _freq_bins using the Goertzel algorithm
+// see https://en.wikipedia.org/wiki/Goertzel_algorithm
+void DSP::calculate_goertzel(const FFTWindowState* fft, uint16_t bin, float& real, float& imag) const
+{
+    const float w = 2.0f * M_PI * bin / fft->_window_size;
+    const float cosw = cosf(w);
+    const float sinw = sinf(w);
+    const float coeff = 2.0f * cosw;
+    float s1 = 0.0f;
+    float s2 = 0.0f;
+    for (uint16_t i = 0; i < fft->_window_size; i++) {
+        const float s0 = fft->_freq_bins[i] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    // a final iteration with zero input aligns the phase with the DFT output so that interpolation works
+    const float s0 = coeff * s1 - s2;
+    real = s0 - cosw * s1;
+    imag = sinw * s1;
+}
+
 void DSP::update_average_from_sliding_window(FFTWindowState* fft)
 {
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
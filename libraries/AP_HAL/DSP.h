@@ -96,6 +96,13 @@ public:
     virtual void fft_start(FFTWindowState* state, FloatBuffer& samples, uint16_t advance) = 0;
     // perform remaining steps of an FFT analysis
     virtual uint16_t fft_analyse(FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff) = 0;
+    // perform remaining steps of several FFT analyses of the same size at once, e.g. one per gyro axis
+    // the center peak bin of each analysis is returned in bins
+    virtual void fft_analyse_batch(FFTWindowState** states, uint8_t count, uint16_t start_bin, uint16_t end_bin,
+        float noise_att_cutoff, uint16_t* bins);
+    // track known peaks using only the bins around them, returns 0 if a full analysis is required instead
+    uint16_t fft_track(FFTWindowState* state, FloatBuffer& samples, uint16_t advance, uint16_t* peak_bins,
+        uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff);
     // start averaging FFT data
     bool fft_start_average(FFTWindowState* fft);
     // finish the averaging process
@@ -109,6 +116,8 @@ protected:
         float bin_resolution, uint16_t& peak_top, uint16_t& peak_bottom) const;
     // step 4: find the bin with the highest energy and interpolate the required frequency
     uint16_t step_calc_frequencies(FFTWindowState* fft, uint16_t start_bin, uint16_t end_bin);
+    // calculate a single DFT bin of the windowed samples
+    void calculate_goertzel(const FFTWindowState* fft, uint16_t bin, float& real, float& imag) const;
     // calculate the final average output
     void update_average_from_sliding_window(FFTWindowState* fft);
     // calculate a single frequency
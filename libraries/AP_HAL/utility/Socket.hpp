@@ -72,6 +72,11 @@ public:
         return fd_in != -1? fd_in : fd;
     }
 
+    // get the FD used for sending
+    int get_write_fd(void) const {
+        return fd;
+    }
+
     // create a new socket with same fd, but new memory
     // the old socket gets fd of -1
     SOCKET_CLASS_NAME *duplicate(void);
@@ -36,10 +36,14 @@
 #include <sys/ioctl.h>
 #include <net/if.h>
 #include <linux/can/raw.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <time.h>
 #include <cstring>
 #include "Scheduler.h"
 #include <AP_CANManager/AP_CANManager.h>
 #include <AP_Common/ExpandingString.h>
+#include <AP_Math/AP_Math.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -123,8 +127,11 @@ int CANIface::_openSocket(const std::string& iface_name)
     // Configure
     {
         const int on = 1;
-        // Timestamping
-        if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
+        // Kernel timestamps of received frames, falling back to
+        // SO_TIMESTAMP on kernels without SO_TIMESTAMPING
+        const int ts_flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)) < 0 &&
+            setsockopt(s, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
             return -1;
         }
         // Socket loopback
@@ -151,8 +158,8 @@ int CANIface::_openSocket(const std::string& iface_name)
     return ret;
 }
 
-int16_t CANIface::send(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline,
-                       const CANIface::CanIOFlags flags)
+void CANIface::_queueTx(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline,
+                        const CANIface::CanIOFlags flags)
 {
     CanTxItem tx_item {};
     tx_item.frame = frame;
@@ -165,32 +172,65 @@ int16_t CANIface::send(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline
     tx_item.setup = true;
     tx_item.index = _tx_frame_counter;
     tx_item.deadline = tx_deadline;
-    WITH_SEMAPHORE(sem);
     _tx_queue.emplace(tx_item);
     _tx_frame_counter++;
     stats.tx_requests++;
+}
+
+int16_t CANIface::send(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline,
+                       const CANIface::CanIOFlags flags)
+{
+    WITH_SEMAPHORE(sem);
+    _queueTx(frame, tx_deadline, flags);
     _pollRead();     // Read poll is necessary because it can release the pending TX flag
     _pollWrite();
     return AP_HAL::CANIface::send(frame, tx_deadline, flags);
 }
 
+/*
+  queue a batch of frames under one lock and poll the socket once
+  rather than once per frame
+ */
+int16_t CANIface::send_batch(const CanTxItem *items, uint16_t num_items,
+                             const CANIface::CanIOFlags flags)
+{
+    WITH_SEMAPHORE(sem);
+    if (_down) {
+        // select() doesn't allow writes while the interface is down
+        return 0;
+    }
+    for (uint16_t i = 0; i < num_items; i++) {
+        _queueTx(items[i].frame, items[i].deadline, flags);
+    }
+    _pollRead();
+    _pollWrite();
+    for (uint16_t i = 0; i < num_items; i++) {
+        AP_HAL::CANIface::send(items[i].frame, items[i].deadline, flags);
+    }
+    return num_items;
+}
+
 int16_t CANIface::receive(AP_HAL::CANFrame& out_frame, uint64_t& out_timestamp_us,
                           CANIface::CanIOFlags& out_flags)
 {
     WITH_SEMAPHORE(sem);
-    if (_rx_queue.empty()) {
+    CanRxItem rx;
+    if (!_rx_queue.pop(rx)) {
         _pollRead();            // This allows to use the socket not calling poll() explicitly.
-        if (_rx_queue.empty()) {
+        if (!_rx_queue.pop(rx)) {
             return 0;
         }
     }
-    {
-        const CanRxItem& rx = _rx_queue.front();
-        out_frame        = rx.frame;
-        out_timestamp_us = rx.timestamp_us;
-        out_flags        = rx.flags;
-    }
-    (void)_rx_queue.pop();
+    out_frame        = rx.frame;
+    out_timestamp_us = rx.timestamp_us;
+    out_flags        = rx.flags;
+
+    // time from the kernel receiving the frame to it being taken
+    const uint32_t latency_us = AP_HAL::micros64() - rx.timestamp_us;
+    stats.rx_latency_count++;
+    stats.rx_latency_us += latency_us;
+    stats.rx_latency_max_us = MAX(stats.rx_latency_max_us, latency_us);
+
     if (sem_handle != nullptr) {
         sem_handle->signal();
     }
@@ -205,8 +245,7 @@ bool CANIface::_hasReadyTx()
 
 bool CANIface::_hasReadyRx()
 {
-    WITH_SEMAPHORE(sem);
-    return !_rx_queue.empty();
+    return !_rx_queue.is_empty();
 }
 
 void CANIface::_poll(bool read, bool write)
@@ -269,130 +308,217 @@ void CANIface::_pollWrite()
 {
     while (_hasReadyTx()) {
         WITH_SEMAPHORE(sem);
-        const CanTxItem tx = _tx_queue.top();
-        uint64_t curr_time = AP_HAL::micros64();
-        if (tx.deadline >= curr_time) {
-            // hal.console->printf("%x TDEAD: %lu CURRT: %lu DEL: %lu\n",tx.frame.id,  tx.deadline, curr_time, tx.deadline-curr_time);
-            const int res = _write(tx.frame);
-            if (res == 1) {                   // Transmitted successfully
-                _incrementNumFramesInSocketTxQueue();
-                if (tx.loopback) {
-                    _pending_loopback_ids.insert(tx.frame.id);
-                }
-                stats.tx_success++;
-                stats.last_transmit_us = curr_time;
-            } else if (res == 0) {            // Not transmitted, nor is it an error
-                stats.tx_overflow++;
-                break;                        // Leaving the loop, the frame remains enqueued for the next retry
-            } else {                          // Transmission error
-                stats.tx_rejected++;
+        // take as many frames as there is room for in the socket and
+        // write them with a single call
+        CanTxItem batch[CAN_MAX_TX_BATCH];
+        const unsigned space = MIN(_max_frames_in_socket_tx_queue - _frames_in_socket_tx_queue,
+                                   ARRAY_SIZE(batch));
+        unsigned num_frames = 0;
+        const uint64_t curr_time = AP_HAL::micros64();
+        while (num_frames < space && !_tx_queue.empty()) {
+            const CanTxItem tx = _tx_queue.top();
+            (void)_tx_queue.pop();
+            if (tx.deadline >= curr_time) {
+                batch[num_frames++] = tx;
+            } else {
+                stats.tx_timedout++;
             }
-        } else {
-            // hal.console->printf("TDEAD: %lu CURRT: %lu DEL: %lu\n", tx.deadline, curr_time, curr_time-tx.deadline);
-            stats.tx_timedout++;
+        }
+        if (num_frames == 0) {
+            continue;
         }
 
-        // Removing the frame from the queue even if transmission failed
-        (void)_tx_queue.pop();
+        const int res = _write(batch, num_frames);
+        const unsigned num_sent = MAX(res, 0);
+        for (unsigned i = 0; i < num_sent; i++) {   // Transmitted successfully
+            _incrementNumFramesInSocketTxQueue();
+            if (batch[i].loopback) {
+                _pending_loopback_ids.insert(batch[i].frame.id);
+            }
+            stats.tx_success++;
+            stats.last_transmit_us = curr_time;
+        }
+        unsigned requeue_from = num_sent;
+        if (res < 0) {                              // Transmission error, drop the first frame
+            stats.tx_rejected++;
+            requeue_from = 1;
+        }
+        // the frames not written remain enqueued for the next retry,
+        // keeping their index so they stay in order
+        for (unsigned i = requeue_from; i < num_frames; i++) {
+            _tx_queue.push(batch[i]);
+        }
+        if (res == 0) {                             // Not transmitted, nor is it an error
+            stats.tx_overflow++;
+            break;
+        }
     }
 }
 
+/*
+  the socket is drained and the frames queued under one lock so that
+  two threads reading at once can't queue frames out of order
+ */
 bool CANIface::_pollRead()
 {
+    WITH_SEMAPHORE(sem);
+    bool accepted = false;
     uint8_t iterations_count = 0;
     while (iterations_count < CAN_MAX_POLL_ITERATIONS_COUNT)
     {
         iterations_count++;
-        CanRxItem rx;
-        rx.timestamp_us = AP_HAL::micros64();  // Monotonic timestamp is not required to be precise (unlike UTC)
-        bool loopback = false;
-        const int res = _read(rx.frame, rx.timestamp_us, loopback);
-        if (res == 1) {
+        CanRxItem rx[CAN_MAX_RX_BATCH];
+        bool loopback[CAN_MAX_RX_BATCH];
+        unsigned num_frames = 0;
+        const uint64_t start_us = AP_HAL::micros64();
+        const int res = _read(rx, loopback, ARRAY_SIZE(rx), num_frames);
+        if (res < 0) {
+            stats.rx_errors++;
+            break;
+        }
+        if (res == 0) {
+            break;
+        }
+        for (unsigned i = 0; i < num_frames; i++) {
             bool accept = true;
-            if (loopback) {           // We receive loopback for all CAN frames
+            if (loopback[i]) {        // We receive loopback for all CAN frames
                 _confirmSentFrame();
-                rx.flags |= Loopback;
-                accept = _wasInPendingLoopbackSet(rx.frame);
+                rx[i].flags |= Loopback;
+                accept = _wasInPendingLoopbackSet(rx[i].frame);
                 stats.tx_confirmed++;
             }
             if (accept) {
-                WITH_SEMAPHORE(sem);
-                _rx_queue.push(rx);
-                stats.rx_received++;
-                return true;
+                if (_rx_queue.push(rx[i])) {
+                    stats.rx_received++;
+                    accepted = true;
+                } else {
+                    stats.rx_overflow++;
+                }
             }
-        } else if (res == 0) {
-            break;
-        } else {
-            stats.rx_errors++;
+        }
+        stats.rx_syscalls++;
+        stats.rx_frames += res;
+        stats.rx_cpu_us += AP_HAL::micros64() - start_us;
+        if (unsigned(res) < ARRAY_SIZE(rx)) {
+            // socket is empty
             break;
         }
     }
-    return false;
+    return accepted;
 }
 
-int CANIface::_write(const AP_HAL::CANFrame& frame) const
+int CANIface::_write(const CanTxItem *items, unsigned num_items) const
 {
     if (_fd < 0) {
         return -1;
     }
-    errno = 0;
 
-    const can_frame sockcan_frame = makeSocketCanFrame(frame);
+    can_frame sockcan_frames[CAN_MAX_TX_BATCH];
+    iovec iov[CAN_MAX_TX_BATCH];
+    mmsghdr msgs[CAN_MAX_TX_BATCH] {};
+    num_items = MIN(num_items, ARRAY_SIZE(msgs));
+    for (unsigned i = 0; i < num_items; i++) {
+        sockcan_frames[i] = makeSocketCanFrame(items[i].frame);
+        iov[i].iov_base = &sockcan_frames[i];
+        iov[i].iov_len = sizeof(sockcan_frames[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
-    const int res = write(_fd, &sockcan_frame, sizeof(sockcan_frame));
+    errno = 0;
+    const int res = sendmmsg(_fd, msgs, num_items, 0);
     if (res <= 0) {
         if (errno == ENOBUFS || errno == EAGAIN) {  // Writing is not possible atm, not an error
             return 0;
         }
         return res;
     }
-    if (res != sizeof(sockcan_frame)) {
-        return -1;
-    }
-    return 1;
+    return res;
 }
 
 
-int CANIface::_read(AP_HAL::CANFrame& frame, uint64_t& timestamp_us, bool& loopback) const
+/*
+  return the kernel receive timestamp of a message on the realtime
+  clock, or 0 if there is none
+ */
+static uint64_t kernel_timestamp_us(msghdr &msg)
+{
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            scm_timestamping ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return ts.ts[0].tv_sec * 1000000ULL + ts.ts[0].tv_nsec / 1000U;
+        }
+        if (cmsg->cmsg_type == SCM_TIMESTAMP) {
+            timeval tv;
+            memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+            return tv.tv_sec * 1000000ULL + tv.tv_usec;
+        }
+    }
+    return 0;
+}
+
+int CANIface::_read(CanRxItem *rx, bool *loopback, unsigned max_frames, unsigned &num_frames) const
 {
+    num_frames = 0;
     if (_fd < 0) {
         return -1;
     }
-    auto iov = iovec();
-    auto sockcan_frame = can_frame();
-    iov.iov_base = &sockcan_frame;
-    iov.iov_len  = sizeof(sockcan_frame);
+    can_frame sockcan_frames[CAN_MAX_RX_BATCH];
+    iovec iov[CAN_MAX_RX_BATCH];
     union {
-        uint8_t data[CMSG_SPACE(sizeof(::timeval))];
+        uint8_t data[CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(::timeval))];
         struct cmsghdr align;
-    } control;
-
-    auto msg = msghdr();
-    msg.msg_iov    = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_control = control.data;
-    msg.msg_controllen = sizeof(control.data);
-
-    const int res = recvmsg(_fd, &msg, MSG_DONTWAIT);
+    } control[CAN_MAX_RX_BATCH];
+    mmsghdr msgs[CAN_MAX_RX_BATCH] {};
+    max_frames = MIN(max_frames, ARRAY_SIZE(msgs));
+    for (unsigned i = 0; i < max_frames; i++) {
+        iov[i].iov_base = &sockcan_frames[i];
+        iov[i].iov_len  = sizeof(sockcan_frames[i]);
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i].data;
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i].data);
+    }
+
+    const int res = recvmmsg(_fd, msgs, max_frames, MSG_DONTWAIT, nullptr);
     if (res <= 0) {
         return (res < 0 && errno == EWOULDBLOCK) ? 0 : res;
     }
-    /*
-     * Flags
-     */
-    loopback = (msg.msg_flags & static_cast<int>(MSG_CONFIRM)) != 0;
 
-    if (!loopback && !_checkHWFilters(sockcan_frame)) {
-        return 0;
-    }
-
-    frame = makeUavcanFrame(sockcan_frame);
     /*
-     * Timestamp
+     * Timestamp. The kernel timestamps are on the realtime clock, move
+     * them onto the AP_HAL::micros64() clock
      */
-    timestamp_us = AP_HAL::micros64();
-    return 1;
+    const uint64_t now_us = AP_HAL::micros64();
+    timespec ts_now;
+    clock_gettime(CLOCK_REALTIME, &ts_now);
+    const uint64_t realtime_us = ts_now.tv_sec * 1000000ULL + ts_now.tv_nsec / 1000U;
+
+    for (int i = 0; i < res; i++) {
+        msghdr &msg = msgs[i].msg_hdr;
+        /*
+         * Flags
+         */
+        const bool is_loopback = (msg.msg_flags & static_cast<int>(MSG_CONFIRM)) != 0;
+        if (!is_loopback && !_checkHWFilters(sockcan_frames[i])) {
+            continue;
+        }
+        CanRxItem &item = rx[num_frames];
+        item.frame = makeUavcanFrame(sockcan_frames[i]);
+        item.flags = 0;
+        item.timestamp_us = now_us;
+        const uint64_t kernel_us = kernel_timestamp_us(msg);
+        if (kernel_us != 0 && kernel_us <= realtime_us && realtime_us - kernel_us < 1000000U) {
+            item.timestamp_us = now_us - (realtime_us - kernel_us);
+        }
+        loopback[num_frames] = is_loopback;
+        num_frames++;
+    }
+    return res;
 }
 
 // Might block forever, only to be used for testing
@@ -409,8 +535,7 @@ void CANIface::clear_rx()
 {
     WITH_SEMAPHORE(sem);
     // Clean Rx Queue
-    std::queue<CanRxItem> empty;
-    std::swap( _rx_queue, empty );
+    _rx_queue.clear();
 }
 
 void CANIface::_incrementNumFramesInSocketTxQueue()
@@ -552,7 +677,12 @@ void CANIface::get_stats(ExpandingString &str)
                "num_tx_poll_req:  %u\n"
                "num_poll_waits:   %u\n"
                "num_poll_tx_events: %u\n"
-               "num_poll_rx_events: %u\n",
+               "num_poll_rx_events: %u\n"
+               "rx_overflow:    %u\n"
+               "rx_syscalls:    %u\n"
+               "rx_per_syscall: %.2f\n"
+               "rx_cpu_per_frame: %.2fus\n"
+               "rx_latency:     avg %uus max %uus\n",
                stats.tx_requests,
                stats.tx_rejected,
                stats.tx_overflow,
@@ -566,7 +696,13 @@ void CANIface::get_stats(ExpandingString &str)
                stats.num_tx_poll_req,
                stats.num_poll_waits,
                stats.num_poll_tx_events,
-               stats.num_poll_rx_events);
+               stats.num_poll_rx_events,
+               stats.rx_overflow,
+               stats.rx_syscalls,
+               stats.rx_syscalls ? float(stats.rx_frames) / stats.rx_syscalls : 0.0f,
+               stats.rx_frames ? float(stats.rx_cpu_us) / stats.rx_frames : 0.0f,
+               unsigned(stats.rx_latency_count ? stats.rx_latency_us / stats.rx_latency_count : 0),
+               unsigned(stats.rx_latency_max_us));
 }
 
 #endif
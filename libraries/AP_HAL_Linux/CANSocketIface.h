@@ -31,6 +31,7 @@
 #if HAL_NUM_CAN_IFACES
 
 #include <AP_HAL/CANIface.h>
+#include <AP_HAL/utility/RingBuffer.h>
 
 #include <linux/can.h>
 
@@ -53,6 +54,12 @@ enum class SocketCanError
 #define CAN_MAX_POLL_ITERATIONS_COUNT 100
 #define CAN_MAX_INIT_TRIES_COUNT 100
 #define CAN_FILTER_NUMBER 8
+#define CAN_MAX_TX_BATCH 8
+#define CAN_MAX_RX_BATCH 16
+
+#ifndef HAL_CAN_RX_QUEUE_SIZE
+#define HAL_CAN_RX_QUEUE_SIZE 512
+#endif
 
 class CANIface: public AP_HAL::CANIface {
 public:
@@ -72,6 +79,11 @@ public:
     int16_t send(const AP_HAL::CANFrame& frame, uint64_t tx_deadline,
                  CanIOFlags flags) override;
 
+    // Put a batch of frames into Tx FIFO, returns the number of frames
+    // queued
+    int16_t send_batch(const CanTxItem *items, uint16_t num_items,
+                       CanIOFlags flags) override;
+
     // Receive frame from Rx Buffer, returns negative on error, 0 on nothing available, 
     // 1 on successfully poping a frame
     int16_t receive(AP_HAL::CANFrame& out_frame, uint64_t& out_timestamp_us,
@@ -120,9 +132,16 @@ private:
 
     bool _pollRead();
 
-    int _write(const AP_HAL::CANFrame& frame) const;
+    void _queueTx(const AP_HAL::CANFrame& frame, uint64_t tx_deadline, CanIOFlags flags);
+
+    // write up to num_items frames to the socket, returns the number
+    // written, 0 if the socket is full or negative on error
+    int _write(const CanTxItem *items, unsigned num_items) const;
 
-    int _read(AP_HAL::CANFrame& frame, uint64_t& ts_usec, bool& loopback) const;
+    // read up to max_frames frames with one system call, returns the
+    // number read from the socket, 0 if there are none or negative on
+    // error. num_frames is set to the number which passed the filters
+    int _read(CanRxItem *rx, bool *loopback, unsigned max_frames, unsigned &num_frames) const;
 
     void _incrementNumFramesInSocketTxQueue();
 
@@ -159,7 +178,8 @@ private:
     pollfd _pollfd;
     std::map<SocketCanError, uint64_t> _errors;
     std::priority_queue<CanTxItem> _tx_queue;
-    std::queue<CanRxItem> _rx_queue;
+    // frames received, protected by sem
+    ObjectBuffer<CanRxItem> _rx_queue{HAL_CAN_RX_QUEUE_SIZE};
     std::unordered_multiset<uint32_t> _pending_loopback_ids;
     std::vector<can_filter> _hw_filters_container;
 
@@ -171,12 +191,18 @@ private:
         uint32_t num_poll_waits;
         uint32_t num_poll_tx_events;
         uint32_t num_poll_rx_events;
+        uint32_t rx_syscalls;
+        uint32_t rx_frames;
+        uint64_t rx_cpu_us;
+        uint32_t rx_latency_count;
+        uint32_t rx_latency_max_us;
+        uint64_t rx_latency_us;
     } stats;
 
 protected:
     bool add_to_rx_queue(const CanRxItem &rx_item) override {
-        _rx_queue.push(rx_item);
-        return true;
+        WITH_SEMAPHORE(sem);
+        return _rx_queue.push(rx_item);
     }
 
     int8_t get_iface_num(void) const override {
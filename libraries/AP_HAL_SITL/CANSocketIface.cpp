@@ -59,10 +59,9 @@ bool CANIface::is_initialized() const
     return transport != nullptr;
 }
 
-int16_t CANIface::send(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline,
-                       const CANIface::CanIOFlags flags)
+void CANIface::_queueTx(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline,
+                        const CANIface::CanIOFlags flags)
 {
-    WITH_SEMAPHORE(sem);
     CanTxItem tx_item {};
     tx_item.frame = frame;
     if (flags & Loopback) {
@@ -77,12 +76,42 @@ int16_t CANIface::send(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline
     _tx_queue.emplace(tx_item);
     _tx_frame_counter++;
     stats.tx_requests++;
+}
+
+int16_t CANIface::send(const AP_HAL::CANFrame& frame, const uint64_t tx_deadline,
+                       const CANIface::CanIOFlags flags)
+{
+    WITH_SEMAPHORE(sem);
+    _queueTx(frame, tx_deadline, flags);
     _pollRead();     // Read poll is necessary because it can release the pending TX flag
     _pollWrite();
 
     return AP_HAL::CANIface::send(frame, tx_deadline, flags);
 }
 
+/*
+  queue a batch of frames under one lock, the transport sends them
+  together
+ */
+int16_t CANIface::send_batch(const CanTxItem *items, uint16_t num_items,
+                             const CANIface::CanIOFlags flags)
+{
+    WITH_SEMAPHORE(sem);
+    if (_down) {
+        // select() doesn't allow writes while the interface is down
+        return 0;
+    }
+    for (uint16_t i = 0; i < num_items; i++) {
+        _queueTx(items[i].frame, items[i].deadline, flags);
+    }
+    _pollRead();
+    _pollWrite();
+    for (uint16_t i = 0; i < num_items; i++) {
+        AP_HAL::CANIface::send(items[i].frame, items[i].deadline, flags);
+    }
+    return num_items;
+}
+
 int16_t CANIface::receive(AP_HAL::CANFrame& out_frame, uint64_t& out_timestamp_us,
                           CANIface::CanIOFlags& out_flags)
 {
@@ -137,23 +166,37 @@ void CANIface::_pollWrite()
     }
     while (_hasReadyTx()) {
         WITH_SEMAPHORE(sem);
-        const CanTxItem tx = _tx_queue.top();
+        CanTxItem batch[CAN_MAX_TX_BATCH];
+        AP_HAL::CANFrame frames[CAN_MAX_TX_BATCH];
+        uint16_t num_frames = 0;
         const uint64_t curr_time = AP_HAL::micros64();
-        if (tx.deadline >= curr_time) {
-            // hal.console->printf("%x TDEAD: %lu CURRT: %lu DEL: %lu\n",tx.frame.id,  tx.deadline, curr_time, tx.deadline-curr_time);
-            bool ok = transport->send(tx.frame);
-            if (ok) {
-                stats.tx_success++;
-                stats.last_transmit_us = curr_time;
+        while (num_frames < ARRAY_SIZE(batch) && !_tx_queue.empty()) {
+            const CanTxItem tx = _tx_queue.top();
+            (void)_tx_queue.pop();
+            if (tx.deadline >= curr_time) {
+                batch[num_frames] = tx;
+                frames[num_frames] = tx.frame;
+                num_frames++;
             } else {
-                break;
+                stats.tx_timedout++;
             }
-        } else {
-            stats.tx_timedout++;
+        }
+        if (num_frames == 0) {
+            continue;
         }
 
-        // Removing the frame from the queue
-        (void)_tx_queue.pop();
+        const uint16_t num_sent = transport->send_batch(frames, num_frames);
+        if (num_sent > 0) {
+            stats.tx_success += num_sent;
+            stats.last_transmit_us = curr_time;
+        }
+        if (num_sent < num_frames) {
+            // the rest remain enqueued for the next retry
+            for (uint16_t i = num_sent; i < num_frames; i++) {
+                _tx_queue.push(batch[i]);
+            }
+            break;
+        }
     }
 }
 
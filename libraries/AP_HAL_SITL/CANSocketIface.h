@@ -29,6 +29,8 @@
 #include <poll.h>
 #include "CAN_Transport.h"
 
+#define CAN_MAX_TX_BATCH 16
+
 namespace HALSITL {
 
 class CANIface: public AP_HAL::CANIface {
@@ -58,6 +60,11 @@ public:
     int16_t send(const AP_HAL::CANFrame& frame, uint64_t tx_deadline,
                  CanIOFlags flags) override;
 
+    // Put a batch of frames into Tx FIFO, returns the number of frames
+    // queued
+    int16_t send_batch(const CanTxItem *items, uint16_t num_items,
+                       CanIOFlags flags) override;
+
     // Receive frame from Rx Buffer, returns negative on error, 0 on nothing available, 
     // 1 on successfully poping a frame
     int16_t receive(AP_HAL::CANFrame& out_frame, uint64_t& out_timestamp_us,
@@ -102,6 +109,8 @@ public:
     }
     
 private:
+    void _queueTx(const AP_HAL::CANFrame& frame, uint64_t tx_deadline, CanIOFlags flags);
+
     void _pollWrite();
 
     bool _pollRead();
@@ -22,6 +22,7 @@
 #define MCAST_MAGIC 0x2934U
 #define MCAST_FLAG_CANFD 0x0001
 #define MCAST_MAX_PKT_LEN 74 // 64 byte data + 10 byte header
+#define MCAST_MAX_BATCH 16U
 
 struct PACKED mcast_pkt {
     uint16_t magic;
@@ -44,11 +45,10 @@ bool CAN_Multicast::init(uint8_t instance)
 }
 
 /*
-  send a CAN frame
+  fill in a packet for a CAN frame, returning the packet length
  */
-bool CAN_Multicast::send(const AP_HAL::CANFrame &frame)
+static uint8_t make_mcast_pkt(const AP_HAL::CANFrame &frame, struct mcast_pkt &pkt)
 {
-    struct mcast_pkt pkt {};
     pkt.magic = MCAST_MAGIC;
     pkt.flags = 0;
 #if HAL_CANFD_SUPPORTED
@@ -60,9 +60,39 @@ bool CAN_Multicast::send(const AP_HAL::CANFrame &frame)
     const uint8_t data_length = AP_HAL::CANFrame::dlcToDataLength(frame.dlc);
     memcpy(pkt.data, frame.data, data_length);
     pkt.crc = crc16_ccitt((uint8_t*)&pkt.flags, data_length+6, 0xFFFFU);
+    return data_length+10;
+}
 
-    return sock.send((void*)&pkt, data_length+10) == data_length+10;
+/*
+  send a CAN frame
+ */
+bool CAN_Multicast::send(const AP_HAL::CANFrame &frame)
+{
+    struct mcast_pkt pkt {};
+    const uint8_t len = make_mcast_pkt(frame, pkt);
+    return sock.send((void*)&pkt, len) == len;
+}
+
+#ifdef __linux__
+/*
+  send several CAN frames with one system call
+ */
+uint16_t CAN_Multicast::send_batch(const AP_HAL::CANFrame *frames, uint16_t num_frames)
+{
+    struct mcast_pkt pkts[MCAST_MAX_BATCH] {};
+    struct iovec iov[MCAST_MAX_BATCH];
+    struct mmsghdr msgs[MCAST_MAX_BATCH] {};
+    num_frames = MIN(num_frames, MCAST_MAX_BATCH);
+    for (uint16_t i = 0; i < num_frames; i++) {
+        iov[i].iov_base = &pkts[i];
+        iov[i].iov_len = make_mcast_pkt(frames[i], pkts[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    const int ret = sendmmsg(sock.get_write_fd(), msgs, num_frames, MSG_NOSIGNAL);
+    return ret > 0 ? ret : 0;
 }
+#endif
 
 /*
   receive a CAN frame
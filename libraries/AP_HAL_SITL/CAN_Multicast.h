@@ -12,6 +12,9 @@ public:
 
     bool init(uint8_t instance) override;
     bool send(const AP_HAL::CANFrame &frame) override;
+#ifdef __linux__
+    uint16_t send_batch(const AP_HAL::CANFrame *frames, uint16_t num_frames) override;
+#endif
     bool receive(AP_HAL::CANFrame &frame) override;
     int get_read_fd(void) const override {
         return sock.get_read_fd();
@@ -14,6 +14,17 @@ public:
     virtual ~CAN_Transport() {}
     virtual bool init(uint8_t instance) = 0;
     virtual bool send(const AP_HAL::CANFrame &frame) = 0;
+
+    // send several frames, returning the number sent
+    virtual uint16_t send_batch(const AP_HAL::CANFrame *frames, uint16_t num_frames) {
+        uint16_t i;
+        for (i = 0; i < num_frames; i++) {
+            if (!send(frames[i])) {
+                break;
+            }
+        }
+        return i;
+    }
     virtual bool receive(AP_HAL::CANFrame &frame) = 0;
     virtual int get_read_fd(void) const = 0;
 
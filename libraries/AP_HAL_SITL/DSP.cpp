@@ -62,6 +62,28 @@ uint16_t DSP::fft_analyse(AP_HAL::DSP::FFTWindowState* state, uint16_t start_bin
     return step_calc_frequencies(fft, start_bin, end_bin);
 }
 
+// perform remaining steps of several FFT analyses
+// two real windows can be transformed with one complex FFT by placing one in the imaginary part of the input
+// and separating the outputs using the conjugate symmetry of real transforms
+void DSP::fft_analyse_batch(AP_HAL::DSP::FFTWindowState** states, uint8_t count, uint16_t start_bin, uint16_t end_bin,
+    float noise_att_cutoff, uint16_t* bins)
+{
+    uint8_t i = 0;
+    for (; i + 1 < count && states[i]->_window_size == states[i + 1]->_window_size; i += 2) {
+        FFTWindowStateSITL* fft1 = (FFTWindowStateSITL*)states[i];
+        FFTWindowStateSITL* fft2 = (FFTWindowStateSITL*)states[i + 1];
+        step_fft_pair(fft1, fft2);
+        step_cmplx_mag(fft1, start_bin, end_bin, noise_att_cutoff);
+        bins[i] = step_calc_frequencies(fft1, start_bin, end_bin);
+        step_cmplx_mag(fft2, start_bin, end_bin, noise_att_cutoff);
+        bins[i + 1] = step_calc_frequencies(fft2, start_bin, end_bin);
+    }
+    // odd one out
+    for (; i < count; i++) {
+        bins[i] = fft_analyse(states[i], start_bin, end_bin, noise_att_cutoff);
+    }
+}
+
 // create an instance of the FFT state machine
 DSP::FFTWindowStateSITL::FFTWindowStateSITL(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
     : AP_HAL::DSP::FFTWindowState::FFTWindowState(window_size, sample_rate, sliding_window_size)
@@ -72,11 +94,16 @@ DSP::FFTWindowStateSITL::FFTWindowStateSITL(uint16_t window_size, uint16_t sampl
     }
 
     buf = new complexf[window_size];
+    twiddles = new complexf[window_size / 2];
+    for (uint16_t i = 0; i < window_size / 2; i++) {
+        twiddles[i] = complexf(cosf(2 * M_PI * i / window_size), sinf(2 * M_PI * i / window_size));
+    }
 }
 
 DSP::FFTWindowStateSITL::~FFTWindowStateSITL()
 {
     delete[] buf;
+    delete[] twiddles;
 }
 
 // step 1: filter the incoming samples through a Hanning window
@@ -100,17 +127,42 @@ void DSP::step_fft(FFTWindowStateSITL* fft)
         fft->buf[i] = complexf(fft->_freq_bins[i], 0);
     }
 
-    calculate_fft(fft->buf, fft->_window_size);
+    calculate_fft(fft->buf, fft->_window_size, fft->twiddles);
+
+    for (uint16_t i = 0; i <= fft->_bin_count; i++) {
+        store_bin(fft, i, fft->buf[i]);
+    }
+}
+
+// step 2: perform a single FFT on two windows of real data
+void DSP::step_fft_pair(FFTWindowStateSITL* fft1, FFTWindowStateSITL* fft2)
+{
+    const uint16_t n = fft1->_window_size;
+
+    for (uint16_t i = 0; i < n; i++) {
+        fft1->buf[i] = complexf(fft1->_freq_bins[i], fft2->_freq_bins[i]);
+    }
+
+    calculate_fft(fft1->buf, n, fft1->twiddles);
 
-    for (uint16_t i = 0; i < fft->_bin_count; i++) {
-        fft->_freq_bins[i] = std::norm(fft->buf[i]);
+    // X1[k] = (Z[k] + conj(Z[n-k])) / 2, X2[k] = (Z[k] - conj(Z[n-k])) / 2j
+    for (uint16_t i = 0; i <= fft1->_bin_count; i++) {
+        const complexf z = fft1->buf[i];
+        const complexf zc = std::conj(fft1->buf[(n - i) % n]);
+        store_bin(fft1, i, (z + zc) * 0.5f);
+        store_bin(fft2, i, (z - zc) * complexf(0.0f, -0.5f));
     }
+}
 
+// store the output of the FFT for a single bin
+void DSP::store_bin(FFTWindowStateSITL* fft, uint16_t bin, const complexf& value)
+{
     // components at the nyquist frequency are real only
-    for (uint16_t i = 0, j = 0; i <= fft->_bin_count; i++, j += 2) {
-        fft->_rfft_data[j] = fft->buf[i].real();
-        fft->_rfft_data[j+1] = fft->buf[i].imag();
+    if (bin < fft->_bin_count) {
+        fft->_freq_bins[bin] = std::norm(value);
     }
+    fft->_rfft_data[bin * 2] = value.real();
+    fft->_rfft_data[bin * 2 + 1] = value.imag();
 }
 
 void DSP::mult_f32(const float* v1, const float* v2, float* vout, uint16_t len)
@@ -169,7 +221,7 @@ static uint16_t fft_log2(uint16_t n)
 
 // calculate the in-place FFT of the input using the Cooley–Tukey algorithm
 // this is a translation of Ron Nicholson's version in http://www.nicholson.com/dsp.fft1.html
-void DSP::calculate_fft(complexf *samples, uint16_t fftlen)
+void DSP::calculate_fft(complexf *samples, uint16_t fftlen, const complexf* twiddles)
 {
     uint16_t m = fft_log2(fftlen);
     // shuffle data using bit reversed addressing ***
@@ -197,8 +249,7 @@ void DSP::calculate_fft(complexf *samples, uint16_t fftlen)
         uint16_t is2 = istep / 2;
         uint16_t astep = fftlen / istep;
         for (uint16_t km = 0; km < is2; km++) { // outer row loop
-            uint16_t a  = km * astep; // twiddle angle index
-            complexf w(sinf(2 * M_PI * (a+(fftlen/4)) / fftlen), sinf(2 * M_PI * a / fftlen));
+            const complexf w = twiddles[km * astep]; // twiddle angle index
             for (uint16_t ki = 0; ki <= (fftlen - istep); ki += istep) { // inner column loop
                 uint16_t i = km + ki;
                 uint16_t j = is2 + i;
@@ -35,6 +35,9 @@ public:
     virtual void fft_start(FFTWindowState* state, FloatBuffer& samples, uint16_t advance) override;
     // perform remaining steps of an FFT analysis
     virtual uint16_t fft_analyse(FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff) override;
+    // perform remaining steps of several FFT analyses, pairs of windows share a single complex FFT
+    virtual void fft_analyse_batch(FFTWindowState** states, uint8_t count, uint16_t start_bin, uint16_t end_bin,
+        float noise_att_cutoff, uint16_t* bins) override;
 
     // STM32-based FFT state
     class FFTWindowStateSITL : public AP_HAL::DSP::FFTWindowState {
@@ -46,17 +49,21 @@ public:
 
     private:
         complexf* buf;
+        // FFT twiddle factors, shared by all the transforms in a batch
+        complexf* twiddles;
     };
 
 private:
     void step_hanning(FFTWindowStateSITL* fft, FloatBuffer& samples, uint16_t advance);
     void step_fft(FFTWindowStateSITL* fft);
+    void step_fft_pair(FFTWindowStateSITL* fft1, FFTWindowStateSITL* fft2);
+    void store_bin(FFTWindowStateSITL* fft, uint16_t bin, const complexf& value);
     void mult_f32(const float* v1, const float* v2, float* vout, uint16_t len);
     void vector_max_float(const float* vin, uint16_t len, float* maxValue, uint16_t* maxIndex) const override;
     void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const override;
     float vector_mean_float(const float* vin, uint16_t len) const override;
     void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const override;
-    void calculate_fft(complexf* f, uint16_t length);
+    void calculate_fft(complexf* f, uint16_t length, const complexf* twiddles);
 };
 
 #endif
@@ -647,6 +647,8 @@ struct PACKED log_Scripting {
     uint32_t run_time;
     int32_t total_mem;
     int32_t run_mem;
+    uint32_t pool_mem;
+    uint32_t pool_miss;
 };
 
 struct PACKED log_MotBatt {
@@ -1200,6 +1202,8 @@ struct PACKED log_VER {
 // @Field: Runtime: run time
 // @Field: Total_mem: total memory usage of all scripts
 // @Field: Run_mem: run memory usage
+// @Field: Pool_mem: memory in use from the small block pools
+// @Field: Pool_miss: number of small allocations which went to the main heap as their pool was full
 
 // @LoggerMessage: MOTB
 // @Description: Motor mixer information
@@ -1333,7 +1337,7 @@ LOG_STRUCTURE_FROM_VISUALODOM \
       "FILE",   "NIBZ",       "FileName,Offset,Length,Data", "----", "----" }, \
 LOG_STRUCTURE_FROM_AIS \
     { LOG_SCRIPTING_MSG, sizeof(log_Scripting), \
-      "SCR",   "QNIii", "TimeUS,Name,Runtime,Total_mem,Run_mem", "s#sbb", "F-F--", true }, \
+      "SCR",   "QNIiiII", "TimeUS,Name,Runtime,Total_mem,Run_mem,Pool_mem,Pool_miss", "s#sbbb-", "F-F----", true }, \
     { LOG_VER_MSG, sizeof(log_VER), \
       "VER",   "QBHBBBBIZHB", "TimeUS,BT,BST,Maj,Min,Pat,FWT,GH,FWS,APJ,BU", "s----------", "F----------", false }, \
     { LOG_MOTBATT_MSG, sizeof(log_MotBatt), \
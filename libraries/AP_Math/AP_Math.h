@@ -12,6 +12,7 @@
 #include "crc.h"
 #include "matrix3.h"
 #include "polygon.h"
+#include "polygon_index.h"
 #include "quaternion.h"
 #include "rotations.h"
 #include "vector2.h"
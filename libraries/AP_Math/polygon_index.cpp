@@ -0,0 +1,247 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Math.h"
+
+#pragma GCC optimize("O2")
+
+// maximum number of bands, and of grid cells along each side
+#define POLYGON_INDEX_GRID_SIZE_MAX         16
+// limit on the number of band or cell entries per polygon edge, long
+// diagonal edges can overlap a lot of cells
+#define POLYGON_INDEX_ENTRIES_PER_EDGE_MAX  8
+
+template <typename T>
+bool PolygonIndex<T>::init(const Vector2<T> *V, uint16_t n)
+{
+    clear();
+
+    // queries fall back to checking every edge until the index is built
+    _points = V;
+    _num_points = n;
+    if (V == nullptr || n < 3) {
+        return false;
+    }
+
+    _min = _max = V[0];
+    for (uint16_t i=1; i<n; i++) {
+        _min.x = MIN(_min.x, V[i].x);
+        _min.y = MIN(_min.y, V[i].y);
+        _max.x = MAX(_max.x, V[i].x);
+        _max.y = MAX(_max.y, V[i].y);
+    }
+
+    // aim for roughly one edge per cell
+    _grid_size = constrain_int16(int16_t(ceilf(sqrtf(n))), 1, POLYGON_INDEX_GRID_SIZE_MAX);
+    const float range_x = float(_max.x) - float(_min.x);
+    const float range_y = float(_max.y) - float(_min.y);
+    _scale.x = is_positive(range_x) ? _grid_size / range_x : 0;
+    _scale.y = is_positive(range_y) ? _grid_size / range_y : 0;
+
+    // the bands use the same edges as Polygon_outside, which ignores
+    // a closing point that repeats the first point
+    _num_outside_edges = Polygon_complete(V, n) ? n-1 : n;
+    const uint16_t max_entries = MIN(uint32_t(n) * POLYGON_INDEX_ENTRIES_PER_EDGE_MAX, UINT16_MAX);
+    if (!build_lists(1, _num_outside_edges, max_entries, _band_start, _band_edges)) {
+        clear();
+        _points = V;
+        _num_points = n;
+        return false;
+    }
+    if (!build_lists(_grid_size, n, max_entries, _cell_start, _cell_edges)) {
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+void PolygonIndex<T>::clear()
+{
+    delete[] _band_start;
+    delete[] _band_edges;
+    delete[] _cell_start;
+    delete[] _cell_edges;
+    _band_start = nullptr;
+    _band_edges = nullptr;
+    _cell_start = nullptr;
+    _cell_edges = nullptr;
+    _points = nullptr;
+    _num_points = 0;
+    _num_outside_edges = 0;
+    _grid_size = 0;
+}
+
+template <typename T>
+uint8_t PolygonIndex<T>::cell_x(float x) const
+{
+    const float c = (x - float(_min.x)) * _scale.x;
+    if (!(c > 0)) {
+        return 0;
+    }
+    if (c >= _grid_size - 1) {
+        return _grid_size - 1;
+    }
+    return uint8_t(c);
+}
+
+template <typename T>
+uint8_t PolygonIndex<T>::cell_y(float y) const
+{
+    const float c = (y - float(_min.y)) * _scale.y;
+    if (!(c > 0)) {
+        return 0;
+    }
+    if (c >= _grid_size - 1) {
+        return _grid_size - 1;
+    }
+    return uint8_t(c);
+}
+
+template <typename T>
+bool PolygonIndex<T>::build_lists(uint8_t num_columns, uint16_t num_edges, uint16_t max_entries, uint16_t *&start, uint16_t *&edges)
+{
+    const uint16_t num_lists = _grid_size * num_columns;
+    start = new uint16_t[num_lists+1];
+    if (start == nullptr) {
+        return false;
+    }
+    memset(start, 0, (num_lists+1)*sizeof(start[0]));
+
+    // count the entries in each list, offset by one so the counts
+    // become the start of each list once summed
+    uint32_t total = 0;
+    for (uint8_t pass=0; pass<2; pass++) {
+        for (uint16_t e=0; e<num_edges; e++) {
+            const Vector2<T> &v1 = _points[e];
+            const Vector2<T> &v2 = _points[(e+1 < num_edges) ? e+1 : 0];
+            const uint8_t y0 = cell_y(float(MIN(v1.y, v2.y)));
+            const uint8_t y1 = cell_y(float(MAX(v1.y, v2.y)));
+            uint8_t x0 = 0, x1 = 0;
+            if (num_columns > 1) {
+                x0 = cell_x(float(MIN(v1.x, v2.x)));
+                x1 = cell_x(float(MAX(v1.x, v2.x)));
+            }
+            for (uint8_t y=y0; y<=y1; y++) {
+                for (uint8_t x=x0; x<=x1; x++) {
+                    const uint16_t k = y * num_columns + x;
+                    if (pass == 0) {
+                        start[k+1]++;
+                        total++;
+                    } else {
+                        edges[start[k]++] = e;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            if (total > max_entries) {
+                delete[] start;
+                start = nullptr;
+                return false;
+            }
+            for (uint16_t k=0; k<num_lists; k++) {
+                start[k+1] += start[k];
+            }
+            edges = new uint16_t[total];
+            if (edges == nullptr) {
+                delete[] start;
+                start = nullptr;
+                return false;
+            }
+        }
+    }
+
+    // filling the lists moved each start along to the start of the
+    // next list, move them back
+    for (uint16_t k=num_lists; k>0; k--) {
+        start[k] = start[k-1];
+    }
+    start[0] = 0;
+    return true;
+}
+
+template <typename T>
+bool PolygonIndex<T>::outside(const Vector2<T> &P) const
+{
+    if (_band_start == nullptr) {
+        return Polygon_outside(P, _points, _num_points);
+    }
+
+    // only edges which straddle P.y can be crossed, so points above
+    // or below the polygon are outside
+    if (P.y < _min.y || P.y >= _max.y) {
+        return true;
+    }
+
+    const uint8_t band = cell_y(float(P.y));
+    bool outside = true;
+    for (uint16_t k=_band_start[band]; k<_band_start[band+1]; k++) {
+        const uint16_t e = _band_edges[k];
+        const uint16_t next = (e+1 < _num_outside_edges) ? e+1 : 0;
+        if (Polygon_edge_crossing(P, _points[e], _points[next])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+template <typename T>
+bool PolygonIndex<T>::edges_near(const Vector2<T> &P, float distance, uint16_t *edges, uint16_t max_edges, uint16_t &num_edges) const
+{
+    num_edges = 0;
+    if (_cell_start == nullptr) {
+        return false;
+    }
+
+    const float px = float(P.x);
+    const float py = float(P.y);
+    if (px + distance < float(_min.x) || px - distance > float(_max.x) ||
+        py + distance < float(_min.y) || py - distance > float(_max.y)) {
+        // too far from the bounding box for any edge to be near
+        return true;
+    }
+
+    const uint8_t x0 = cell_x(px - distance);
+    const uint8_t x1 = cell_x(px + distance);
+    const uint8_t y0 = cell_y(py - distance);
+    const uint8_t y1 = cell_y(py + distance);
+    for (uint8_t y=y0; y<=y1; y++) {
+        for (uint8_t x=x0; x<=x1; x++) {
+            const uint16_t cell = y * _grid_size + x;
+            for (uint16_t k=_cell_start[cell]; k<_cell_start[cell+1]; k++) {
+                // insert in order, an edge may be in more than one cell
+                const uint16_t e = _cell_edges[k];
+                uint16_t pos = num_edges;
+                while (pos > 0 && edges[pos-1] > e) {
+                    pos--;
+                }
+                if (pos > 0 && edges[pos-1] == e) {
+                    continue;
+                }
+                if (num_edges >= max_edges) {
+                    return false;
+                }
+                memmove(&edges[pos+1], &edges[pos], (num_edges-pos)*sizeof(edges[0]));
+                edges[pos] = e;
+                num_edges++;
+            }
+        }
+    }
+    return true;
+}
+
+// Necessary to avoid linker errors
+template class PolygonIndex<int32_t>;
+template class PolygonIndex<float>;
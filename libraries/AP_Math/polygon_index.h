@@ -0,0 +1,82 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include "vector2.h"
+
+/*
+  index of the edges of a polygon to speed up point-in-polygon tests
+  and searches for edges near a point on polygons with many points.
+
+  The polygon's bounding box is split into horizontal bands for the
+  point-in-polygon test and into a grid of cells for the edge search.
+  Each band and cell holds the edges whose bounding box overlaps it.
+
+  Edge i joins point i to point i+1, the last edge joins the last
+  point to the first.  The points are not copied and must remain
+  valid while the index is in use.
+ */
+template <typename T>
+class PolygonIndex {
+public:
+    PolygonIndex() {}
+    ~PolygonIndex() { clear(); }
+
+    CLASS_NO_COPY(PolygonIndex);
+
+    // build the index for polygon V with n points.  returns false if
+    // the index could not be allocated, queries still work but check
+    // every edge
+    bool init(const Vector2<T> *V, uint16_t n);
+
+    // free the index
+    void clear();
+
+    // returns true if P is outside the polygon, result is always
+    // the same as Polygon_outside(P, V, n)
+    bool outside(const Vector2<T> &P) const;
+
+    // find the edges which may come within distance of P.  The edge
+    // numbers are returned in ascending order.  Returns false if
+    // the edge grid is not available or there are more than
+    // max_edges candidates, the caller must check every edge
+    bool edges_near(const Vector2<T> &P, float distance, uint16_t *edges, uint16_t max_edges, uint16_t &num_edges) const;
+
+private:
+    // cell or band containing a coordinate, coordinates outside the
+    // bounding box are clamped to the nearest cell
+    uint8_t cell_x(float x) const;
+    uint8_t cell_y(float y) const;
+
+    // fill in a compressed list of the first num_edges edges per band
+    // (num_columns == 1) or per cell.  returns false on allocation
+    // failure or if there are more than max_entries entries
+    bool build_lists(uint8_t num_columns, uint16_t num_edges, uint16_t max_entries, uint16_t *&start, uint16_t *&edges);
+
+    const Vector2<T> *_points = nullptr;
+    uint16_t _num_points = 0;
+    uint16_t _num_outside_edges = 0;    // edges checked by Polygon_outside
+
+    Vector2<T> _min;                    // bounding box of the polygon
+    Vector2<T> _max;
+    Vector2f _scale;                    // cells per unit of x and y
+    uint8_t _grid_size = 0;             // number of bands and grid cells along each side
+
+    uint16_t *_band_start = nullptr;    // _grid_size+1 offsets into _band_edges
+    uint16_t *_band_edges = nullptr;
+    uint16_t *_cell_start = nullptr;    // _grid_size*_grid_size+1 offsets into _cell_edges
+    uint16_t *_cell_edges = nullptr;
+};
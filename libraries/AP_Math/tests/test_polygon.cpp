@@ -356,6 +356,55 @@ TEST(Polygon, simple)
     TEST_POLYGON_POINTS(SIMPLE_boundary, SIMPLE_test_points);
 }
 
+TEST(Polygon, index_obc)
+{
+    PolygonIndex<int32_t> index;
+    EXPECT_TRUE(index.init(OBC_boundary, ARRAY_SIZE(OBC_boundary)));
+    for (uint32_t i = 0; i < ARRAY_SIZE(OBC_test_points); i++) {
+        EXPECT_EQ(OBC_test_points[i].outside, index.outside(OBC_test_points[i].point));
+    }
+}
+
+// star shaped polygon with many points, the index must give the
+// same results as checking every edge
+TEST(Polygon, index_star)
+{
+    Vector2f star[200];
+    for (uint16_t i = 0; i < ARRAY_SIZE(star); i++) {
+        const float angle = radians(i * 360.0f / ARRAY_SIZE(star));
+        const float radius = 1000.0f + ((i * 37) % 11) * 50.0f;
+        star[i] = Vector2f{radius * cosf(angle), radius * sinf(angle)};
+    }
+    PolygonIndex<float> index;
+    EXPECT_TRUE(index.init(star, ARRAY_SIZE(star)));
+
+    const float distance = 100.0f;
+    for (float x = -1700.0f; x <= 1700.0f; x += 37.0f) {
+        for (float y = -1700.0f; y <= 1700.0f; y += 41.0f) {
+            const Vector2f p{x, y};
+            EXPECT_EQ(Polygon_outside(p, star, ARRAY_SIZE(star)), index.outside(p));
+
+            uint16_t edges[64];
+            uint16_t num_edges;
+            EXPECT_TRUE(index.edges_near(p, distance, edges, ARRAY_SIZE(edges), num_edges));
+            for (uint16_t k = 1; k < num_edges; k++) {
+                EXPECT_LT(edges[k-1], edges[k]);
+            }
+            for (uint16_t i = 0; i < ARRAY_SIZE(star); i++) {
+                const Vector2f &end = star[(i + 1) % ARRAY_SIZE(star)];
+                if (Vector2f::closest_distance_between_line_and_point(star[i], end, p) > distance) {
+                    continue;
+                }
+                bool found = false;
+                for (uint16_t k = 0; k < num_edges; k++) {
+                    found |= (edges[k] == i);
+                }
+                EXPECT_TRUE(found);
+            }
+        }
+    }
+}
+
 AP_GTEST_MAIN()
 
 
@@ -298,6 +298,10 @@ void AP_Mission::truncate(uint16_t index)
     if ((unsigned)_cmd_total > index) {
         _cmd_total.set_and_save(index);
         _last_change_time_ms = AP_HAL::millis();
+#if AP_MISSION_CMD_CACHE_ENABLED
+        WITH_SEMAPHORE(_rsem);
+        _cmd_index.valid = false;
+#endif
     }
 }
 
@@ -494,14 +498,14 @@ bool AP_Mission::replace_cmd(uint16_t index, const Mission_Command& cmd)
     return write_cmd_to_storage(index, cmd);
 }
 
-/// is_nav_cmd - returns true if the command's id is a "navigation" command, false if "do" or "conditional" command
-bool AP_Mission::is_nav_cmd(const Mission_Command& cmd)
+/// is_nav_cmd_id - returns true if the command id is a "navigation" command, false if "do" or "conditional" command
+bool AP_Mission::is_nav_cmd_id(uint16_t id)
 {
     // NAV commands all have ids below MAV_CMD_NAV_LAST, plus some exceptions
-    return (cmd.id <= MAV_CMD_NAV_LAST ||
-            cmd.id == MAV_CMD_NAV_SET_YAW_SPEED ||
-            cmd.id == MAV_CMD_NAV_SCRIPT_TIME ||
-            cmd.id == MAV_CMD_NAV_ATTITUDE_TIME);
+    return (id <= MAV_CMD_NAV_LAST ||
+            id == MAV_CMD_NAV_SET_YAW_SPEED ||
+            id == MAV_CMD_NAV_SCRIPT_TIME ||
+            id == MAV_CMD_NAV_ATTITUDE_TIME);
 }
 
 /// get_next_nav_cmd - gets next "navigation" command found at or after start_index
@@ -511,6 +515,11 @@ bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 {
     // search until the end of the mission command list
     for (uint16_t cmd_index = start_index; cmd_index < (unsigned)_cmd_total; cmd_index++) {
+        // skip over "do" commands, get_next_cmd would return them unchanged
+        cmd_index = get_next_nav_or_jump_index(cmd_index);
+        if (cmd_index >= (unsigned)_cmd_total) {
+            return false;
+        }
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -776,6 +785,14 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         return false;
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    CachedCommand &cached = _cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE];
+    if (cached.valid && cached.cmd.index == index) {
+        cmd = cached.cmd;
+        return true;
+    }
+#endif
+
     // ensure all bytes of cmd are zeroed
     cmd = {};
 
@@ -834,6 +851,11 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
     // set command's index to it's position in eeprom
     cmd.index = index;
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    cached.cmd = cmd;
+    cached.valid = true;
+#endif
+
     // return success
     return true;
 }
@@ -880,6 +902,28 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         return false;
     }
 
+    uint8_t packed[AP_MISSION_EEPROM_COMMAND_SIZE];
+    pack_cmd_for_storage(cmd, packed);
+
+    // calculate where in storage the command should be placed
+    const uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
+    _storage.write_block(pos_in_storage, packed, sizeof(packed));
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+    _cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE].valid = false;
+    _cmd_index.valid = false;
+#endif
+
+    // remember when the mission last changed
+    _last_change_time_ms = AP_HAL::millis();
+
+    // return success
+    return true;
+}
+
+/// pack_cmd_for_storage - pack a command into the format it is held in storage
+void AP_Mission::pack_cmd_for_storage(const Mission_Command& cmd, uint8_t packed_cmd[AP_MISSION_EEPROM_COMMAND_SIZE])
+{
     PackedContent packed {};
     if (stored_in_location(cmd.id)) {
         // Location is not PACKED; field-wise copy it:
@@ -900,14 +944,11 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         memcpy(packed.bytes, &cmd.content, 12);
     }
 
-    // calculate where in storage the command should be placed
-    uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
-
     if (cmd.id < 256) {
         // for commands below 256 we store up to 12 bytes
-        _storage.write_byte(pos_in_storage, cmd.id);
-        _storage.write_uint16(pos_in_storage+1, cmd.p1);
-        _storage.write_block(pos_in_storage+3, packed.bytes, 12);
+        packed_cmd[0] = cmd.id;
+        memcpy(&packed_cmd[1], &cmd.p1, 2);
+        memcpy(&packed_cmd[3], packed.bytes, 12);
     } else {
         // if the command ID is above 256 we store a tag byte followed
         // by the 16 bit command ID. The tag byte is 1 for commands
@@ -918,19 +959,88 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         if (cmd.id == MAV_CMD_NAV_SCRIPT_TIME) {
             tag_byte = 1;
         }
-        _storage.write_byte(pos_in_storage, tag_byte);
-        _storage.write_uint16(pos_in_storage+1, cmd.id);
-        _storage.write_uint16(pos_in_storage+3, cmd.p1);
-        _storage.write_block(pos_in_storage+5, packed.bytes, 10);
+        packed_cmd[0] = tag_byte;
+        memcpy(&packed_cmd[1], &cmd.id, 2);
+        memcpy(&packed_cmd[3], &cmd.p1, 2);
+        memcpy(&packed_cmd[5], packed.bytes, 10);
     }
+}
 
-    // remember when the mission last changed
-    _last_change_time_ms = AP_HAL::millis();
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+/// begin_staged_upload - start collecting a new mission of count commands in memory
+bool AP_Mission::begin_staged_upload(uint16_t count)
+{
+    cancel_staged_upload();
 
-    // return success
+    if (count == 0 || count > _commands_max) {
+        return false;
+    }
+    _staged.cmds = new uint8_t[uint32_t(count) * AP_MISSION_EEPROM_COMMAND_SIZE];
+    if (_staged.cmds == nullptr) {
+        return false;
+    }
+    _staged.count = count;
+    _staged.num_cmds = 0;
+    return true;
+}
+
+/// stage_cmd - adds a command to the end of the staged mission
+bool AP_Mission::stage_cmd(const Mission_Command& cmd)
+{
+    if (_staged.cmds == nullptr || _staged.num_cmds >= _staged.count) {
+        return false;
+    }
+
+    // the whole of the new mission is known so jumps can be checked against its final length
+    if (cmd.id == MAV_CMD_DO_JUMP &&
+        (cmd.content.jump.target >= _staged.count || cmd.content.jump.target == 0)) {
+        return false;
+    }
+
+    pack_cmd_for_storage(cmd, &_staged.cmds[_staged.num_cmds * AP_MISSION_EEPROM_COMMAND_SIZE]);
+    _staged.num_cmds++;
+    return true;
+}
+
+/// commit_staged_upload - replaces the mission with the staged mission in a single storage write
+bool AP_Mission::commit_staged_upload()
+{
+    if (_staged.cmds == nullptr || _staged.num_cmds != _staged.count) {
+        cancel_staged_upload();
+        return false;
+    }
+
+    {
+        WITH_SEMAPHORE(_rsem);
+
+        _storage.write_block(4, _staged.cmds, _staged.count * AP_MISSION_EEPROM_COMMAND_SIZE);
+        _cmd_total.set_and_save(_staged.count);
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+        for (auto &cached : _cmd_cache) {
+            cached.valid = false;
+        }
+        _cmd_index.valid = false;
+#endif
+
+        // remember when the mission last changed
+        _last_change_time_ms = AP_HAL::millis();
+    }
+
+    cancel_staged_upload();
     return true;
 }
 
+/// cancel_staged_upload - discards the staged mission
+void AP_Mission::cancel_staged_upload()
+{
+    delete[] _staged.cmds;
+    _staged.cmds = nullptr;
+    _staged.count = 0;
+    _staged.num_cmds = 0;
+}
+#endif  // AP_MISSION_STAGED_UPLOAD_ENABLED
+
 /// write_home_to_storage - writes the special purpose cmd 0 (home) to storage
 ///     home is taken directly from ahrs
 void AP_Mission::write_home_to_storage()
@@ -2253,6 +2363,22 @@ bool AP_Mission::jump_to_tag(const uint16_t tag)
 // Returns 0 if no appropriate JUMP_TAG match can be found.
 uint16_t AP_Mission::get_index_of_jump_tag(const uint16_t tag) const
 {
+#if AP_MISSION_CMD_CACHE_ENABLED
+    {
+        WITH_SEMAPHORE(_rsem);
+        if (update_cmd_index()) {
+            for (uint8_t i = 0; i < _cmd_index.num_jump_tags; i++) {
+                if (_cmd_index.jump_tags[i].tag == tag) {
+                    return _cmd_index.jump_tags[i].index;
+                }
+            }
+            if (_cmd_index.jump_tags_complete) {
+                return 0;
+            }
+        }
+    }
+#endif
+
     const auto count = num_commands();
     for (uint16_t i = 1; i < count; i++) {
         if (get_command_id(i) != uint16_t(MAV_CMD_JUMP_TAG)) {
@@ -2768,6 +2894,20 @@ const char *AP_Mission::Mission_Command::type() const
   get the command ID of a mission index. Caller should have checked the index is in range
  */
 uint16_t AP_Mission::get_command_id(uint16_t index) const
+{
+#if AP_MISSION_CMD_CACHE_ENABLED
+    WITH_SEMAPHORE(_rsem);
+    if (update_cmd_index() && index < _cmd_index.count) {
+        return _cmd_index.id[index];
+    }
+#endif
+    return read_command_id_from_storage(index);
+}
+
+/*
+  read the command ID of a mission index from storage
+ */
+uint16_t AP_Mission::read_command_id_from_storage(uint16_t index) const
 {
     const uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
     uint8_t b[3] {};
@@ -2783,6 +2923,103 @@ uint16_t AP_Mission::get_command_id(uint16_t index) const
     return id;
 }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+/*
+  rebuild the index of command ids, next nav commands and jump tags if
+  the mission has changed.  Returns false if the index is not available
+ */
+bool AP_Mission::update_cmd_index() const
+{
+    WITH_SEMAPHORE(_rsem);
+
+    const uint16_t count = num_commands();
+    if (_cmd_index.valid && _cmd_index.count == count) {
+        return true;
+    }
+    _cmd_index.valid = false;
+    _cmd_index.count = 0;
+    _cmd_index.num_jump_tags = 0;
+    _cmd_index.jump_tags_complete = true;
+
+    if (count > _cmd_index.size) {
+        // grow in steps to avoid reallocating for each item of an upload
+        const uint16_t size = MIN(uint32_t(count) + 32U, uint32_t(UINT16_MAX));
+        delete[] _cmd_index.id;
+        delete[] _cmd_index.next_nav;
+        _cmd_index.id = new uint16_t[size];
+        _cmd_index.next_nav = new uint16_t[size];
+        if (_cmd_index.id == nullptr || _cmd_index.next_nav == nullptr) {
+            delete[] _cmd_index.id;
+            delete[] _cmd_index.next_nav;
+            _cmd_index.id = nullptr;
+            _cmd_index.next_nav = nullptr;
+            _cmd_index.size = 0;
+            return false;
+        }
+        _cmd_index.size = size;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        const uint16_t id = read_command_id_from_storage(i);
+        _cmd_index.id[i] = id;
+        if (i == 0 || id != MAV_CMD_JUMP_TAG) {
+            continue;
+        }
+        // record the first command with each tag
+        Mission_Command tmp;
+        if (!read_cmd_from_storage(i, tmp) || tmp.id != MAV_CMD_JUMP_TAG) {
+            continue;
+        }
+        bool found = false;
+        for (uint8_t t = 0; t < _cmd_index.num_jump_tags; t++) {
+            if (_cmd_index.jump_tags[t].tag == tmp.content.jump.target) {
+                found = true;
+                break;
+            }
+        }
+        if (found) {
+            continue;
+        }
+        if (_cmd_index.num_jump_tags >= ARRAY_SIZE(_cmd_index.jump_tags)) {
+            _cmd_index.jump_tags_complete = false;
+            continue;
+        }
+        _cmd_index.jump_tags[_cmd_index.num_jump_tags].tag = tmp.content.jump.target;
+        _cmd_index.jump_tags[_cmd_index.num_jump_tags].index = i;
+        _cmd_index.num_jump_tags++;
+    }
+
+    // work backwards to find the next command which get_next_nav_cmd must stop at
+    uint16_t next_nav = AP_MISSION_CMD_INDEX_NONE;
+    for (uint16_t i = count; i > 0; i--) {
+        const uint16_t id = _cmd_index.id[i-1];
+        if (is_nav_cmd_id(id) || id == MAV_CMD_DO_JUMP || id == MAV_CMD_DO_JUMP_TAG) {
+            next_nav = i-1;
+        }
+        _cmd_index.next_nav[i-1] = next_nav;
+    }
+
+    _cmd_index.count = count;
+    _cmd_index.valid = true;
+    return true;
+}
+#endif  // AP_MISSION_CMD_CACHE_ENABLED
+
+/*
+  get the index of the first nav, DO_JUMP or DO_JUMP_TAG command at or
+  after index.  Returns index if the mission index is not available
+ */
+uint16_t AP_Mission::get_next_nav_or_jump_index(uint16_t index) const
+{
+#if AP_MISSION_CMD_CACHE_ENABLED
+    WITH_SEMAPHORE(_rsem);
+    if (update_cmd_index() && index < _cmd_index.count) {
+        return _cmd_index.next_nav[index];
+    }
+#endif
+    return index;
+}
+
 /*
   see if the mission contains a particular item
  */
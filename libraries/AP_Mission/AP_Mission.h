@@ -34,6 +34,11 @@
 #endif
 #endif
 
+#ifndef AP_MISSION_CMD_CACHE_SIZE
+#define AP_MISSION_CMD_CACHE_SIZE           16      // number of decoded commands kept in the command cache
+#endif
+#define AP_MISSION_CMD_INDEX_JUMP_TAGS_MAX  16      // number of JUMP_TAG commands held in the mission index, missions with more are searched
+
 #define AP_MISSION_JUMP_REPEAT_FOREVER      -1      // when do-jump command's repeat count is -1 this means endless repeat
 
 #define AP_MISSION_CMD_ID_NONE              0       // mavlink cmd id of zero means invalid or missing command
@@ -554,8 +559,33 @@ public:
     ///     returns true if successfully replaced, false on failure
     bool replace_cmd(uint16_t index, const Mission_Command& cmd);
 
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+    /// begin_staged_upload - start collecting a new mission of count commands in memory.
+    ///     the current mission is left untouched until commit_staged_upload is called
+    ///     returns false if there is not enough memory, commands should then be written directly
+    bool begin_staged_upload(uint16_t count);
+
+    /// stage_cmd - adds a command to the end of the staged mission
+    ///     returns false if the command is invalid or the staged mission is full
+    bool stage_cmd(const Mission_Command& cmd);
+
+    /// commit_staged_upload - replaces the mission with the staged mission in a single storage write
+    ///     returns false if the staged mission is incomplete.  The staged mission is discarded in all cases
+    bool commit_staged_upload();
+
+    /// cancel_staged_upload - discards the staged mission
+    void cancel_staged_upload();
+
+    // returns true if a mission is being staged
+    bool staged_upload_active() const { return _staged.cmds != nullptr; }
+
+    // returns the number of commands staged so far
+    uint16_t num_staged_cmds() const { return _staged.num_cmds; }
+#endif
+
     /// is_nav_cmd - returns true if the command's id is a "navigation" command, false if "do" or "conditional" command
-    static bool is_nav_cmd(const Mission_Command& cmd);
+    static bool is_nav_cmd(const Mission_Command& cmd) { return is_nav_cmd_id(cmd.id); }
+    static bool is_nav_cmd_id(uint16_t id);
 
     /// get_current_nav_cmd - returns the current "navigation" command
     const Mission_Command& get_current_nav_cmd() const
@@ -891,8 +921,55 @@ private:
     bool _failed_sdcard_storage;
 #endif
 
+    // pack a command into its storage format
+    static void pack_cmd_for_storage(const Mission_Command& cmd, uint8_t packed[AP_MISSION_EEPROM_COMMAND_SIZE]);
+
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+    // mission being uploaded, in storage format
+    struct {
+        uint8_t *cmds;
+        uint16_t count;     // number of commands in the new mission
+        uint16_t num_cmds;  // number of commands staged so far
+    } _staged;
+#endif
+
     // fast call to get command ID of a mission index
     uint16_t get_command_id(uint16_t index) const;
+    uint16_t read_command_id_from_storage(uint16_t index) const;
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+    // decoded copies of recently read commands, a command is held in
+    // the entry given by its index modulo the cache size
+    struct CachedCommand {
+        Mission_Command cmd;
+        bool valid;
+    };
+    mutable CachedCommand _cmd_cache[AP_MISSION_CMD_CACHE_SIZE];
+
+    // index of the mission built from storage on first use after the
+    // mission changes.  Only accessed with _rsem held
+    mutable struct {
+        uint16_t *id;           // command id of each item
+        uint16_t *next_nav;     // index of the first nav, DO_JUMP or DO_JUMP_TAG command at or after each item
+        uint16_t size;          // number of items allocated
+        uint16_t count;         // number of items indexed
+        bool valid;             // false if the mission has changed since the index was built
+        struct {
+            uint16_t tag;
+            uint16_t index;
+        } jump_tags[AP_MISSION_CMD_INDEX_JUMP_TAGS_MAX];   // first JUMP_TAG command with each tag
+        uint8_t num_jump_tags;
+        bool jump_tags_complete;    // false if the mission has more tags than jump_tags can hold
+    } _cmd_index;
+
+    // rebuild the mission index if the mission has changed.  Returns
+    // false if the index is not available
+    bool update_cmd_index() const;
+#endif
+
+    // index of the first nav, DO_JUMP or DO_JUMP_TAG command at or after
+    // index, or index itself if the mission index is not available
+    uint16_t get_next_nav_or_jump_index(uint16_t index) const;
 
     // memoisation of contains-relative:
     bool _contains_terrain_alt_items;  // true if the mission has terrain-relative items
@@ -7,3 +7,13 @@
 #ifndef AP_MISSION_NAV_PAYLOAD_PLACE_ENABLED
 #define AP_MISSION_NAV_PAYLOAD_PLACE_ENABLED 1
 #endif
+
+// keep an in-memory index of the mission and a cache of recently read commands
+#ifndef AP_MISSION_CMD_CACHE_ENABLED
+#define AP_MISSION_CMD_CACHE_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_300)
+#endif
+
+// allow mission uploads to be staged in memory and written to storage in one go
+#ifndef AP_MISSION_STAGED_UPLOAD_ENABLED
+#define AP_MISSION_STAGED_UPLOAD_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
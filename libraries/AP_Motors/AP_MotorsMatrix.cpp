@@ -28,6 +28,7 @@ void AP_MotorsMatrix::init(motor_frame_class frame_class, motor_frame_type frame
 
     if (frame_class == MOTOR_FRAME_SCRIPTING_MATRIX) {
         // if Scripting frame class, do nothing scripting must call its own dedicated init function
+        _fixed_mixer.num_motors = 0;
         return;
     }
 
@@ -86,6 +87,7 @@ bool AP_MotorsMatrix::init(uint8_t expected_num_motors)
     }
 
     normalise_rpy_factors();
+    setup_fixed_mixer();
 
     set_update_rate(_speed_hz);
 
@@ -208,21 +210,22 @@ float AP_MotorsMatrix::boost_ratio(float boost_value, float normal_value) const
     return _thrust_boost_ratio * boost_value + (1.0 - _thrust_boost_ratio) * normal_value;
 }
 
-// output_armed - sends commands to the motors
-// includes new scaling stability patch
-void AP_MotorsMatrix::output_armed_stabilizing()
+// get the roll, pitch, yaw and throttle thrust demands with voltage and air pressure
+// compensation applied, setting the throttle limit flags
+void AP_MotorsMatrix::get_thrust_demand(ThrustDemand &demand)
 {
     // apply voltage and air pressure compensation
     const float compensation_gain = thr_lin.get_compensation_gain(); // compensation for battery voltage and altitude
+    demand.compensation_gain = compensation_gain;
 
-    // pitch thrust input value, +/- 1.0
-    const float roll_thrust = (_roll_in + _roll_in_ff) * compensation_gain;
+    // roll thrust input value, +/- 1.0
+    demand.roll = (_roll_in + _roll_in_ff) * compensation_gain;
 
     // pitch thrust input value, +/- 1.0
-    const float pitch_thrust = (_pitch_in + _pitch_in_ff) * compensation_gain;
+    demand.pitch = (_pitch_in + _pitch_in_ff) * compensation_gain;
 
     // yaw thrust input value, +/- 1.0
-    float yaw_thrust = (_yaw_in + _yaw_in_ff) * compensation_gain;
+    demand.yaw = (_yaw_in + _yaw_in_ff) * compensation_gain;
 
     // throttle thrust input value, 0.0 - 1.0
     float throttle_thrust = get_throttle() * compensation_gain;
@@ -242,13 +245,88 @@ void AP_MotorsMatrix::output_armed_stabilizing()
         throttle_thrust = throttle_thrust_max;
         limit.throttle_upper = true;
     }
+    demand.throttle = throttle_thrust;
 
     // ensure that throttle_avg_max is between the input throttle and the maximum throttle
-    throttle_avg_max = constrain_float(throttle_avg_max, throttle_thrust, throttle_thrust_max);
+    demand.throttle_avg_max = constrain_float(throttle_avg_max, throttle_thrust, throttle_thrust_max);
+}
+
+// calculate the minimum amount of yaw that is always allowed
+float AP_MotorsMatrix::get_yaw_allowed_min() const
+{
+    // todo: make _yaw_headroom 0 to 1
+    const float yaw_allowed_min = (float)_yaw_headroom * 0.001f;
+
+    // increase yaw headroom to 50% if thrust boost enabled
+    return boost_ratio(0.5, yaw_allowed_min);
+}
+
+// calculate any scaling needed to make the combined thrust outputs fit within the output range
+// and how close the motors can come to the desired throttle
+float AP_MotorsMatrix::calc_throttle_best_plus_adj(float rpy_low, float rpy_high, float throttle_avg_max, float throttle_thrust, float &rpy_scale)
+{
+    rpy_scale = 1.0f;
+    if (rpy_high - rpy_low > 1.0f) {
+        rpy_scale = 1.0f / (rpy_high - rpy_low);
+    }
+    if (throttle_avg_max + rpy_low < 0) {
+        rpy_scale = MIN(rpy_scale, -throttle_avg_max / rpy_low);
+    }
+
+    // calculate how close the motors can come to the desired throttle
+    rpy_high *= rpy_scale;
+    rpy_low *= rpy_scale;
+    const float throttle_thrust_best_rpy = -rpy_low;
+    float thr_adj = throttle_thrust - throttle_thrust_best_rpy;
+    if (rpy_scale < 1.0f) {
+        // Full range is being used by roll, pitch, and yaw.
+        limit.roll = true;
+        limit.pitch = true;
+        limit.yaw = true;
+        if (thr_adj > 0.0f) {
+            limit.throttle_upper = true;
+        }
+        thr_adj = 0.0f;
+    } else if (thr_adj < 0.0f) {
+        // Throttle can't be reduced to desired value
+        // todo: add lower limit flag and ensure it is handled correctly in altitude controller
+        thr_adj = 0.0f;
+    } else if (thr_adj > 1.0f - (throttle_thrust_best_rpy + rpy_high)) {
+        // Throttle can't be increased to desired value
+        thr_adj = 1.0f - (throttle_thrust_best_rpy + rpy_high);
+        limit.throttle_upper = true;
+    }
+
+    return throttle_thrust_best_rpy + thr_adj;
+}
+
+// output_armed - sends commands to the motors
+// includes new scaling stability patch
+void AP_MotorsMatrix::output_armed_stabilizing()
+{
+    // use the specialised mixer for this frame if there is one
+    switch (_fixed_mixer.num_motors) {
+    case 4:
+        output_armed_stabilizing_fixed<4>();
+        return;
+    case 6:
+        output_armed_stabilizing_fixed<6>();
+        return;
+    default:
+        break;
+    }
+
+    ThrustDemand demand;
+    get_thrust_demand(demand);
+    const float roll_thrust = demand.roll;
+    const float pitch_thrust = demand.pitch;
+    float yaw_thrust = demand.yaw;
+    const float throttle_thrust = demand.throttle;
+    const float throttle_avg_max = demand.throttle_avg_max;
 
     // throttle providing maximum roll, pitch and yaw range
     // calculate the highest allowed average thrust that will provide maximum control range
-    float throttle_thrust_best_rpy = MIN(0.5f, throttle_avg_max);
+    const float throttle_thrust_best_rpy = MIN(0.5f, throttle_avg_max);
 
     // calculate throttle that gives most possible room for yaw which is the lower of:
     //      1. 0.5f - (rpy_low+rpy_high)/2.0 - this would give the maximum possible margin above the highest motor and below the lowest
@@ -297,15 +375,8 @@ void AP_MotorsMatrix::output_armed_stabilizing()
         }
     }
 
-    // calculate the maximum yaw control that can be used
-    // todo: make _yaw_headroom 0 to 1
-    float yaw_allowed_min = (float)_yaw_headroom * 0.001f;
-
-    // increase yaw headroom to 50% if thrust boost enabled
-    yaw_allowed_min = boost_ratio(0.5, yaw_allowed_min);
-
     // Let yaw access minimum amount of head room
-    yaw_allowed = MAX(yaw_allowed, yaw_allowed_min);
+    yaw_allowed = MAX(yaw_allowed, get_yaw_allowed_min());
 
     // Include the lost motor scaled by _thrust_boost_ratio to smoothly transition this motor in and out of the calculation
     if (_thrust_boost && motor_enabled[_motor_lost_index]) {
@@ -357,40 +428,10 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     }
 
     // calculate any scaling needed to make the combined thrust outputs fit within the output range
-    float rpy_scale = 1.0f;
-    if (rpy_high - rpy_low > 1.0f) {
-        rpy_scale = 1.0f / (rpy_high - rpy_low);
-    }
-    if (throttle_avg_max + rpy_low < 0) {
-        rpy_scale = MIN(rpy_scale, -throttle_avg_max / rpy_low);
-    }
-
-    // calculate how close the motors can come to the desired throttle
-    rpy_high *= rpy_scale;
-    rpy_low *= rpy_scale;
-    throttle_thrust_best_rpy = -rpy_low;
-    float thr_adj = throttle_thrust - throttle_thrust_best_rpy;
-    if (rpy_scale < 1.0f) {
-        // Full range is being used by roll, pitch, and yaw.
-        limit.roll = true;
-        limit.pitch = true;
-        limit.yaw = true;
-        if (thr_adj > 0.0f) {
-            limit.throttle_upper = true;
-        }
-        thr_adj = 0.0f;
-    } else if (thr_adj < 0.0f) {
-        // Throttle can't be reduced to desired value
-        // todo: add lower limit flag and ensure it is handled correctly in altitude controller
-        thr_adj = 0.0f;
-    } else if (thr_adj > 1.0f - (throttle_thrust_best_rpy + rpy_high)) {
-        // Throttle can't be increased to desired value
-        thr_adj = 1.0f - (throttle_thrust_best_rpy + rpy_high);
-        limit.throttle_upper = true;
-    }
+    float rpy_scale;
+    const float throttle_thrust_best_plus_adj = calc_throttle_best_plus_adj(rpy_low, rpy_high, throttle_avg_max, throttle_thrust, rpy_scale);
 
     // add scaled roll, pitch, constrained yaw and throttle for each motor
-    const float throttle_thrust_best_plus_adj = throttle_thrust_best_rpy + thr_adj;
     for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
         if (motor_enabled[i]) {
             _thrust_rpyt_out[i] = (throttle_thrust_best_plus_adj * _throttle_factor[i]) + (rpy_scale * _thrust_rpyt_out[i]);
@@ -399,12 +440,92 @@ void AP_MotorsMatrix::output_armed_stabilizing()
 
     // determine throttle thrust for harmonic notch
     // compensation_gain can never be zero
-    _throttle_out = throttle_thrust_best_plus_adj / compensation_gain;
+    _throttle_out = throttle_thrust_best_plus_adj / demand.compensation_gain;
 
     // check for failed motor
     check_for_failed_motor(throttle_thrust_best_plus_adj);
 }
 
+// mixer for frames with N motors, this must give exactly the same output as the
+// generic mixer in output_armed_stabilizing()
+template <uint8_t N>
+void AP_MotorsMatrix::output_armed_stabilizing_fixed()
+{
+    ThrustDemand demand;
+    get_thrust_demand(demand);
+    float yaw_thrust = demand.yaw;
+
+    const float throttle_thrust_best_rpy = MIN(0.5f, demand.throttle_avg_max);
+
+    // entry of the lost motor if thrust boost is enabled, N if there is none
+    const uint8_t lost = _thrust_boost ? _fixed_mixer.index[_motor_lost_index] : N;
+
+    // calculate amount of yaw we can fit into the throttle range
+    float thrust_rpyt[N];
+    float yaw_allowed = 1.0f;
+    for (uint8_t i = 0; i < N; i++) {
+        thrust_rpyt[i] = demand.roll * _fixed_mixer.roll[i] + demand.pitch * _fixed_mixer.pitch[i];
+        if (!is_zero(_fixed_mixer.yaw[i]) && i != lost) {
+            const float thrust_rp_best_throttle = throttle_thrust_best_rpy + thrust_rpyt[i];
+            float motor_room;
+            if (is_positive(yaw_thrust * _fixed_mixer.yaw[i])) {
+                motor_room = 1.0 - thrust_rp_best_throttle;
+            } else {
+                motor_room = thrust_rp_best_throttle;
+            }
+            const float motor_yaw_allowed = MAX(motor_room, 0.0)/fabsf(_fixed_mixer.yaw[i]);
+            yaw_allowed = MIN(yaw_allowed, motor_yaw_allowed);
+        }
+    }
+
+    yaw_allowed = MAX(yaw_allowed, get_yaw_allowed_min());
+
+    // include the lost motor scaled by _thrust_boost_ratio
+    if (lost < N && !is_zero(_fixed_mixer.yaw[lost])) {
+        const float thrust_rp_best_throttle = throttle_thrust_best_rpy + thrust_rpyt[lost];
+        float motor_room;
+        if (is_positive(yaw_thrust * _fixed_mixer.yaw[lost])) {
+            motor_room = 1.0 - thrust_rp_best_throttle;
+        } else {
+            motor_room = thrust_rp_best_throttle;
+        }
+        const float motor_yaw_allowed = MAX(motor_room, 0.0)/fabsf(_fixed_mixer.yaw[lost]);
+        yaw_allowed = boost_ratio(yaw_allowed, MIN(yaw_allowed, motor_yaw_allowed));
+    }
+
+    if (fabsf(yaw_thrust) > yaw_allowed) {
+        // not all commanded yaw can be used
+        yaw_thrust = constrain_float(yaw_thrust, -yaw_allowed, yaw_allowed);
+        limit.yaw = true;
+    }
+
+    // add yaw control to thrust outputs and find the range
+    float rpy_low = 1.0f;
+    float rpy_high = -1.0f;
+    for (uint8_t i = 0; i < N; i++) {
+        thrust_rpyt[i] = thrust_rpyt[i] + yaw_thrust * _fixed_mixer.yaw[i];
+        rpy_low = MIN(rpy_low, thrust_rpyt[i]);
+        if (i != lost) {
+            rpy_high = MAX(rpy_high, thrust_rpyt[i]);
+        }
+    }
+    if (lost < N && thrust_rpyt[lost] > rpy_high) {
+        rpy_high = boost_ratio(rpy_high, thrust_rpyt[lost]);
+    }
+
+    float rpy_scale;
+    const float throttle_thrust_best_plus_adj = calc_throttle_best_plus_adj(rpy_low, rpy_high, demand.throttle_avg_max, demand.throttle, rpy_scale);
+
+    // add scaled roll, pitch, constrained yaw and throttle for each motor
+    for (uint8_t i = 0; i < N; i++) {
+        _thrust_rpyt_out[_fixed_mixer.motor[i]] = (throttle_thrust_best_plus_adj * _fixed_mixer.throttle[i]) + (rpy_scale * thrust_rpyt[i]);
+    }
+
+    _throttle_out = throttle_thrust_best_plus_adj / demand.compensation_gain;
+
+    check_for_failed_motor(throttle_thrust_best_plus_adj);
+}
+
 // check for failed motor
 //   should be run immediately after output_armed_stabilizing
 //   first argument is the sum of:
@@ -1327,6 +1448,7 @@ void AP_MotorsMatrix::setup_motors(motor_frame_class frame_class, motor_frame_ty
 
     // normalise factors to magnitude 0.5
     normalise_rpy_factors();
+    setup_fixed_mixer();
 
     if (!success) {
         _frame_class_string = "UNSUPPORTED";
@@ -1373,6 +1495,40 @@ void AP_MotorsMatrix::normalise_rpy_factors()
 }
 
 
+// pack the factors of the enabled motors for the specialised mixer, this must
+// be called whenever the factors change
+void AP_MotorsMatrix::setup_fixed_mixer()
+{
+    uint8_t num_motors = 0;
+    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (motor_enabled[i]) {
+            num_motors++;
+        }
+    }
+
+    // only quad and hexa frames have a specialised mixer
+    _fixed_mixer.num_motors = 0;
+    if (num_motors != 4 && num_motors != 6) {
+        return;
+    }
+
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (!motor_enabled[i]) {
+            _fixed_mixer.index[i] = num_motors;
+            continue;
+        }
+        _fixed_mixer.motor[n] = i;
+        _fixed_mixer.index[i] = n;
+        _fixed_mixer.roll[n] = _roll_factor[i];
+        _fixed_mixer.pitch[n] = _pitch_factor[i];
+        _fixed_mixer.yaw[n] = _yaw_factor[i];
+        _fixed_mixer.throttle[n] = _throttle_factor[i];
+        n++;
+    }
+    _fixed_mixer.num_motors = num_motors;
+}
+
 /*
   call vehicle supplied thrust compensation if set. This allows
   vehicle code to compensate for vehicle specific motor arrangements
@@ -1394,6 +1550,7 @@ void AP_MotorsMatrix::disable_yaw_torque(void)
     for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
         _yaw_factor[i] = 0;
     }
+    setup_fixed_mixer();
 }
 
 #if APM_BUILD_TYPE(APM_BUILD_UNKNOWN)
@@ -10,6 +10,8 @@
 #define AP_MOTORS_MATRIX_YAW_FACTOR_CW   -1
 #define AP_MOTORS_MATRIX_YAW_FACTOR_CCW   1
 
+#define AP_MOTORS_MATRIX_FIXED_MIXER_MAX  6     // largest frame with a specialised mixer
+
 /// @class      AP_MotorsMatrix
 class AP_MotorsMatrix : public AP_MotorsMulticopter {
 public:
@@ -155,8 +157,45 @@ protected:
     const char*         _frame_class_string = ""; // string representation of frame class
     const char*         _frame_type_string = "";  //  string representation of frame type
 
+    // mixer specialised for quad and hexa frames, selected at init. The factors of the
+    // enabled motors are packed densely so the mixing loops have a compile time length
+    struct {
+        uint8_t         num_motors;     // number of motors, zero if the generic mixer is used
+        uint8_t         motor[AP_MOTORS_MATRIX_FIXED_MIXER_MAX];   // motor number of each entry
+        uint8_t         index[AP_MOTORS_MAX_NUM_MOTORS];          // entry of each motor number, num_motors if not enabled
+        float           roll[AP_MOTORS_MATRIX_FIXED_MIXER_MAX];
+        float           pitch[AP_MOTORS_MATRIX_FIXED_MIXER_MAX];
+        float           yaw[AP_MOTORS_MATRIX_FIXED_MIXER_MAX];
+        float           throttle[AP_MOTORS_MATRIX_FIXED_MIXER_MAX];
+    } _fixed_mixer;
+
+    // select the specialised mixer if there is one for the enabled motors
+    void                setup_fixed_mixer();
+
 private:
 
+    // roll, pitch, yaw and throttle thrust demands with compensation applied
+    struct ThrustDemand {
+        float compensation_gain;
+        float roll;
+        float pitch;
+        float yaw;
+        float throttle;
+        float throttle_avg_max;
+    };
+    void get_thrust_demand(ThrustDemand &demand);
+
+    // minimum yaw headroom, increased when thrust boost is enabled
+    float get_yaw_allowed_min() const;
+
+    // calculate the scaling of roll, pitch and yaw needed to fit within the output range and
+    // return the throttle that can be achieved with it
+    float calc_throttle_best_plus_adj(float rpy_low, float rpy_high, float throttle_avg_max, float throttle_thrust, float &rpy_scale);
+
+    // mixer with a compile time number of motors
+    template <uint8_t N>
+    void output_armed_stabilizing_fixed();
+
     // helper to return value scaled between boost and normal based on the value of _thrust_boost_ratio
     float boost_ratio(float boost_value, float normal_value) const;
 
@@ -0,0 +1,146 @@
+#include <AP_gtest.h>
+
+#include <AP_Motors/AP_Motors.h>
+#include <SRV_Channel/SRV_Channel.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+SRV_Channels srvs;
+
+// gives access to the mixer so the specialised and generic mixers can be compared
+class AP_MotorsMatrix_MixerTest : public AP_MotorsMatrix {
+public:
+    struct Inputs {
+        float roll;
+        float pitch;
+        float yaw;
+        float throttle;
+        float throttle_avg_max;
+        float boost_ratio;
+        uint8_t lost_motor;
+    };
+
+    struct Outputs {
+        float thrust[AP_MOTORS_MAX_NUM_MOTORS];
+        float throttle_out;
+        AP_Motors_limit limit;
+        uint8_t lost_motor;
+    };
+
+    bool has_fixed_mixer() const { return _fixed_mixer.num_motors != 0; }
+
+    void mix(const Inputs &in, bool use_fixed_mixer, Outputs &out) {
+        const uint8_t fixed_motors = _fixed_mixer.num_motors;
+        if (!use_fixed_mixer) {
+            _fixed_mixer.num_motors = 0;
+        }
+
+        // start each run from the same state
+        memset(_thrust_rpyt_out, 0, sizeof(_thrust_rpyt_out));
+        memset(_thrust_rpyt_out_filt, 0, sizeof(_thrust_rpyt_out_filt));
+        limit = AP_Motors_limit {};
+        _thrust_balanced = true;
+        _dt = 0.0025f;
+
+        set_roll(in.roll);
+        set_pitch(in.pitch);
+        set_yaw(in.yaw);
+        _throttle_filter.reset(in.throttle);
+        set_throttle_avg_max(in.throttle_avg_max);
+        _throttle_thrust_max = 1.0f;
+        set_thrust_boost(in.boost_ratio > 0.0f);
+        _thrust_boost_ratio = in.boost_ratio;
+        _motor_lost_index = in.lost_motor;
+
+        output_armed_stabilizing();
+
+        memcpy(out.thrust, _thrust_rpyt_out, sizeof(out.thrust));
+        out.throttle_out = _throttle_out;
+        out.limit = limit;
+        out.lost_motor = _motor_lost_index;
+
+        _fixed_mixer.num_motors = fixed_motors;
+    }
+};
+
+static AP_MotorsMatrix_MixerTest motors;
+
+static const struct {
+    AP_Motors::motor_frame_class frame_class;
+    AP_Motors::motor_frame_type frame_type;
+    bool fixed;
+} frames[] {
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_X, true },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_PLUS, true },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_H, true },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_VTAIL, true },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_NYT_X, true },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_ALIGN_M460, true },
+    { AP_Motors::MOTOR_FRAME_HEXA, AP_Motors::MOTOR_FRAME_TYPE_X, true },
+    { AP_Motors::MOTOR_FRAME_HEXA, AP_Motors::MOTOR_FRAME_TYPE_PLUS, true },
+    { AP_Motors::MOTOR_FRAME_HEXA, AP_Motors::MOTOR_FRAME_TYPE_DJI_X, true },
+    { AP_Motors::MOTOR_FRAME_Y6, AP_Motors::MOTOR_FRAME_TYPE_Y6B, true },
+    { AP_Motors::MOTOR_FRAME_OCTA, AP_Motors::MOTOR_FRAME_TYPE_X, false },
+};
+
+static const float roll_pitch_inputs[] { -1.0f, -0.3f, -0.02f, 0.0f, 0.1f, 0.5f, 1.0f };
+static const float yaw_inputs[] { -1.0f, -0.2f, 0.0f, 0.05f, 0.7f };
+static const float throttle_inputs[] { 0.0f, 0.1f, 0.45f, 0.8f, 1.0f };
+static const float boost_inputs[] { 0.0f, 0.4f, 1.0f };
+
+// the specialised mixer must give exactly the same output as the generic mixer
+TEST(AP_MotorsMatrix, FixedMixerMatchesGeneric)
+{
+    for (const auto &frame : frames) {
+        motors.init(frame.frame_class, frame.frame_type);
+        ASSERT_TRUE(motors.initialised_ok());
+        EXPECT_EQ(motors.has_fixed_mixer(), frame.fixed);
+
+        for (const float roll : roll_pitch_inputs) {
+        for (const float pitch : roll_pitch_inputs) {
+        for (const float yaw : yaw_inputs) {
+        for (const float throttle : throttle_inputs) {
+        for (const float boost : boost_inputs) {
+            const AP_MotorsMatrix_MixerTest::Inputs in {
+                roll, pitch, yaw, throttle, 0.5f * (throttle + 1.0f), boost, 1
+            };
+            AP_MotorsMatrix_MixerTest::Outputs generic, fixed;
+            motors.mix(in, false, generic);
+            motors.mix(in, true, fixed);
+
+            for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+                EXPECT_EQ(generic.thrust[i], fixed.thrust[i]);
+            }
+            EXPECT_EQ(generic.throttle_out, fixed.throttle_out);
+            EXPECT_EQ(generic.limit.roll, fixed.limit.roll);
+            EXPECT_EQ(generic.limit.pitch, fixed.limit.pitch);
+            EXPECT_EQ(generic.limit.yaw, fixed.limit.yaw);
+            EXPECT_EQ(generic.limit.throttle_lower, fixed.limit.throttle_lower);
+            EXPECT_EQ(generic.limit.throttle_upper, fixed.limit.throttle_upper);
+            EXPECT_EQ(generic.lost_motor, fixed.lost_motor);
+        }
+        }
+        }
+        }
+        }
+    }
+}
+
+// the specialised mixer must follow changes to the factors
+TEST(AP_MotorsMatrix, FixedMixerDisableYawTorque)
+{
+    motors.init(AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_X);
+    motors.disable_yaw_torque();
+    ASSERT_TRUE(motors.has_fixed_mixer());
+
+    const AP_MotorsMatrix_MixerTest::Inputs in { 0.1f, -0.2f, 0.5f, 0.5f, 0.75f, 0.0f, 0 };
+    AP_MotorsMatrix_MixerTest::Outputs generic, fixed;
+    motors.mix(in, false, generic);
+    motors.mix(in, true, fixed);
+    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        EXPECT_EQ(generic.thrust[i], fixed.thrust[i]);
+    }
+    EXPECT_FALSE(fixed.limit.yaw);
+}
+
+AP_GTEST_MAIN()
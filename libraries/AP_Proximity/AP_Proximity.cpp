@@ -413,20 +413,20 @@ bool AP_Proximity::get_horizontal_distances(Proximity_Distance_Array &prx_dist_a
 }
 
 // get total number of obstacles, used in GPS based Simple Avoidance
-uint8_t AP_Proximity::get_obstacle_count() const
+uint16_t AP_Proximity::get_obstacle_count() const
 {
     return boundary.get_obstacle_count();
 }
 
 // get vector to obstacle based on obstacle_num passed, used in GPS based Simple Avoidance
-bool AP_Proximity::get_obstacle(uint8_t obstacle_num, Vector3f& vec_to_obstacle) const
+bool AP_Proximity::get_obstacle(uint16_t obstacle_num, Vector3f& vec_to_obstacle) const
 {
     return boundary.get_obstacle(obstacle_num, vec_to_obstacle);
 }
 
 // returns shortest distance to "obstacle_num" obstacle, from a line segment formed between "seg_start" and "seg_end"
 // returns FLT_MAX if it's an invalid instance.
-bool AP_Proximity::closest_point_from_segment_to_obstacle(uint8_t obstacle_num, const Vector3f& seg_start, const Vector3f& seg_end, Vector3f& closest_point) const
+bool AP_Proximity::closest_point_from_segment_to_obstacle(uint16_t obstacle_num, const Vector3f& seg_start, const Vector3f& seg_end, Vector3f& closest_point) const
 {
     return boundary.closest_point_from_segment_to_obstacle(obstacle_num , seg_start, seg_end, closest_point);
 }
@@ -451,7 +451,7 @@ bool AP_Proximity::get_object_angle_and_distance(uint8_t object_number, float& a
 }
 
 // get obstacle pitch and angle for a particular obstacle num
-bool AP_Proximity::get_obstacle_info(uint8_t obstacle_num, float &angle_deg, float &pitch, float &distance) const
+bool AP_Proximity::get_obstacle_info(uint16_t obstacle_num, float &angle_deg, float &pitch, float &distance) const
 {
     return boundary.get_obstacle_info(obstacle_num, angle_deg, pitch, distance);
 }
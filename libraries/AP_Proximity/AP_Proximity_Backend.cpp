@@ -145,4 +145,82 @@ void AP_Proximity_Backend::database_push(float angle, float pitch, float distanc
 #endif
 }
 
+// add a sample to the current scan
+void AP_Proximity_Backend::scan_add(float angle_deg, float distance_m)
+{
+    if (_scan == nullptr) {
+        _scan = new ScanBins;
+        if (_scan == nullptr) {
+            return;
+        }
+    }
+
+    if (ignore_reading(angle_deg, distance_m)) {
+        return;
+    }
+
+    // the bins are aligned with the boundary sectors so the sector can be found from the bin
+    const uint16_t bin = MIN(uint16_t(wrap_360(angle_deg + (PROXIMITY_SECTOR_WIDTH_DEG * 0.5f)) * (PROXIMITY_SCAN_NUM_BINS / 360.0f)), PROXIMITY_SCAN_NUM_BINS - 1);
+    _scan->scanned.set(bin);
+    if ((distance_m < distance_min()) || (distance_m > distance_max())) {
+        return;
+    }
+    if (!_scan->valid.get(bin) || (distance_m < _scan->distance_m[bin])) {
+        _scan->distance_m[bin] = distance_m;
+        _scan->angle_deg[bin] = angle_deg;
+        _scan->valid.set(bin);
+    }
+}
+
+// update the boundary and database from the current scan and start a new scan
+void AP_Proximity_Backend::scan_commit()
+{
+    if ((_scan == nullptr) || _scan->scanned.empty()) {
+        return;
+    }
+
+    // the vehicle position and attitude are only fetched once per scan
+    Vector3f current_pos;
+    Matrix3f body_to_ned;
+    const bool database_ready = database_prepare_for_push(current_pos, body_to_ned);
+    const uint32_t now_ms = AP_HAL::millis();
+
+    uint16_t bin = 0;
+    for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
+        bool scanned = false;
+        bool valid = false;
+        float shortest_distance_m = 0;
+        float shortest_angle_deg = 0;
+        for (uint8_t i=0; i < PROXIMITY_SCAN_BINS_PER_SECTOR; i++, bin++) {
+            if (!_scan->scanned.get(bin)) {
+                continue;
+            }
+            scanned = true;
+            if (!_scan->valid.get(bin)) {
+                continue;
+            }
+            if (database_ready) {
+                database_push(_scan->angle_deg[bin], _scan->distance_m[bin], now_ms, current_pos, body_to_ned);
+            }
+            if (!valid || (_scan->distance_m[bin] < shortest_distance_m)) {
+                shortest_distance_m = _scan->distance_m[bin];
+                shortest_angle_deg = _scan->angle_deg[bin];
+                valid = true;
+            }
+        }
+        if (!scanned) {
+            continue;
+        }
+        const AP_Proximity_Boundary_3D::Face face{PROXIMITY_MIDDLE_LAYER, sector};
+        if (valid) {
+            frontend.boundary.set_face_attributes(face, shortest_angle_deg, shortest_distance_m, state.instance);
+        } else {
+            frontend.boundary.reset_face(face, state.instance);
+        }
+    }
+
+    _scan->scanned.clearall();
+    _scan->valid.clearall();
+}
+
 #endif // HAL_PROXIMITY_ENABLED
@@ -18,8 +18,13 @@
 
 #if HAL_PROXIMITY_ENABLED
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/Bitmask.h>
 #include <AP_HAL/Semaphores.h>
 
+// scans are binned into about 5 degree wide bins, aligned with the boundary sectors
+#define PROXIMITY_SCAN_BINS_PER_SECTOR  ((PROXIMITY_NUM_SECTORS < 72) ? (72 / PROXIMITY_NUM_SECTORS) : 1)
+#define PROXIMITY_SCAN_NUM_BINS         (PROXIMITY_NUM_SECTORS * PROXIMITY_SCAN_BINS_PER_SECTOR)
+
 class AP_Proximity_Backend
 {
 public:
@@ -28,7 +33,7 @@ public:
 
     // we declare a virtual destructor so that Proximity drivers can
     // override with a custom destructor if need be
-    virtual ~AP_Proximity_Backend(void) {}
+    virtual ~AP_Proximity_Backend(void) { delete _scan; }
 
     // update the state structure
     virtual void update() = 0;
@@ -84,6 +89,18 @@ protected:
     };
     static void database_push(float angle, float pitch, float distance, uint32_t timestamp_ms, const Vector3f &current_pos, const Matrix3f &body_to_ned);
 
+    // scan helpers for sensors which produce many horizontal distances
+    // per revolution.  Samples are added with scan_add() and the
+    // boundary and database are updated once per packet or revolution
+    // by scan_commit().  angle is the body frame yaw in degrees
+    // (already corrected for orientation), distance is in meters and
+    // is valid from distance_min() to distance_max() inclusive
+    void scan_add(float angle_deg, float distance_m);
+    // update the boundary with the shortest distance in each face that
+    // was scanned, faces scanned without a valid distance are reset.
+    // The shortest distance in each bin is pushed to the database
+    void scan_commit();
+
     // semaphore for access to shared frontend data
     HAL_Semaphore _sem;
 
@@ -92,6 +109,16 @@ protected:
     AP_Proximity &frontend;
     AP_Proximity::Proximity_State &state;   // reference to this instances state
     AP_Proximity_Params &params;            // parameters for this backend
+
+private:
+
+    // shortest distance in each bin of the current scan, allocated on first use
+    struct ScanBins {
+        float distance_m[PROXIMITY_SCAN_NUM_BINS];  // shortest valid distance in each bin
+        float angle_deg[PROXIMITY_SCAN_NUM_BINS];   // yaw angle of the shortest distance
+        Bitmask<PROXIMITY_SCAN_NUM_BINS> scanned;   // bins which have received a sample
+        Bitmask<PROXIMITY_SCAN_NUM_BINS> valid;     // bins with a valid distance
+    } *_scan = nullptr;
 };
 
 #endif // HAL_PROXIMITY_ENABLED
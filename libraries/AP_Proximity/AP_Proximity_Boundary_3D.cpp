@@ -32,9 +32,9 @@ AP_Proximity_Boundary_3D::AP_Proximity_Boundary_3D()
 void AP_Proximity_Boundary_3D::init()
 {
     for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        const float pitch = ((float)_pitch_middle_deg[layer]);
+        const float pitch = get_pitch_middle_deg(layer);
         for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            const float angle_rad = ((float)_sector_middle_deg[sector]+(PROXIMITY_SECTOR_WIDTH_DEG/2.0f));
+            const float angle_rad = get_sector_middle_deg(sector)+(PROXIMITY_SECTOR_WIDTH_DEG/2.0f);
             _sector_edge_vector[layer][sector].offset_bearing(angle_rad, pitch, 100.0f);
             _boundary_points[layer][sector] = _sector_edge_vector[layer][sector] * PROXIMITY_BOUNDARY_DIST_DEFAULT;
         }
@@ -46,7 +46,11 @@ void AP_Proximity_Boundary_3D::init()
 // yaw is the horizontal body-frame angle (in degrees) to the obstacle (0=directly ahead of the vehicle, 90 is to the right of the vehicle)
 AP_Proximity_Boundary_3D::Face AP_Proximity_Boundary_3D::get_face(float pitch, float yaw) const
 {
-    const uint8_t sector = wrap_360(yaw + (PROXIMITY_SECTOR_WIDTH_DEG * 0.5f)) / 45.0f;
+    uint8_t sector = wrap_360(yaw + (PROXIMITY_SECTOR_WIDTH_DEG * 0.5f)) / PROXIMITY_SECTOR_WIDTH_DEG;
+    if (sector >= PROXIMITY_NUM_SECTORS) {
+        // rounding of angles just short of 360 degrees
+        sector = 0;
+    }
     const float pitch_limited = constrain_float(pitch, -75.0f, 74.9f);
     const uint8_t layer = (pitch_limited + 75.0f)/PROXIMITY_PITCH_WIDTH_DEG;
     return Face{layer, sector};
@@ -64,7 +68,7 @@ void AP_Proximity_Boundary_3D::set_face_attributes(const Face &face, float pitch
     }
 
     // ignore update if another instance has provided a shorter distance within the last 0.2 seconds
-    if ((prx_instance != _prx_instance[face.layer][face.sector]) && _distance_valid[face.layer][face.sector] && (_filtered_distance[face.layer][face.sector].get() < distance)) {
+    if ((prx_instance != _prx_instance[face.layer][face.sector]) && _distance_valid[face.layer].get(face.sector) && (_filtered_distance[face.layer][face.sector] < distance)) {
         // check if recent
         const uint32_t now_ms = AP_HAL::millis();
         if (now_ms - _last_update_ms[face.layer][face.sector] < PROXIMITY_FACE_RESET_MS) {
@@ -75,7 +79,7 @@ void AP_Proximity_Boundary_3D::set_face_attributes(const Face &face, float pitch
     _angle[face.layer][face.sector] = angle;
     _pitch[face.layer][face.sector] = pitch;
     _distance[face.layer][face.sector] = distance;
-    _distance_valid[face.layer][face.sector] = true;
+    _distance_valid[face.layer].set(face.sector);
     _prx_instance[face.layer][face.sector] = prx_instance;
 
     // apply filter
@@ -85,34 +89,22 @@ void AP_Proximity_Boundary_3D::set_face_attributes(const Face &face, float pitch
     update_boundary(face);
 }
 
-// apply a new cutoff_freq to low-pass filter
-void AP_Proximity_Boundary_3D::apply_filter_freq(float cutoff_freq)
-{
-    for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            _filtered_distance[layer][sector].set_cutoff_frequency(cutoff_freq);
-        }
-    }
-}
-
 // Apply low pass filter on the raw distance
 void AP_Proximity_Boundary_3D::set_filtered_distance(const Face &face, float distance)
 {
     if (!face.valid()) {
         return;
     }
-    if (!is_equal(_filtered_distance[face.layer][face.sector].get_cutoff_freq(), _filter_freq)) {
-        // cutoff freq has changed
-        apply_filter_freq(_filter_freq);
-    }
 
     const uint32_t now_ms = AP_HAL::millis();
-    const uint32_t dt = now_ms - _last_update_ms[face.layer][face.sector];
-    if (dt < PROXIMITY_FILT_RESET_TIME) {
-        _filtered_distance[face.layer][face.sector].apply(distance, dt* 0.001f);
+    const uint32_t last_update_ms = _last_update_ms[face.layer][face.sector];
+    const uint32_t dt = now_ms - last_update_ms;
+    float &filtered_distance = _filtered_distance[face.layer][face.sector];
+    if ((last_update_ms != 0) && (dt < PROXIMITY_FILT_RESET_TIME)) {
+        filtered_distance += (distance - filtered_distance) * calc_lowpass_alpha_dt(dt * 0.001f, _filter_freq);
     } else {
         // reset filter since last distance was passed a long time back
-        _filtered_distance[face.layer][face.sector].reset(distance);
+        filtered_distance = distance;
     }
     _last_update_ms[face.layer][face.sector] = now_ms;
 }
@@ -133,14 +125,16 @@ void AP_Proximity_Boundary_3D::update_boundary(const Face &face)
     // find adjacent sector (clockwise)
     const uint8_t next_sector = get_next_sector(sector);
 
+    const Bitmask<PROXIMITY_NUM_SECTORS> &valid = _distance_valid[layer];
+
     // boundary point lies on the line between the two sectors at the shorter distance found in the two sectors
     float shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    if (_distance_valid[layer][sector] && _distance_valid[layer][next_sector]) {
-        shortest_distance = MIN(_filtered_distance[layer][sector].get(), _filtered_distance[layer][next_sector].get());
-    } else if (_distance_valid[layer][sector]) {
-        shortest_distance = _filtered_distance[layer][sector].get();
-    } else if (_distance_valid[layer][next_sector]) {
-        shortest_distance = _filtered_distance[layer][next_sector].get();
+    if (valid.get(sector) && valid.get(next_sector)) {
+        shortest_distance = MIN(_filtered_distance[layer][sector], _filtered_distance[layer][next_sector]);
+    } else if (valid.get(sector)) {
+        shortest_distance = _filtered_distance[layer][sector];
+    } else if (valid.get(next_sector)) {
+        shortest_distance = _filtered_distance[layer][next_sector];
     }
     if (shortest_distance < PROXIMITY_BOUNDARY_DIST_MIN) {
         shortest_distance = PROXIMITY_BOUNDARY_DIST_MIN;
@@ -148,25 +142,25 @@ void AP_Proximity_Boundary_3D::update_boundary(const Face &face)
     _boundary_points[layer][sector] = _sector_edge_vector[layer][sector] * shortest_distance;
 
     // if the next sector (clockwise) has an invalid distance, set boundary to create a cup like boundary
-    if (!_distance_valid[layer][next_sector]) {
+    if (!valid.get(next_sector)) {
         _boundary_points[layer][next_sector] = _sector_edge_vector[layer][next_sector] * shortest_distance;
     }
 
     // repeat for edge between sector and previous sector
     const uint8_t prev_sector = get_prev_sector(sector);
     shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    if (_distance_valid[layer][prev_sector] && _distance_valid[layer][sector]) {
-        shortest_distance = MIN(_filtered_distance[layer][prev_sector].get(), _filtered_distance[layer][sector].get());
-    } else if (_distance_valid[layer][prev_sector]) {
-        shortest_distance = _filtered_distance[layer][prev_sector].get();
-    } else if (_distance_valid[layer][sector]) {
-        shortest_distance = _filtered_distance[layer][sector].get();
+    if (valid.get(prev_sector) && valid.get(sector)) {
+        shortest_distance = MIN(_filtered_distance[layer][prev_sector], _filtered_distance[layer][sector]);
+    } else if (valid.get(prev_sector)) {
+        shortest_distance = _filtered_distance[layer][prev_sector];
+    } else if (valid.get(sector)) {
+        shortest_distance = _filtered_distance[layer][sector];
     }
     _boundary_points[layer][prev_sector] = _sector_edge_vector[layer][prev_sector] * shortest_distance;
 
     // if the sector counter-clockwise from the previous sector has an invalid distance, set boundary to create a cup-like boundary
     const uint8_t prev_sector_ccw = get_prev_sector(prev_sector);
-    if (!_distance_valid[layer][prev_sector_ccw]) {
+    if (!valid.get(prev_sector_ccw)) {
         _boundary_points[layer][prev_sector_ccw] = _sector_edge_vector[layer][prev_sector_ccw] * shortest_distance;
     }
 }
@@ -175,9 +169,7 @@ void AP_Proximity_Boundary_3D::update_boundary(const Face &face)
 void AP_Proximity_Boundary_3D::reset()
 {
     for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            _distance_valid[layer][sector] = false;
-        }
+        _distance_valid[layer].clearall();
     }
 }
 
@@ -191,7 +183,7 @@ void AP_Proximity_Boundary_3D::reset_face(const Face &face, uint8_t prx_instance
     }
 
     // return immediately if face already has no valid distance
-    if (!_distance_valid[face.layer][face.sector]) {
+    if (!_distance_valid[face.layer].get(face.sector)) {
         return;
     }
 
@@ -203,7 +195,7 @@ void AP_Proximity_Boundary_3D::reset_face(const Face &face, uint8_t prx_instance
         }
     }
 
-    _distance_valid[face.layer][face.sector] = false;
+    _distance_valid[face.layer].clear(face.sector);
 
     // update simple avoidance boundary
     update_boundary(face);
@@ -220,13 +212,15 @@ void AP_Proximity_Boundary_3D::check_face_timeout()
     _last_check_face_timeout_ms = now_ms;
 
     for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
+        // most sensors only fill in a few layers
+        if (_distance_valid[layer].empty()) {
+            continue;
+        }
         for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            if (_distance_valid[layer][sector]) {
-                if ((now_ms - _last_update_ms[layer][sector]) > PROXIMITY_FACE_RESET_MS) {
-                    // this face has a valid distance but wasn't updated for a long time, reset it
-                    _distance_valid[layer][sector] = false;
-                    update_boundary(AP_Proximity_Boundary_3D::Face{layer, sector});
-                }
+            if (_distance_valid[layer].get(sector) && ((now_ms - _last_update_ms[layer][sector]) > PROXIMITY_FACE_RESET_MS)) {
+                // this face has a valid distance but wasn't updated for a long time, reset it
+                _distance_valid[layer].clear(sector);
+                update_boundary(AP_Proximity_Boundary_3D::Face{layer, sector});
             }
         }
     }
@@ -238,7 +232,7 @@ bool AP_Proximity_Boundary_3D::get_distance(const Face &face, float &distance) c
     if (!face.valid()) {
         return false;
     }
-    if (_distance_valid[face.layer][face.sector]) {
+    if (_distance_valid[face.layer].get(face.sector)) {
         distance = _distance[face.layer][face.sector];
         return true;
     }
@@ -247,7 +241,7 @@ bool AP_Proximity_Boundary_3D::get_distance(const Face &face, float &distance) c
 }
 
 // get the total number of obstacles 
-uint8_t AP_Proximity_Boundary_3D::get_obstacle_count() const
+uint16_t AP_Proximity_Boundary_3D::get_obstacle_count() const
 {
     return PROXIMITY_NUM_LAYERS * PROXIMITY_NUM_SECTORS;
 }
@@ -257,18 +251,27 @@ uint8_t AP_Proximity_Boundary_3D::get_obstacle_count() const
 // "update_boundary" method manipulates two sectors ccw and one sector cw from any valid face.
 // Any boundary that does not fall into these manipulated faces are useless, and will be marked as false
 // The resultant is packed into a Boundary Location object and returned by reference as "face"
-bool AP_Proximity_Boundary_3D::convert_obstacle_num_to_face(uint8_t obstacle_num, Face& face) const
+bool AP_Proximity_Boundary_3D::convert_obstacle_num_to_face(uint16_t obstacle_num, Face& face) const
 {
     // obstacle num is just "flattened layers, and sectors"
     const uint8_t layer = obstacle_num / PROXIMITY_NUM_SECTORS;
     const uint8_t sector = obstacle_num % PROXIMITY_NUM_SECTORS;
     face.sector = sector;
     face.layer = layer;
+    if (layer >= PROXIMITY_NUM_LAYERS) {
+        return false;
+    }
+
+    // layers without any valid distances are common, skip them quickly
+    const Bitmask<PROXIMITY_NUM_SECTORS> &valid = _distance_valid[layer];
+    if (valid.empty()) {
+        return false;
+    }
 
     uint8_t valid_sector = sector;
     // check for 3 adjacent sectors
     for (uint8_t i=0; i < 3; i++) {
-        if (_distance_valid[layer][valid_sector]) {
+        if (valid.get(valid_sector)) {
             // update boundary has manipulated this face
             return true;
         }
@@ -284,7 +287,7 @@ bool AP_Proximity_Boundary_3D::convert_obstacle_num_to_face(uint8_t obstacle_num
 // Then returns the closest point on this line from vehicle, in body-frame. 
 // Used by GPS based Simple Avoidance  
 // False is returned if the obstacle_num provided does not produce a valid obstacle 
-bool AP_Proximity_Boundary_3D::get_obstacle(uint8_t obstacle_num, Vector3f& vec_to_obstacle) const
+bool AP_Proximity_Boundary_3D::get_obstacle(uint16_t obstacle_num, Vector3f& vec_to_obstacle) const
 {
     Face face;
     if (!convert_obstacle_num_to_face(obstacle_num, face)) {
@@ -308,7 +311,7 @@ bool AP_Proximity_Boundary_3D::get_obstacle(uint8_t obstacle_num, Vector3f& vec_
 // This helps us know if the passed line segment was in the direction of the boundary, or going in a different direction.
 // Used by GPS based Simple Avoidance  - for "brake mode"
 // False is returned if the obstacle_num provided does not produce a valid obstacle
-bool AP_Proximity_Boundary_3D::closest_point_from_segment_to_obstacle(uint8_t obstacle_num, const Vector3f& seg_start, const Vector3f& seg_end, Vector3f& closest_point) const
+bool AP_Proximity_Boundary_3D::closest_point_from_segment_to_obstacle(uint16_t obstacle_num, const Vector3f& seg_start, const Vector3f& seg_end, Vector3f& closest_point) const
 {
     Face face;
     if (!convert_obstacle_num_to_face(obstacle_num, face)) {
@@ -344,7 +347,7 @@ bool AP_Proximity_Boundary_3D::get_closest_object(float& angle_deg, float &dista
     // lower layers might contain ground, which will give false pre-arm failure
     for (uint8_t layer=PROXIMITY_MIDDLE_LAYER; layer<PROXIMITY_NUM_LAYERS; layer++) {
         for (uint8_t sector=0; sector<PROXIMITY_NUM_SECTORS; sector++) {
-            if (_distance_valid[layer][sector]) {
+            if (_distance_valid[layer].get(sector)) {
                 if (!closest_found || (_distance[layer][sector] < _distance[closest_layer][closest_sector])) {
                     closest_layer = layer;
                     closest_sector = sector;
@@ -371,9 +374,9 @@ uint8_t AP_Proximity_Boundary_3D::get_horizontal_object_count() const
 // returns false if no angle or distance could be returned for some reason
 bool AP_Proximity_Boundary_3D::get_horizontal_object_angle_and_distance(uint8_t object_number, float &angle_deg, float &distance) const
 {
-    if ((object_number < PROXIMITY_NUM_SECTORS) && _distance_valid[PROXIMITY_MIDDLE_LAYER][object_number]) {
+    if ((object_number < PROXIMITY_NUM_SECTORS) && _distance_valid[PROXIMITY_MIDDLE_LAYER].get(object_number)) {
         angle_deg = _angle[PROXIMITY_MIDDLE_LAYER][object_number];
-        distance = _filtered_distance[PROXIMITY_MIDDLE_LAYER][object_number].get();
+        distance = _filtered_distance[PROXIMITY_MIDDLE_LAYER][object_number];
         return true;
     }
     return false;
@@ -381,15 +384,18 @@ bool AP_Proximity_Boundary_3D::get_horizontal_object_angle_and_distance(uint8_t
 
 // get an obstacle info for AP_Periph
 // returns false if no angle or distance could be returned for some reason
-bool AP_Proximity_Boundary_3D::get_obstacle_info(uint8_t obstacle_num, float &angle_deg, float &pitch_deg, float &distance) const
+bool AP_Proximity_Boundary_3D::get_obstacle_info(uint16_t obstacle_num, float &angle_deg, float &pitch_deg, float &distance) const
 {
     // obstacle num is just "flattened layers, and sectors"
     const uint8_t layer = obstacle_num / PROXIMITY_NUM_SECTORS;
     const uint8_t sector = obstacle_num % PROXIMITY_NUM_SECTORS;
-    if (_distance_valid[layer][sector]) {
+    if (layer >= PROXIMITY_NUM_LAYERS) {
+        return false;
+    }
+    if (_distance_valid[layer].get(sector)) {
         angle_deg = _angle[layer][sector];
         pitch_deg = _pitch[layer][sector];
-        distance = _filtered_distance[layer][sector].get();
+        distance = _filtered_distance[layer][sector];
         return true;
     }
 
@@ -403,36 +409,50 @@ bool AP_Proximity_Boundary_3D::get_filtered_distance(const Face &face, float &di
         return false;
     }
 
-    if (!_distance_valid[face.layer][face.sector]) {
+    if (!_distance_valid[face.layer].get(face.sector)) {
         // invalid distace
         return false;
     }
 
-    distance = _filtered_distance[face.layer][face.sector].get();
+    distance = _filtered_distance[face.layer][face.sector];
     return true;
 }
 
 // Get raw and filtered distances in 8 directions per layer
+// when there are more than 8 sectors each direction holds the shortest distance of the sectors it covers
 bool AP_Proximity_Boundary_3D::get_layer_distances(uint8_t layer_number, float dist_max, Proximity_Distance_Array &prx_dist_array, Proximity_Distance_Array &prx_filt_dist_array) const
 {
+    if (layer_number >= PROXIMITY_NUM_LAYERS) {
+        return false;
+    }
+
     // cycle through all sectors filling in distances and orientations
     // see MAV_SENSOR_ORIENTATION for orientations (0 = forward, 1 = 45 degree clockwise from north, etc)
+    // each direction takes the same number of sectors either side of the sector centred on it, with an even
+    // number of sectors per direction the sectors on the edge are shared with the neighbouring direction
+    const uint8_t sectors_per_direction = PROXIMITY_NUM_SECTORS / PROXIMITY_MAX_DIRECTION;
+    const uint8_t window_half_width = sectors_per_direction / 2;
     bool valid_distances = false;
     prx_dist_array.offset_valid = 0;
     prx_filt_dist_array.offset_valid = 0;
     for (uint8_t i=0; i<PROXIMITY_MAX_DIRECTION; i++) {
         prx_dist_array.orientation[i] = i;
-        const AP_Proximity_Boundary_3D::Face face(layer_number, i);
-        if (!face.valid()) {
-            return false;
-        }
-        if (get_distance(face, prx_dist_array.distance[i]) && get_filtered_distance(face, prx_filt_dist_array.distance[i])) {
+        prx_dist_array.distance[i] = dist_max;
+        prx_filt_dist_array.distance[i] = dist_max;
+
+        // sectors centred on this direction
+        uint8_t sector = (i * sectors_per_direction + PROXIMITY_NUM_SECTORS - window_half_width) % PROXIMITY_NUM_SECTORS;
+        for (uint8_t j=0; j<=2*window_half_width; j++, sector = get_next_sector(sector)) {
+            if (!_distance_valid[layer_number].get(sector)) {
+                continue;
+            }
+            if (!(prx_dist_array.offset_valid & (1U << i)) || (_distance[layer_number][sector] < prx_dist_array.distance[i])) {
+                prx_dist_array.distance[i] = _distance[layer_number][sector];
+                prx_filt_dist_array.distance[i] = _filtered_distance[layer_number][sector];
+            }
             valid_distances = true;
             prx_dist_array.offset_valid |= (1U << i);
             prx_filt_dist_array.offset_valid |= (1U << i);
-        } else {
-            prx_dist_array.distance[i] = dist_max;
-            prx_filt_dist_array.distance[i] = dist_max;
         }
     }
 
@@ -114,10 +114,8 @@ void AP_Proximity_LD06::get_readings()
                     _last_distance_received_ms =  current_ms;
                 }
 
-                // Updates the temporary boundary and passes off the completed data
+                // Adds the completed data to the scan, the boundary is updated once per revolution
                 parse_response_data();
-                _temp_boundary.update_3D_boundary(state.instance, frontend.boundary);
-                _temp_boundary.reset();
 
                 // Resets the bytes read and whether or not we are reading data to accept a new payload
                 _byte_count = 0;
@@ -160,6 +158,12 @@ void AP_Proximity_LD06::parse_response_data()
         uncorrected_angle = wrap_360(start_angle + (end_angle + 360 - start_angle) * 0.5);
     }
 
+    // The angle wraps back to zero at the start of each revolution, update the boundary and database with the last one
+    if (uncorrected_angle < _last_uncorrected_angle) {
+        scan_commit();
+    }
+    _last_uncorrected_angle = uncorrected_angle;
+
     // Takes the angle in the middle of the readings to be pushed to the database
     const float push_angle = correct_angle_for_orientation(uncorrected_angle);
 
@@ -189,10 +193,8 @@ void AP_Proximity_LD06::parse_response_data()
         // Gets the average distance read
         distance_avg /= sampled_counts;
 
-        // Pushes the average distance and angle to the obstacle avoidance database
-        const AP_Proximity_Boundary_3D::Face face = frontend.boundary.get_face(push_angle);
-        _temp_boundary.add_distance(face, push_angle, distance_avg);
-        database_push(push_angle, distance_avg);
+        // Adds the average distance and angle to the scan
+        scan_add(push_angle, distance_avg);
     }
 }
 #endif // AP_PROXIMITY_LD06_ENABLED
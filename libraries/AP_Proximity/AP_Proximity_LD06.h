@@ -63,7 +63,7 @@ private:
     // Store for error-tracking purposes
     uint32_t  _last_distance_received_ms;
 
-    // Boundary to store the measurements
-    AP_Proximity_Temp_Boundary _temp_boundary;
+    // Angle of the last packet before correcting for orientation, used to detect the start of a revolution
+    float _last_uncorrected_angle;
 };
 #endif // AP_PROXIMITY_LD06_ENABLED
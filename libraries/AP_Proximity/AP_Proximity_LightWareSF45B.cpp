@@ -30,7 +30,6 @@ extern const AP_HAL::HAL& hal;
 
 static const uint32_t PROXIMITY_SF45B_TIMEOUT_MS = 200;
 static const uint32_t PROXIMITY_SF45B_REINIT_INTERVAL_MS = 5000;    // re-initialise sensor after this many milliseconds
-static const float PROXIMITY_SF45B_COMBINE_READINGS_DEG = 5.0f;     // combine readings from within this many degrees to improve efficiency
 static const uint32_t PROXIMITY_SF45B_STREAM_DISTANCE_DATA_CM = 5;
 static const uint8_t PROXIMITY_SF45B_DESIRED_UPDATE_RATE = 6;       // 1:48hz, 2:55hz, 3:64hz, 4:77hz, 5:97hz, 6:129hz, 7:194hz, 8:388hz
 static const uint32_t PROXIMITY_SF45B_DESIRED_FIELDS = ((uint32_t)1 << 0 | (uint32_t)1 << 8);   // first return (unfiltered), yaw angle
@@ -142,52 +141,13 @@ void AP_Proximity_LightWareSF45B::process_message()
         const float distance_m = _distance_filt.apply((int16_t)UINT16_VALUE(_msg.payload[1], _msg.payload[0])) * 0.01f;
         const float angle_deg = correct_angle_for_orientation((int16_t)UINT16_VALUE(_msg.payload[3], _msg.payload[2]) * 0.01f);
 
-        // if distance is from a new face then update distance, angle and boundary for previous face
-        // get face from 3D boundary based on yaw angle to the object
+        // the sensor sweeps back and forth so the boundary and database are updated each time it moves onto a new face
         const AP_Proximity_Boundary_3D::Face face = frontend.boundary.get_face(angle_deg);
         if (face != _face) {
-            if (_face_distance_valid) {
-                frontend.boundary.set_face_attributes(_face, _face_yaw_deg, _face_distance, state.instance);
-            } else {
-                // mark previous face invalid
-                frontend.boundary.reset_face(_face, state.instance);
-            }
-            // record updated face
+            scan_commit();
             _face = face;
-            _face_yaw_deg = 0;
-            _face_distance = INT16_MAX;
-            _face_distance_valid = false;
-        }
-
-        // if distance is from a new minisector then update obstacle database using angle and distance from previous minisector
-        const uint8_t minisector = convert_angle_to_minisector(angle_deg);
-        if (minisector != _minisector) {
-            if ((_minisector != UINT8_MAX) && _minisector_distance_valid) {
-                database_push(_minisector_angle, _minisector_distance);
-            }
-            // init mini sector
-            _minisector = minisector;
-            _minisector_angle = 0;
-            _minisector_distance = INT16_MAX;
-            _minisector_distance_valid = false;
-        }
-
-        // check reading is valid
-        if (!ignore_reading(angle_deg, distance_m) && (distance_m >= distance_min()) && (distance_m <= distance_max())) {
-            // update shortest distance for this face
-            if (!_face_distance_valid || (distance_m < _face_distance)) {
-                _face_yaw_deg = angle_deg;
-                _face_distance = distance_m;
-                _face_distance_valid = true;
-            }
-
-            // update shortest distance for this mini sector
-            if (distance_m < _minisector_distance) {
-                _minisector_angle = angle_deg;
-                _minisector_distance = distance_m;
-                _minisector_distance_valid = true;
-            }
         }
+        scan_add(angle_deg, distance_m);
         break;
     }
 
@@ -197,10 +157,4 @@ void AP_Proximity_LightWareSF45B::process_message()
     }
 }
 
-// convert an angle (in degrees) to a mini sector number
-uint8_t AP_Proximity_LightWareSF45B::convert_angle_to_minisector(float angle_deg) const
-{
-    return wrap_360(angle_deg + (PROXIMITY_SF45B_COMBINE_READINGS_DEG * 0.5f)) / PROXIMITY_SF45B_COMBINE_READINGS_DEG;
-}
-
 #endif // AP_PROXIMITY_LIGHTWARE_SF45B_ENABLED
@@ -77,26 +77,13 @@ private:
     // process the latest message held in the msg structure
     void process_message();
 
-    // convert an angle (in degrees) to a mini sector number
-    uint8_t convert_angle_to_minisector(float angle_deg) const;
-
     // internal variables
     uint32_t _last_init_ms;                 // system time of last re-initialisation
     uint32_t _last_distance_received_ms;    // system time of last distance measurement received from sensor
     bool _init_complete;                    // true once sensor initialisation is complete
     ModeFilterInt16_Size3 _distance_filt{1};// mode filter to reduce glitches
 
-    // 3D boundary face and distance for latest readings
     AP_Proximity_Boundary_3D::Face _face;   // face of most recently received distance
-    float _face_distance;                   // shortest distance (in meters) on face
-    float _face_yaw_deg;                    // yaw angle (in degrees) of shortest distance on face
-    bool _face_distance_valid;              // true if face has at least one valid distance
-
-    // mini sector (5 degrees) angles and distances (used to populate obstacle database for path planning)
-    uint8_t _minisector = UINT8_MAX;        // mini sector number (from 0 to 71) of most recently received distance
-    float _minisector_distance;             // shortest distance (in meters) in mini sector
-    float _minisector_angle;                // angle (in degrees) of shortest distance in mini sector
-    bool _minisector_distance_valid;        // true if mini sector has at least one valid distance
 
     // state of sensor
     struct {
@@ -381,33 +381,12 @@ void AP_Proximity_RPLidarA2::parse_response_data()
     Debug(2, "   D%02.2f A%03.1f Q%0.2f", distance_m, angle_deg, quality);
 #endif
     _last_distance_received_ms = AP_HAL::millis();
-    if (!ignore_reading(angle_deg, distance_m)) {
-        const AP_Proximity_Boundary_3D::Face face = frontend.boundary.get_face(angle_deg);
 
-        if (face != _last_face) {
-            // distance is for a new face, the previous one can be updated now
-            if (_last_distance_valid) {
-                frontend.boundary.set_face_attributes(_last_face, _last_angle_deg, _last_distance_m, state.instance);
-            } else {
-                // reset distance from last face
-                frontend.boundary.reset_face(face, state.instance);
-            }
-
-            // initialize the new face
-            _last_face = face;
-            _last_distance_valid = false;
-        }
-        if (distance_m > distance_min()) {
-            // update shortest distance
-            if (!_last_distance_valid || (distance_m < _last_distance_m)) {
-                _last_distance_m = distance_m;
-                _last_distance_valid = true;
-                _last_angle_deg = angle_deg;
-            }
-            // update OA database
-            database_push(_last_angle_deg, _last_distance_m);
-        }
+    // the start bit marks the first sample of a new revolution, update the boundary with the last one
+    if (_payload.sensor_scan.startbit) {
+        scan_commit();
     }
+    scan_add(angle_deg, distance_m);
 }
 
 void AP_Proximity_RPLidarA2::parse_response_health()
@@ -22,6 +22,7 @@
 #include <GCS_MAVLink/GCS.h>
 
 #include "lua_scripts.h"
+#include <AP_Vehicle/AP_Vehicle.h>
 
 // ensure that we have a set of stack sizes, and enforce constraints around it
 // except for the minimum size, these are allowed to be defined by the build system
@@ -94,6 +95,8 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @Bitmask: 3: log runtime memory usage and execution time
     // @Bitmask: 4: Disable pre-arm check
     // @Bitmask: 5: Save CRC of current scripts to loaded and running checksum parameters enabling pre-arm
+    // @Bitmask: 6: Disable the cache of compiled scripts, in builds which include it
+    // @Bitmask: 7: Strip debug information from cached compiled scripts, saves memory but errors will not give line numbers
     // @User: Advanced
     AP_GROUPINFO("DEBUG_OPTS", 4, AP_Scripting, _debug_options, 0),
 
@@ -160,6 +163,15 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @RebootRequired: True
     // @User: Advanced
     AP_GROUPINFO("THD_PRIORITY", 14, AP_Scripting, _thd_priority, uint8_t(ThreadPriority::NORMAL)),
+
+    // @Param: POOL_PCT
+    // @DisplayName: Scripting small allocation pool size
+    // @Description: Percentage of the scripting heap reserved for pools of small Lua objects, which reduces heap fragmentation from scripts which create many short lived objects. Memory in the pools is not available for larger allocations, so SCR_HEAP_SIZE may need to be increased when this is used. 0 disables the pools.
+    // @Units: %
+    // @Range: 0 50
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("POOL_PCT", 15, AP_Scripting, _alloc_pool_pct, SCRIPTING_ALLOC_POOL_PERCENT),
     
     AP_GROUPEND
 };
@@ -290,7 +302,13 @@ void AP_Scripting::thread(void) {
         _restart = false;
         _init_failed = false;
 
-        lua_scripts *lua = new lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options, terminal);
+        // only mode changes from now on wake scripts
+        const AP_Vehicle *vehicle = AP::vehicle();
+        if (vehicle != nullptr) {
+            _last_mode = vehicle->get_mode();
+        }
+
+        lua_scripts *lua = new lua_scripts(_script_vm_exec_count, _script_heap_size, _alloc_pool_pct, _debug_options, terminal);
         if (lua == nullptr || !lua->heap_allocated()) {
             GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Scripting: %s", "Unable to allocate memory");
             _init_failed = true;
@@ -460,6 +478,7 @@ void AP_Scripting::handle_message(const mavlink_message_t &msg, const mavlink_ch
         }
         if (mavlink_data.accept_msg_ids[i] == msg.msgid) {
             mavlink_data.rx_buffer->push(data);
+            notify_event(EVENT_MAVLINK);
             return;
         }
     }
@@ -482,6 +501,63 @@ bool AP_Scripting::is_handling_command(uint16_t cmd_id)
 }
 #endif // HAL_GCS_ENABLED
 
+void AP_Scripting::notify_event(ScriptEvent event)
+{
+    {
+        WITH_SEMAPHORE(_event_sem);
+        if ((_waiting_events & event) == 0) {
+            return;
+        }
+        _pending_events |= event;
+    }
+    _event_signal.signal();
+}
+
+uint32_t AP_Scripting::wait_for_events(uint32_t waiting, uint32_t timeout_ms)
+{
+    {
+        WITH_SEMAPHORE(_event_sem);
+        _waiting_events = waiting;
+        if ((_pending_events & waiting) != 0) {
+            timeout_ms = 0;
+        }
+    }
+    if (timeout_ms > 0 && waiting == 0) {
+        // nothing can wake us early
+        hal.scheduler->delay(timeout_ms);
+    } else if (timeout_ms > 0) {
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+        // the semaphore times out on wall clock time in SITL, so wait
+        // in short steps of simulated time to keep speedup and lockstep
+        const uint32_t start_ms = AP_HAL::millis();
+        while (!_event_signal.wait_nonblocking() && AP_HAL::millis() - start_ms < timeout_ms) {
+            hal.scheduler->delay(1);
+        }
+#else
+        (void)_event_signal.wait(timeout_ms * 1000U);
+#endif
+    }
+
+    uint32_t events;
+    {
+        WITH_SEMAPHORE(_event_sem);
+        events = _pending_events & waiting;
+        _pending_events = 0;
+    }
+
+    // vehicles don't share a mode change hook, so look for one here
+    const AP_Vehicle *vehicle = AP::vehicle();
+    if (vehicle != nullptr) {
+        const uint8_t mode = vehicle->get_mode();
+        if (mode != _last_mode) {
+            _last_mode = mode;
+            events |= waiting & EVENT_MODE_CHANGE;
+        }
+    }
+
+    return events;
+}
+
 // Update called at 1Hz from AP_Vehicle
 void AP_Scripting::update() {
 
@@ -75,6 +75,27 @@ public:
     
     void restart_all(void);
 
+    // events scripts can ask to be woken by with wake_on()
+    enum ScriptEvent : uint32_t {
+        EVENT_MODE_CHANGE = 1U << 0,
+        EVENT_ARMING = 1U << 1,
+        EVENT_RC_AUX = 1U << 2,
+        EVENT_MAVLINK = 1U << 3,
+        EVENT_PARAM_CHANGE = 1U << 4,
+    };
+
+    // record an event, waking the scripts waiting for it. Can be called from any thread
+    void notify_event(ScriptEvent event);
+
+    // called by the running script, it will be run again as soon as
+    // one of the events happens rather than waiting for its full delay
+    void wake_on(uint32_t events) { _wake_on_events = events; }
+    uint32_t get_wake_on_events() const { return _wake_on_events; }
+
+    // return the events in waiting which have happened since the last
+    // call, waiting up to timeout_ms for one if there are none
+    uint32_t wait_for_events(uint32_t waiting, uint32_t timeout_ms);
+
    // User parameters for inputs into scripts 
    AP_Float _user[6];
 
@@ -179,6 +200,7 @@ private:
     AP_Int32 _required_running_checksum;
 
     AP_Enum<ThreadPriority> _thd_priority;
+    AP_Int8 _alloc_pool_pct;
 
     bool _thread_failed; // thread allocation failed
     bool _init_failed;  // true if memory allocation failed
@@ -187,6 +209,14 @@ private:
 
     static AP_Scripting *_singleton;
     int current_ref;
+
+    // event wakeups
+    HAL_BinarySemaphore _event_signal;
+    HAL_Semaphore _event_sem;
+    uint32_t _pending_events;
+    uint32_t _waiting_events;
+    uint32_t _wake_on_events;
+    uint8_t _last_mode;
 };
 
 namespace AP {
@@ -3209,6 +3209,14 @@ function ahrs:get_location() end
 ---@return Location_ud|nil
 function ahrs:get_position() end
 
+-- get the attitude, location and velocity in one call, this is quicker than calling get_roll, get_pitch, get_yaw, get_location and get_velocity_NED separately
+---@return number -- roll in radians
+---@return number -- pitch in radians
+---@return number -- yaw in radians
+---@return Location_ud|nil -- location, nil if not available
+---@return Vector3f_ud|nil -- NED velocity in m/s, nil if not available
+function ahrs:get_state() end
+
 -- desc
 ---@return number
 function ahrs:get_yaw() end
@@ -3304,11 +3312,23 @@ function follow:have_target() end
 
 -- desc
 ---@class scripting
+---@field EVENT_MODE_CHANGE number
+---@field EVENT_ARMING number
+---@field EVENT_RC_AUX number
+---@field EVENT_MAVLINK number
+---@field EVENT_PARAM_CHANGE number
 scripting = {}
 
 -- desc
 function scripting:restart_all() end
 
+-- Run the script again as soon as one of the events happens rather than waiting for the full delay it returns.
+-- Must be called on every run, the delay returned is used as a timeout. Scripts may also be woken by events
+-- which don't change anything they are interested in so should still check the state they depend on.
+-- MAVLink events are for messages registered with mavlink:register_rx_msgid()
+---@param events uint32_t_ud|integer -- bitmask of scripting.EVENT_MODE_CHANGE, EVENT_ARMING, EVENT_RC_AUX, EVENT_MAVLINK and EVENT_PARAM_CHANGE
+function scripting:wake_on(events) end
+
 -- desc
 ---@param directoryname string
 ---@return table -- table of filenames
@@ -0,0 +1,25 @@
+-- This script is an example of waiting for vehicle events rather than polling for them
+-- it reports mode changes and arming, and otherwise only runs once a minute
+
+local last_mode = -1
+local last_armed = nil
+
+function update()
+  local mode = vehicle:get_mode()
+  if mode ~= last_mode then
+    gcs:send_text(6, string.format("Mode changed to %d", mode))
+    last_mode = mode
+  end
+
+  local armed = arming:is_armed()
+  if armed ~= last_armed then
+    gcs:send_text(6, armed and "Armed" or "Disarmed")
+    last_armed = armed
+  end
+
+  -- run again as soon as the mode or arming state changes, or in a minute if they don't
+  scripting:wake_on(scripting.EVENT_MODE_CHANGE | scripting.EVENT_ARMING)
+  return update, 60000
+end
+
+return update()
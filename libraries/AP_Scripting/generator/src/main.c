@@ -1335,10 +1335,14 @@ void emit_singleton_checkers(void) {
     if (!(node->flags & UD_FLAG_LITERAL) && (node->methods != NULL)) {
       start_dependency(source, node->dependency);
       fprintf(source, "%s * check_%s(lua_State *L) {\n", node->name, node->sanatized_name);
-      fprintf(source, "    %s * ud = %s::get_singleton();\n", node->name, node->name);
+      // singletons are never freed, so once found the pointer is kept to save looking it up on every call
+      fprintf(source, "    static %s * ud;\n", node->name);
       fprintf(source, "    if (ud == nullptr) {\n");
-      fprintf(source, "        // This error will never return, so there is no danger of returning a nullptr\n");
-      fprintf(source, "        not_supported_error(L, 1, \"%s\");\n", node->rename ? node->rename : node->name);
+      fprintf(source, "        ud = %s::get_singleton();\n", node->name);
+      fprintf(source, "        if (ud == nullptr) {\n");
+      fprintf(source, "            // This error will never return, so there is no danger of returning a nullptr\n");
+      fprintf(source, "            not_supported_error(L, 1, \"%s\");\n", node->rename ? node->rename : node->name);
+      fprintf(source, "        }\n");
       fprintf(source, "    }\n");
       fprintf(source, "    return ud;\n");
       fprintf(source, "}\n");
@@ -2331,8 +2335,7 @@ void emit_loaders(void) {
   fprintf(source, "    // userdata metatables\n");
   fprintf(source, "    for (uint32_t i = 0; i < ARRAY_SIZE(userdata_fun); i++) {\n");
   fprintf(source, "        luaL_newmetatable(L, userdata_fun[i].name);\n");
-  fprintf(source, "        lua_pushcclosure(L, userdata_fun[i].func, 0);\n");
-  fprintf(source, "        lua_setfield(L, -2, \"__index\");\n");
+  fprintf(source, "        set_cached_index(L, userdata_fun[i].func);\n");
 
   fprintf(source, "        if (userdata_fun[i].operators != nullptr) {\n");
   fprintf(source, "            luaL_setfuncs(L, userdata_fun[i].operators, 0);\n");
@@ -2353,8 +2356,7 @@ void emit_loaders(void) {
   fprintf(source, "    // ap object metatables\n");
   fprintf(source, "    for (uint32_t i = 0; i < ARRAY_SIZE(ap_object_fun); i++) {\n");
   fprintf(source, "        luaL_newmetatable(L, ap_object_fun[i].name);\n");
-  fprintf(source, "        lua_pushcclosure(L, ap_object_fun[i].func, 0);\n");
-  fprintf(source, "        lua_setfield(L, -2, \"__index\");\n");
+  fprintf(source, "        set_cached_index(L, ap_object_fun[i].func);\n");
   fprintf(source, "        lua_pushstring(L, \"__call\");\n");
   fprintf(source, "        lua_pushvalue(L, -2);\n");
   fprintf(source, "        lua_settable(L, -3);\n");
@@ -2370,8 +2372,7 @@ void emit_loaders(void) {
   fprintf(source, "    // singleton metatables\n");
   fprintf(source, "    for (uint32_t i = 0; i < ARRAY_SIZE(singleton_fun); i++) {\n");
   fprintf(source, "        luaL_newmetatable(L, singleton_fun[i].name);\n");
-  fprintf(source, "        lua_pushcclosure(L, singleton_fun[i].func, 0);\n");
-  fprintf(source, "        lua_setfield(L, -2, \"__index\");\n");
+  fprintf(source, "        set_cached_index(L, singleton_fun[i].func);\n");
   fprintf(source, "        lua_pushstring(L, \"__call\");\n");
   fprintf(source, "        lua_pushvalue(L, -2);\n");
   fprintf(source, "        lua_settable(L, -3);\n");
@@ -2810,6 +2811,34 @@ void emit_index_helpers(void) {
 
   fprintf(source, "#pragma GCC diagnostic pop\n\n");
 
+  // looking up a method by name is a string compare against every entry in the
+  // meta table, so the result of each lookup is kept in a table and later lookups
+  // of the same name are a plain table access that never leaves the VM
+  fprintf(source, "static int cached_index(lua_State *L) {\n");
+  fprintf(source, "    // called with the cache table and the key, the uncached index function is the upvalue\n");
+  fprintf(source, "    lua_pushvalue(L, lua_upvalueindex(1));\n");
+  fprintf(source, "    lua_pushvalue(L, 1);\n");
+  fprintf(source, "    lua_pushvalue(L, 2);\n");
+  fprintf(source, "    lua_call(L, 2, 1);\n");
+  fprintf(source, "    if (!lua_isnil(L, -1) && (lua_type(L, 2) == LUA_TSTRING)) {\n");
+  fprintf(source, "        lua_pushvalue(L, 2);\n");
+  fprintf(source, "        lua_pushvalue(L, -2);\n");
+  fprintf(source, "        lua_rawset(L, 1);\n");
+  fprintf(source, "    }\n");
+  fprintf(source, "    return 1;\n");
+  fprintf(source, "}\n\n");
+
+  // replaces the __index function of the meta table on the top of the stack with a cache table
+  fprintf(source, "static void set_cached_index(lua_State *L, lua_CFunction index) {\n");
+  fprintf(source, "    lua_newtable(L);\n");
+  fprintf(source, "    lua_newtable(L);\n");
+  fprintf(source, "    lua_pushcfunction(L, index);\n");
+  fprintf(source, "    lua_pushcclosure(L, cached_index, 1);\n");
+  fprintf(source, "    lua_setfield(L, -2, \"__index\");\n");
+  fprintf(source, "    lua_setmetatable(L, -2);\n");
+  fprintf(source, "    lua_setfield(L, -2, \"__index\");\n");
+  fprintf(source, "}\n\n");
+
 }
 
 void emit_structs(void) {
@@ -776,9 +776,10 @@ static void f_parser (lua_State *L, void *ud) {
   LClosure *cl;
   struct SParser *p = cast(struct SParser *, ud);
   int c = zgetc(p->z);  /* read first character */
-#if LUA_SUPPORT_LOAD_BINARY
-  // support loading pre-compiled luac
-  if (c == LUA_SIGNATURE[0]) {
+#if LUA_SUPPORT_LOAD_BINARY || AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+  // support loading pre-compiled luac, without general binary support
+  // only chunks from the bytecode cache may be binary
+  if (c == LUA_SIGNATURE[0] && (LUA_SUPPORT_LOAD_BINARY || p->mode == lua_bytecode_cache_mode)) {
     checkmode(L, p->mode, "binary");
     cl = luaU_undump(L, p->z, p->name);
   }
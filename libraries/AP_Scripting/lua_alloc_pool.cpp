@@ -0,0 +1,153 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Scripting_config.h"
+
+#if AP_SCRIPTING_ENABLED
+
+#include "lua_alloc_pool.h"
+#include <AP_Math/AP_Math.h>
+
+bool lua_alloc_pool::init(MultiHeap &heap, uint32_t size)
+{
+    destroy();
+    _heap = &heap;
+
+    const uint16_t num_slabs = MIN(size / SLAB_SIZE, UINT16_MAX);
+    if (num_slabs == 0) {
+        return false;
+    }
+    _region = (uint8_t *)heap.allocate(num_slabs * SLAB_SIZE);
+    _slab_class = (uint8_t *)heap.allocate(num_slabs);
+    if (_region == nullptr || _slab_class == nullptr) {
+        if (_region != nullptr) {
+            heap.deallocate(_region);
+            _region = nullptr;
+        }
+        if (_slab_class != nullptr) {
+            heap.deallocate(_slab_class);
+            _slab_class = nullptr;
+        }
+        return false;
+    }
+    memset(_slab_class, NO_CLASS, num_slabs);
+    _num_slabs = num_slabs;
+    return true;
+}
+
+void lua_alloc_pool::destroy(void)
+{
+    if (_heap != nullptr && _region != nullptr) {
+        _heap->deallocate(_region);
+        _heap->deallocate(_slab_class);
+    }
+    _region = nullptr;
+    _slab_class = nullptr;
+    _num_slabs = 0;
+    _slabs_used = 0;
+    memset(_free, 0, sizeof(_free));
+    _used = 0;
+    _heap_fallbacks = 0;
+}
+
+uint8_t lua_alloc_pool::size_class_of(const void *ptr) const
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    if (_region == nullptr || p < _region || p >= _region + _slabs_used * SLAB_SIZE) {
+        return NO_CLASS;
+    }
+    return _slab_class[(p - _region) / SLAB_SIZE];
+}
+
+bool lua_alloc_pool::add_slab(uint8_t size_class)
+{
+    if (_slabs_used >= _num_slabs) {
+        return false;
+    }
+    _slab_class[_slabs_used] = size_class;
+    uint8_t *slab = &_region[_slabs_used * SLAB_SIZE];
+    _slabs_used++;
+
+    // any space left over at the end of the slab is not used
+    const uint32_t size = block_size(size_class);
+    for (uint32_t ofs = 0; ofs + size <= SLAB_SIZE; ofs += size) {
+        free_block_t *block = (free_block_t *)&slab[ofs];
+        block->next = _free[size_class];
+        _free[size_class] = block;
+    }
+    return true;
+}
+
+void *lua_alloc_pool::allocate(uint32_t size)
+{
+    if (size > MAX_BLOCK_SIZE || _region == nullptr) {
+        return _heap->allocate(size);
+    }
+    const uint8_t size_class = size_class_for(size);
+    if (_free[size_class] == nullptr && !add_slab(size_class)) {
+        _heap_fallbacks++;
+        return _heap->allocate(size);
+    }
+    free_block_t *block = _free[size_class];
+    _free[size_class] = block->next;
+    _used += block_size(size_class);
+    return block;
+}
+
+void lua_alloc_pool::free_block(void *ptr, uint8_t size_class)
+{
+    free_block_t *block = (free_block_t *)ptr;
+    block->next = _free[size_class];
+    _free[size_class] = block;
+    _used -= block_size(size_class);
+}
+
+void *lua_alloc_pool::change_size(void *ptr, uint32_t old_size, uint32_t new_size)
+{
+    if (ptr == nullptr) {
+        // old_size is the type of object being created, not a size
+        return (new_size == 0) ? nullptr : allocate(new_size);
+    }
+
+    const uint8_t size_class = size_class_of(ptr);
+    if (size_class == NO_CLASS) {
+        return _heap->change_size(ptr, old_size, new_size);
+    }
+
+    if (new_size == 0) {
+        free_block(ptr, size_class);
+        return nullptr;
+    }
+    if (new_size <= block_size(size_class)) {
+        // still fits, this also means shrinking never fails
+        return ptr;
+    }
+    void *new_ptr = allocate(new_size);
+    if (new_ptr == nullptr) {
+        return nullptr;
+    }
+    memcpy(new_ptr, ptr, MIN(old_size, block_size(size_class)));
+    free_block(ptr, size_class);
+    return new_ptr;
+}
+
+void lua_alloc_pool::get_stats(struct stats &s) const
+{
+    s.pool_size = _num_slabs * SLAB_SIZE;
+    s.used = _used;
+    s.heap_fallbacks = _heap_fallbacks;
+}
+
+#endif  // AP_SCRIPTING_ENABLED
@@ -0,0 +1,94 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "AP_Scripting_config.h"
+
+#if AP_SCRIPTING_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Common/MultiHeap.h>
+
+/*
+  pools of small fixed size blocks in front of the scripting heap.
+
+  Scripts create a lot of short lived userdata (Vector3f, Location,
+  uint32_t), short strings, closures and upvalues. Giving these their
+  own pools keeps them out of the general heap, so they don't fragment
+  it, and makes allocating and freeing them constant time.
+
+  The pools are a single region of the heap split into slabs. Each
+  slab is given to a size class the first time that class runs out of
+  blocks and stays with it. Allocations which are too large or which
+  don't fit in the pools go to the heap.
+ */
+class lua_alloc_pool {
+public:
+    // take size bytes from heap for the pools, returns false if the
+    // pools could not be allocated, all allocations then use the heap
+    bool init(MultiHeap &heap, uint32_t size);
+
+    // free the pools, all blocks from the pools must have been freed
+    void destroy(void);
+
+    // true if the pools have been allocated
+    bool enabled(void) const { return _region != nullptr; }
+
+    // allocate, reallocate or free with the same contract as a
+    // lua_Alloc function
+    void *change_size(void *ptr, uint32_t old_size, uint32_t new_size);
+
+    struct stats {
+        uint32_t pool_size;         // bytes reserved for the pools
+        uint32_t used;              // bytes of pool blocks in use
+        uint32_t heap_fallbacks;    // small allocations which went to the heap as their pool was full
+    };
+    void get_stats(struct stats &s) const;
+
+private:
+    static constexpr uint32_t SLAB_SIZE = 512;
+    static constexpr uint8_t BLOCK_ALIGN = 8;
+    static constexpr uint8_t NUM_CLASSES = 7;   // blocks of 16 to 64 bytes
+    static constexpr uint32_t MAX_BLOCK_SIZE = BLOCK_ALIGN * (NUM_CLASSES + 1);
+    static constexpr uint8_t NO_CLASS = 0xFF;
+
+    static uint32_t block_size(uint8_t size_class) { return BLOCK_ALIGN * (size_class + 2); }
+    static uint8_t size_class_for(uint32_t size) { return (size <= 2 * BLOCK_ALIGN) ? 0 : (size + BLOCK_ALIGN - 1) / BLOCK_ALIGN - 2; }
+
+    // size class of the block ptr is in, NO_CLASS if it is from the heap
+    uint8_t size_class_of(const void *ptr) const;
+
+    void *allocate(uint32_t size);
+    void free_block(void *ptr, uint8_t size_class);
+
+    // give the next unused slab to a size class
+    bool add_slab(uint8_t size_class);
+
+    struct free_block_t {
+        free_block_t *next;
+    };
+
+    MultiHeap *_heap;
+    uint8_t *_region;
+    uint8_t *_slab_class;       // size class of each slab
+    uint16_t _num_slabs;
+    uint16_t _slabs_used;
+    free_block_t *_free[NUM_CLASSES];
+
+    uint32_t _used;
+    uint32_t _heap_fallbacks;
+};
+
+#endif  // AP_SCRIPTING_ENABLED
@@ -762,6 +762,46 @@ int SRV_Channels_get_safety_state(lua_State *L) {
     return 1;
 }
 
+#if AP_AHRS_ENABLED
+// attitude, position and velocity in one call, saving scripts that need
+// the full state a binding call and a semaphore take for each value
+int AP_AHRS_get_state(lua_State *L) {
+    binding_argcheck(L, 1);
+
+    float roll, pitch, yaw;
+    Location loc;
+    Vector3f vel;
+    bool have_loc, have_vel;
+    {
+        // nothing below can raise an error while the semaphore is held
+        AP_AHRS &ahrs = AP::ahrs();
+        WITH_SEMAPHORE(ahrs.get_semaphore());
+        roll = ahrs.get_roll();
+        pitch = ahrs.get_pitch();
+        yaw = ahrs.get_yaw();
+        have_loc = ahrs.get_location(loc);
+        have_vel = ahrs.get_velocity_NED(vel);
+    }
+
+    lua_pushnumber(L, roll);
+    lua_pushnumber(L, pitch);
+    lua_pushnumber(L, yaw);
+    if (have_loc) {
+        new_Location(L);
+        *check_Location(L, -1) = loc;
+    } else {
+        lua_pushnil(L);
+    }
+    if (have_vel) {
+        new_Vector3f(L);
+        *check_Vector3f(L, -1) = vel;
+    } else {
+        lua_pushnil(L);
+    }
+    return 5;
+}
+#endif // AP_AHRS_ENABLED
+
 int lua_get_PWMSource(lua_State *L) {
     binding_argcheck(L, 0);
 
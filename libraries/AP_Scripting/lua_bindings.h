@@ -14,6 +14,7 @@ int lua_get_CAN_device2(lua_State *L);
 int lua_dirlist(lua_State *L);
 int lua_removefile(lua_State *L);
 int SRV_Channels_get_safety_state(lua_State *L);
+int AP_AHRS_get_state(lua_State *L);
 int lua_get_PWMSource(lua_State *L);
 int lua_get_SocketAPM(lua_State *L);
 int SocketAPM_recv(lua_State *L);
@@ -26,4 +26,39 @@
   #define REPL_OUT REPL_DIRECTORY "/out"
 #endif // REPL_OUT
 
+// cache compiled scripts on the filesystem. Lua does not verify
+// bytecode, and the cache directory can be written over MAVLink FTP, so
+// a crafted cache file can corrupt memory. Only enable this on vehicles
+// where the filesystem is trusted
+#ifndef AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+  #define AP_SCRIPTING_BYTECODE_CACHE_ENABLED 0
+#endif // AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+
+#ifndef SCRIPTING_CACHE_DIRECTORY
+  #if HAL_OS_FATFS_IO
+    #define SCRIPTING_CACHE_DIRECTORY "/APM/scripts_cache"
+  #else
+    #define SCRIPTING_CACHE_DIRECTORY "./scripts_cache"
+  #endif //HAL_OS_FATFS_IO
+#endif // SCRIPTING_CACHE_DIRECTORY
+
+// how often the vehicle mode is checked while scripts wait for a mode change
+#ifndef SCRIPTING_MODE_CHANGE_POLL_MS
+  #define SCRIPTING_MODE_CHANGE_POLL_MS 20U
+#endif // SCRIPTING_MODE_CHANGE_POLL_MS
+
+// default for SCR_POOL_PCT, the percentage of the scripting heap
+// reserved for pools of small fixed size blocks, zero disables the pools
+#ifndef SCRIPTING_ALLOC_POOL_PERCENT
+  #define SCRIPTING_ALLOC_POOL_PERCENT 0
+#endif // SCRIPTING_ALLOC_POOL_PERCENT
+
 int lua_get_current_ref();
+
+// load a script or module, from the bytecode cache if possible
+struct lua_State;
+int lua_scripts_loadfile(struct lua_State *L, const char *filename);
+
+// load mode which allows binary chunks, only used for the bytecode
+// cache so scripts can't load bytecode themselves
+extern const char lua_bytecode_cache_mode[];
@@ -37,19 +37,34 @@ HAL_Semaphore lua_scripts::error_msg_buf_sem;
 uint8_t lua_scripts::print_error_count;
 uint32_t lua_scripts::last_print_ms;
 
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+bool lua_scripts::bytecode_cache_enabled;
+bool lua_scripts::bytecode_cache_strip;
+#define BYTECODE_CACHE_MAGIC 0x4C434150 // APCL
+#endif
+const char lua_bytecode_cache_mode[] = "b";
+
 uint32_t lua_scripts::loaded_checksum;
 uint32_t lua_scripts::running_checksum;
 HAL_Semaphore lua_scripts::crc_sem;
 
-lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, const AP_Int8 &debug_options, struct AP_Scripting::terminal_s &_terminal)
+lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, const AP_Int8 &alloc_pool_pct, const AP_Int8 &debug_options, struct AP_Scripting::terminal_s &_terminal)
     : _vm_steps(vm_steps),
       _debug_options(debug_options),
      terminal(_terminal)
 {
     _heap.create(heap_size, 4);
+
+    // the pools are opt-in, memory in them can't be used for larger
+    // allocations
+    const uint8_t pool_pct = constrain_int16(alloc_pool_pct.get(), 0, 50);
+    if (_heap.available() && pool_pct > 0) {
+        _pool.init(_heap, uint32_t(heap_size.get()) / 100 * pool_pct);
+    }
 }
 
 lua_scripts::~lua_scripts() {
+    _pool.destroy();
     _heap.destroy();
 }
 
@@ -129,13 +144,22 @@ int lua_scripts::atpanic(lua_State *L) {
 }
 
 // helper for print and log of runtime stats
-void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem)
+void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem, uint32_t cache_saved_us)
 {
+    lua_alloc_pool::stats pool_stats;
+    _pool.get_stats(pool_stats);
+
     if ((_debug_options.get() & uint8_t(DebugLevel::RUNTIME_MSG)) != 0) {
-        GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Time: %u Mem: %d + %d",
+        GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Time: %u Mem: %d + %d Pool: %u/%u miss %u",
                                             (unsigned int)run_time,
                                             (int)total_mem,
-                                            (int)run_mem);
+                                            (int)run_mem,
+                                            (unsigned int)pool_stats.used,
+                                            (unsigned int)pool_stats.pool_size,
+                                            (unsigned int)pool_stats.heap_fallbacks);
+        if (cache_saved_us != 0) {
+            GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Loaded from cache, saved %u us", (unsigned int)cache_saved_us);
+        }
     }
 #if HAL_LOGGING_ENABLED
     if ((_debug_options.get() & uint8_t(DebugLevel::LOG_RUNTIME)) != 0) {
@@ -145,7 +169,9 @@ void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_me
             name         : {},
             run_time     : run_time,
             total_mem    : total_mem,
-            run_mem      : run_mem
+            run_mem      : run_mem,
+            pool_mem     : pool_stats.used,
+            pool_miss    : pool_stats.heap_fallbacks
         };
         const char * name_short = strrchr(name, '/');
         if ((strlen(name) > sizeof(pkt.name)) && (name_short != nullptr)) {
@@ -158,13 +184,136 @@ void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_me
 #endif // HAL_LOGGING_ENABLED
 }
 
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+struct bytecode_cache_reader {
+    int fd;
+    char buf[128];
+};
+
+static const char *bytecode_cache_read(lua_State *, void *ud, size_t *size)
+{
+    bytecode_cache_reader *reader = (bytecode_cache_reader *)ud;
+    const int32_t n = AP::FS().read(reader->fd, reader->buf, sizeof(reader->buf));
+    if (n <= 0) {
+        *size = 0;
+        return nullptr;
+    }
+    *size = n;
+    return reader->buf;
+}
+
+static int bytecode_cache_write(lua_State *, const void *p, size_t size, void *ud)
+{
+    const int fd = *(int *)ud;
+    return (AP::FS().write(fd, p, size) == int32_t(size)) ? 0 : 1;
+}
+
+bool lua_scripts::load_from_cache(lua_State *L, const char *filename, const char *cache_name, const bytecode_cache_header &expected, uint32_t &compile_us)
+{
+    bytecode_cache_reader reader;
+    reader.fd = AP::FS().open(cache_name, O_RDONLY);
+    if (reader.fd == -1) {
+        return false;
+    }
+    bytecode_cache_header header;
+    if (AP::FS().read(reader.fd, &header, sizeof(header)) != sizeof(header) ||
+        header.magic != expected.magic ||
+        header.lua_version != expected.lua_version ||
+        header.lua_number_size != expected.lua_number_size ||
+        header.strip != expected.strip ||
+        header.source_crc != expected.source_crc) {
+        // stale or from a different VM, it will be replaced
+        AP::FS().close(reader.fd);
+        return false;
+    }
+
+    // the chunk header is checked against the VM as it is loaded
+    lua_pushfstring(L, "@%s", filename);
+    const int status = lua_load(L, bytecode_cache_read, &reader, lua_tostring(L, -1), lua_bytecode_cache_mode);
+    AP::FS().close(reader.fd);
+    lua_remove(L, -2);  // remove chunk name
+    if (status != LUA_OK) {
+        lua_pop(L, 1);  // remove error message
+        return false;
+    }
+    compile_us = header.compile_us;
+    return true;
+}
+
+void lua_scripts::save_to_cache(lua_State *L, const char *cache_name, const bytecode_cache_header &header)
+{
+    AP::FS().mkdir(SCRIPTING_CACHE_DIRECTORY);
+    int fd = AP::FS().open(cache_name, O_WRONLY|O_CREAT|O_TRUNC);
+    if (fd == -1) {
+        return;
+    }
+    const bool ok = (AP::FS().write(fd, &header, sizeof(header)) == sizeof(header)) &&
+                    (lua_dump(L, bytecode_cache_write, &fd, header.strip) == 0);
+    AP::FS().close(fd);
+    if (!ok) {
+        // don't leave a partial chunk behind
+        AP::FS().unlink(cache_name);
+    }
+}
+#endif // AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+
+int lua_scripts::load_file(lua_State *L, const char *filename, uint32_t *cache_saved_us)
+{
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    uint32_t source_crc;
+    if (!bytecode_cache_enabled || !AP::FS().crc32(filename, source_crc)) {
+        return luaL_loadfile(L, filename);
+    }
+
+    // one cache entry per script, named from its path, which is replaced when the source changes
+    char cache_name[sizeof(SCRIPTING_CACHE_DIRECTORY) + 12];
+    snprintf(cache_name, sizeof(cache_name), SCRIPTING_CACHE_DIRECTORY "/%08X.lc",
+             (unsigned)crc_crc32(0, (const uint8_t *)filename, strlen(filename)));
+
+    const bytecode_cache_header expected {
+        magic : BYTECODE_CACHE_MAGIC,
+        lua_version : LUA_VERSION_NUM,
+        lua_number_size : sizeof(lua_Number),
+        strip : uint8_t(bytecode_cache_strip ? 1 : 0),
+        source_crc : source_crc,
+        compile_us : 0,
+    };
+
+    const uint32_t start_us = AP_HAL::micros();
+    uint32_t compile_us;
+    if (load_from_cache(L, filename, cache_name, expected, compile_us)) {
+        const uint32_t load_us = AP_HAL::micros() - start_us;
+        if (cache_saved_us != nullptr && compile_us > load_us) {
+            *cache_saved_us = compile_us - load_us;
+        }
+        return LUA_OK;
+    }
+
+    const int status = luaL_loadfile(L, filename);
+    if (status == LUA_OK) {
+        bytecode_cache_header header = expected;
+        header.compile_us = AP_HAL::micros() - start_us;
+        save_to_cache(L, cache_name, header);
+    }
+    return status;
+#else
+    return luaL_loadfile(L, filename);
+#endif // AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+}
+
+int lua_scripts_loadfile(lua_State *L, const char *filename)
+{
+    return lua_scripts::load_file(L, filename);
+}
+
 lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename) {
     // try RETRY_LOAD_SCRIPT times to load script to avoid error when loading scripts from ROMFS
     int error;
     uint8_t error_count = 0;
+    uint32_t cache_saved_us = 0;
     while (true) {
         error_count++;
-        error = luaL_loadfile(L, filename);
+        error = load_file(L, filename, &cache_saved_us);
         if (!error || error_count == RETRY_LOAD_SCRIPT) {
             break;
         }
@@ -215,11 +364,15 @@ lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename)
     const uint32_t loadEnd = AP_HAL::micros();
     const int endMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
 
-    update_stats(filename, loadEnd-loadStart, endMem, loadMem);
+    update_stats(filename, loadEnd-loadStart, endMem, loadMem, cache_saved_us);
 
     new_script->name = filename;
     new_script->lua_ref = luaL_ref(L, LUA_REGISTRYINDEX);   // cache the reference
     new_script->next_run_ms = AP_HAL::millis64() - 1; // force the script to be stale
+    new_script->wake_events = 0;
+    new_script->cpu_us = 0;
+    new_script->run_count = 0;
+    new_script->event_wakes = 0;
 
     // Get checksum of file
     uint32_t crc = 0;
@@ -347,7 +500,15 @@ void lua_scripts::run_next_script(lua_State *L) {
     lua_rawgeti(L, LUA_REGISTRYINDEX, script->lua_ref);
     AP::scripting()->set_current_ref(script->lua_ref);
 
-    if(lua_pcall(L, 0, LUA_MULTRET, 0)) {
+    // the script must ask for events each run
+    AP::scripting()->wake_on(0);
+
+    const uint32_t start_us = AP_HAL::micros();
+    const int status = lua_pcall(L, 0, LUA_MULTRET, 0);
+    script->cpu_us += AP_HAL::micros() - start_us;
+    script->run_count++;
+
+    if (status) {
         if (overtime) {
             // script has consumed an excessive amount of CPU time
             set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "%s exceeded time limit", script->name);
@@ -382,6 +543,7 @@ void lua_scripts::run_next_script(lua_State *L) {
 
                     // types match the expectations, go ahead and reschedule
                     script->next_run_ms = start_time_ms + (uint64_t)luaL_checknumber(L, -1);
+                    script->wake_events = AP::scripting()->get_wake_on_events();
                     lua_pop(L, 1);
                     int old_ref = script->lua_ref;
                     script->lua_ref = luaL_ref(L, LUA_REGISTRYINDEX);
@@ -434,6 +596,54 @@ void lua_scripts::remove_script(lua_State *L, script_info *script) {
     _heap.deallocate(script);
 }
 
+void lua_scripts::wait_for_next_script(void) {
+    AP_Scripting *scripting = AP::scripting();
+    while (scripts != nullptr) {
+        uint32_t waiting = 0;
+        for (const script_info *script = scripts; script != nullptr; script = script->next) {
+            waiting |= script->wake_events;
+        }
+
+        const uint64_t now_ms = AP_HAL::millis64();
+        if (now_ms >= scripts->next_run_ms) {
+            return;
+        }
+        // wake at least once a second so long delays can't overflow the wait
+        uint32_t wait_ms = MIN(scripts->next_run_ms - now_ms, 1000U);
+        if ((waiting & AP_Scripting::EVENT_MODE_CHANGE) != 0) {
+            // mode changes are found by polling
+            wait_ms = MIN(wait_ms, SCRIPTING_MODE_CHANGE_POLL_MS);
+        }
+
+        const uint32_t events = scripting->wait_for_events(waiting, wait_ms);
+        if (events != 0) {
+            wake_scripts(events);
+        }
+    }
+}
+
+void lua_scripts::wake_scripts(uint32_t events) {
+    const uint64_t now_ms = AP_HAL::millis64();
+    script_info *woken = nullptr;
+    for (script_info **s = &scripts; *s != nullptr; ) {
+        script_info *script = *s;
+        if ((script->wake_events & events) != 0 && script->next_run_ms > now_ms) {
+            *s = script->next;
+            script->next_run_ms = now_ms;
+            script->event_wakes++;
+            script->next = woken;
+            woken = script;
+        } else {
+            s = &script->next;
+        }
+    }
+    while (woken != nullptr) {
+        script_info *next = woken->next;
+        reschedule_script(woken);
+        woken = next;
+    }
+}
+
 void lua_scripts::reschedule_script(script_info *script) {
     if (script == nullptr) {
 #if defined(AP_SCRIPTING_CHECKS) && AP_SCRIPTING_CHECKS >= 1
@@ -470,10 +680,14 @@ void lua_scripts::reschedule_script(script_info *script) {
 }
 
 MultiHeap lua_scripts::_heap;
+lua_alloc_pool lua_scripts::_pool;
 
 void *lua_scripts::alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
     (void)ud; /* not used */
-    return _heap.change_size(ptr, osize, nsize);
+    if (!_pool.enabled()) {
+        return _heap.change_size(ptr, osize, nsize);
+    }
+    return _pool.change_size(ptr, osize, nsize);
 }
 
 void lua_scripts::repl_cleanup (void) {
@@ -529,6 +743,11 @@ void lua_scripts::run(void) {
     lua_atpanic(L, atpanic);
     load_generated_bindings(L);
 
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    bytecode_cache_enabled = (_debug_options.get() & uint8_t(DebugLevel::DISABLE_BYTECODE_CACHE)) == 0;
+    bytecode_cache_strip = (_debug_options.get() & uint8_t(DebugLevel::STRIP_BYTECODE_CACHE)) != 0;
+#endif
+
 #ifndef HAL_CONSOLE_DISABLED
     const int loaded_mem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
     DEV_PRINTF("Lua: State memory usage: %i + %i\n", inital_mem, loaded_mem - inital_mem);
@@ -579,14 +798,15 @@ void lua_scripts::run(void) {
               }
 #endif // defined(AP_SCRIPTING_CHECKS) && AP_SCRIPTING_CHECKS >= 1
 
-            // compute delay time
-            uint64_t now_ms = AP_HAL::millis64();
-            if (now_ms < scripts->next_run_ms) {
-                hal.scheduler->delay(scripts->next_run_ms - now_ms);
-            }
+            // wait for the next script to be due, or for an event it is waiting for
+            wait_for_next_script();
 
             if ((_debug_options.get() & uint8_t(DebugLevel::RUNTIME_MSG)) != 0) {
-                GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Running %s", scripts->name);
+                GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Running %s, %u us in %u runs, %u event wakes",
+                              scripts->name,
+                              (unsigned int)scripts->cpu_us,
+                              (unsigned int)scripts->run_count,
+                              (unsigned int)scripts->event_wakes);
             }
             // take a copy of the script name for the purposes of
             // logging statistics.  "scripts" may become invalid
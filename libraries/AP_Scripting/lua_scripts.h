@@ -28,13 +28,14 @@
 #include <AP_HAL/Semaphores.h>
 #include <AP_Common/MultiHeap.h>
 #include "lua_common_defs.h"
+#include "lua_alloc_pool.h"
 
 #include "lua/src/lua.hpp"
 
 class lua_scripts
 {
 public:
-    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, const AP_Int8 &debug_options, struct AP_Scripting::terminal_s &_terminal);
+    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, const AP_Int8 &alloc_pool_pct, const AP_Int8 &debug_options, struct AP_Scripting::terminal_s &_terminal);
 
     ~lua_scripts();
 
@@ -55,8 +56,14 @@ public:
         LOG_RUNTIME = 1U << 3,
         DISABLE_PRE_ARM = 1U << 4,
         SAVE_CHECKSUM = 1U << 5,
+        DISABLE_BYTECODE_CACHE = 1U << 6,
+        STRIP_BYTECODE_CACHE = 1U << 7,
     };
 
+    // load a script or module, from the bytecode cache if possible.
+    // cache_saved_us is set to the compile time saved by the cache
+    static int load_file(lua_State *L, const char *filename, uint32_t *cache_saved_us = nullptr);
+
 private:
 
     void create_sandbox(lua_State *L);
@@ -67,6 +74,10 @@ private:
        uint64_t next_run_ms; // time (in milliseconds) the script should next be run at
        uint32_t crc;         // crc32 checksum
        char *name;           // filename for the script // FIXME: This information should be available from Lua
+       uint32_t wake_events; // events which run the script before next_run_ms, see AP_Scripting::wake_on
+       uint32_t cpu_us;      // total time spent running the script
+       uint32_t run_count;   // number of times the script has been run
+       uint32_t event_wakes; // number of times the script has been run early by an event
        script_info *next;
     } script_info;
 
@@ -83,6 +94,12 @@ private:
     // reschedule the script for execution. It is assumed the script is not in the list already
     void reschedule_script(script_info *script);
 
+    // wait until the first script is due to run, running scripts early when an event they are waiting for happens
+    void wait_for_next_script(void);
+
+    // bring forward the scripts waiting for any of events
+    void wake_scripts(uint32_t events);
+
     // REPL stuff
     struct AP_Scripting::terminal_s &terminal;
     void doREPL(lua_State *L);
@@ -116,8 +133,32 @@ private:
 
     static MultiHeap _heap;
 
+    // pools of small blocks in front of _heap for Lua allocations
+    static lua_alloc_pool _pool;
+
     // helper for print and log of runtime stats
-    void update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem);
+    void update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem, uint32_t cache_saved_us = 0);
+
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    // header of each file in the bytecode cache, the lua chunk follows
+    struct PACKED bytecode_cache_header {
+        uint32_t magic;
+        uint16_t lua_version;   // LUA_VERSION_NUM of the VM which compiled the chunk
+        uint8_t lua_number_size;
+        uint8_t strip;          // 1 if debug information was stripped
+        uint32_t source_crc;    // crc32 of the source file
+        uint32_t compile_us;    // time taken to compile the source
+    };
+
+    // load a compiled chunk from the cache, returns false if there is no valid entry for the source
+    static bool load_from_cache(lua_State *L, const char *filename, const char *cache_name, const bytecode_cache_header &expected, uint32_t &compile_us);
+
+    // save the function on the top of the stack to the cache
+    static void save_to_cache(lua_State *L, const char *cache_name, const bytecode_cache_header &header);
+
+    static bool bytecode_cache_enabled;
+    static bool bytecode_cache_strip;
+#endif
 
     // must be static for use in atpanic
     static void print_error(MAV_SEVERITY severity);
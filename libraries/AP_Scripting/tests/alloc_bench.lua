@@ -0,0 +1,46 @@
+-- benchmark of the allocation of short lived userdata and strings, used with autotest
+-- each run creates the temporary Vector3f, Location and uint32_t objects and short strings
+-- a typical navigation script would, and the time taken by each run is reported at the end
+-- run with SCR_DEBUG_OPTS bit 1 set to also see the pool usage after each run
+
+local NUM_RUNS = 50
+local OBJECTS_PER_RUN = 500
+
+local run_count = 0
+local total_us = 0
+local max_us = 0
+
+local function run()
+  local origin = Location()
+  local sum = Vector3f()
+  local names = {}
+  for i = 1, OBJECTS_PER_RUN do
+    local loc = origin:copy()
+    loc:offset(i, -i)
+    local ofs = origin:get_distance_NED(loc)
+    sum = sum + ofs:scale(0.5)
+    local count = uint32_t(i) + 1
+    names[(i % 16) + 1] = string.format("wp%d", count:toint())
+  end
+  return sum:length(), #names
+end
+
+function update()
+  local start_us = micros()
+  run()
+  local run_us = (micros() - start_us):toint()
+
+  run_count = run_count + 1
+  total_us = total_us + run_us
+  max_us = math.max(max_us, run_us)
+
+  if run_count >= NUM_RUNS then
+    gcs:send_text(6, string.format("Alloc bench: %d runs of %d objects, mean %.0fus max %dus",
+                                   NUM_RUNS, OBJECTS_PER_RUN, total_us / NUM_RUNS, max_us))
+    gcs:send_text(6, "Alloc bench done")
+    return
+  end
+  return update, 10
+end
+
+return update()
@@ -0,0 +1,73 @@
+-- benchmark of the cost of calling bindings, used with autotest
+-- times a loop of separate attitude, location and velocity calls against the
+-- same values fetched with one ahrs:get_state() call, and a loop of simple
+-- calls on a userdata, and reports the calls per second of each at the end
+
+local NUM_RUNS = 20
+local CALLS_PER_RUN = 1000
+
+local run_count = 0
+local separate_us = 0
+local batched_us = 0
+local userdata_us = 0
+
+local function elapsed_us(start_us)
+  return (micros() - start_us):toint()
+end
+
+local function run()
+  local valid = 0
+  local start_us = micros()
+  for _ = 1, CALLS_PER_RUN do
+    local roll = ahrs:get_roll()
+    local pitch = ahrs:get_pitch()
+    local yaw = ahrs:get_yaw()
+    local loc = ahrs:get_location()
+    local vel = ahrs:get_velocity_NED()
+    assert(roll and pitch and yaw)
+    if loc and vel then
+      valid = valid + 1
+    end
+  end
+  separate_us = separate_us + elapsed_us(start_us)
+
+  start_us = micros()
+  for _ = 1, CALLS_PER_RUN do
+    local roll, pitch, yaw, loc, vel = ahrs:get_state()
+    assert(roll and pitch and yaw)
+    if loc and vel then
+      valid = valid + 1
+    end
+  end
+  batched_us = batched_us + elapsed_us(start_us)
+
+  local v = Vector3f()
+  start_us = micros()
+  for i = 1, CALLS_PER_RUN do
+    v:x(i)
+    v:y(v:x())
+  end
+  userdata_us = userdata_us + elapsed_us(start_us)
+  return valid
+end
+
+-- calls per second given the total time of all runs
+local function rate(calls_per_run, total_us)
+  return (NUM_RUNS * calls_per_run * 1.0E6) / math.max(total_us, 1)
+end
+
+function update()
+  run()
+  run_count = run_count + 1
+
+  if run_count >= NUM_RUNS then
+    gcs:send_text(6, string.format("Binding bench: separate %.0f calls/s, get_state %.0f calls/s",
+                                   rate(CALLS_PER_RUN * 5, separate_us), rate(CALLS_PER_RUN, batched_us)))
+    gcs:send_text(6, string.format("Binding bench: Vector3f %.0f calls/s", rate(CALLS_PER_RUN * 3, userdata_us)))
+    gcs:send_text(6, "Binding bench done")
+    return
+  end
+  return update, 10
+end
+
+return update()
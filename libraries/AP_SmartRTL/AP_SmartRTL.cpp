@@ -30,8 +30,8 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 
     // @Param: POINTS
     // @DisplayName: SmartRTL maximum number of points on path
-    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.
-    // @Range: 0 500
+    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.  The maximum depends on the board: 500 points on most autopilots, and 3000 points on Linux boards and SITL. Larger values are reduced to the board's maximum on boot.
+    // @Range: 0 3000
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("POINTS", 1, AP_SmartRTL, _points_max, SMARTRTL_POINTS_DEFAULT),
@@ -125,6 +125,29 @@ void AP_SmartRTL::init()
         return;
     }
 
+#if SMARTRTL_PRUNING_HASH_ENABLED
+    // allocate spatial hash for loop detection.  If this fails loops are found by checking every segment
+    uint16_t num_buckets = 1;
+    while (num_buckets < _points_max) {
+        num_buckets <<= 1;
+    }
+    _prune.hash_buckets = (uint16_t*)calloc(num_buckets, sizeof(uint16_t));
+    _prune.hash_entries_max = _points_max * SMARTRTL_PRUNING_HASH_ENTRIES_PER_POINT;
+    _prune.hash_entries = (prune_hash_entry_t*)calloc(_prune.hash_entries_max, sizeof(prune_hash_entry_t));
+    _prune.hash_long_segments = (uint16_t*)calloc(_points_max, sizeof(uint16_t));
+    if (_prune.hash_buckets == nullptr || _prune.hash_entries == nullptr || _prune.hash_long_segments == nullptr) {
+        free(_prune.hash_buckets);
+        free(_prune.hash_entries);
+        free(_prune.hash_long_segments);
+        _prune.hash_buckets = nullptr;
+        _prune.hash_entries = nullptr;
+        _prune.hash_long_segments = nullptr;
+    } else {
+        _prune.hash_buckets_mask = num_buckets - 1;
+        hash_clear();
+    }
+#endif
+
     _path_points_max = _points_max;
 
     // when running the example sketch, we want the cleanup tasks to run when we tell them to, not in the background (so that they can be timed.)
@@ -367,6 +390,11 @@ void AP_SmartRTL::run_background_cleanup()
     _path_points_completed_limit = SMARTRTL_POINTS_MAX;
     _path_sem.give();
 
+    // points popped from the path may be replaced by new points so their segments must be removed from the spatial hash
+    if (path_points_completed_limit < SMARTRTL_POINTS_MAX) {
+        hash_truncate((path_points_completed_limit > 0) ? path_points_completed_limit - 1 : 0);
+    }
+
     // check if thorough cleanup is required
     if (_thorough_clean_request_ms > 0) {
         // check if we have already completed the request
@@ -573,6 +601,11 @@ void AP_SmartRTL::detect_loops()
         return;
     }
 
+    if (_prune.hash_buckets != nullptr && is_positive(_accuracy)) {
+        detect_loops_hashed();
+        return;
+    }
+
     // capture start time
     const uint32_t start_time_us = AP_HAL::micros();
 
@@ -608,6 +641,210 @@ void AP_SmartRTL::detect_loops()
     }
 }
 
+/**
+*   Finds the same loops as the search of every segment in detect_loops but uses the spatial hash to only compare
+*   segments which are near each other.  Segments are added to the hash as the search needs them and the hash
+*   is kept between runs so only new points on the path need to be added.
+*
+*   _prune.j is zero until segment _prune.i has been checked
+*/
+void AP_SmartRTL::detect_loops_hashed()
+{
+    // capture start time
+    const uint32_t start_time_us = AP_HAL::micros();
+
+    // the segments in the hash were added using the pruning distance at the time, start again if it has changed
+    if (!is_equal(_prune.hash_margin, float(SMARTRTL_PRUNING_DELTA))) {
+        hash_clear();
+    }
+
+    // run for defined amount of time
+    while (AP_HAL::micros() - start_time_us < SMARTRTL_PRUNING_LOOP_TIME_US) {
+
+        // move to the next segment
+        if (_prune.j != 0) {
+            _prune.j = 0;
+            _prune.i--;
+            // complete when outer loop has run out of new points to check
+            if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
+                _prune.complete = true;
+                _prune.path_points_completed = _prune.path_points_count;
+                return;
+            }
+        }
+
+        // segment i is compared with segments 1 to i-2
+        if (!hash_add_segments(_prune.i - 2, start_time_us)) {
+            return;
+        }
+
+        uint16_t j;
+        Vector3f midpoint;
+        if (hash_find_loop(_prune.i, j, midpoint)) {
+            // if there is a loop here, add to loop array
+            if (!add_loop(j, _prune.i-1, midpoint)) {
+                // if the buffer is full, stop trying to prune
+                _prune.complete = true;
+                return;
+            }
+        }
+        _prune.j = 1;
+    }
+}
+
+// remove all segments from the spatial hash
+void AP_SmartRTL::hash_clear()
+{
+    if (_prune.hash_buckets == nullptr) {
+        return;
+    }
+    for (uint32_t b = 0; b <= _prune.hash_buckets_mask; b++) {
+        _prune.hash_buckets[b] = SMARTRTL_PRUNING_HASH_NONE;
+    }
+    _prune.hash_entries_count = 0;
+    _prune.hash_long_segments_count = 0;
+    _prune.hash_segments = 0;
+    _prune.hash_cell_size = SMARTRTL_PRUNING_HASH_CELL_SIZE;
+    _prune.hash_margin = SMARTRTL_PRUNING_DELTA;
+}
+
+// remove segments after num_segments from the spatial hash
+void AP_SmartRTL::hash_truncate(uint16_t num_segments)
+{
+    if (_prune.hash_buckets == nullptr || _prune.hash_segments <= num_segments) {
+        return;
+    }
+    if (num_segments == 0) {
+        hash_clear();
+        return;
+    }
+
+    // entries are in segment order so the removed segments are at the end
+    uint16_t count = _prune.hash_entries_count;
+    while (count > 0 && _prune.hash_entries[count-1].segment > num_segments) {
+        count--;
+    }
+    // the most recent entries are at the start of each bucket
+    for (uint32_t b = 0; b <= _prune.hash_buckets_mask; b++) {
+        uint16_t &head = _prune.hash_buckets[b];
+        while (head != SMARTRTL_PRUNING_HASH_NONE && head >= count) {
+            head = _prune.hash_entries[head].next;
+        }
+    }
+    _prune.hash_entries_count = count;
+
+    while (_prune.hash_long_segments_count > 0 && _prune.hash_long_segments[_prune.hash_long_segments_count-1] > num_segments) {
+        _prune.hash_long_segments_count--;
+    }
+    _prune.hash_segments = num_segments;
+}
+
+// add segments up to and including num_segments to the spatial hash, returns false if it ran out of time
+bool AP_SmartRTL::hash_add_segments(uint16_t num_segments, uint32_t start_time_us)
+{
+    while (_prune.hash_segments < num_segments) {
+        if (AP_HAL::micros() - start_time_us > SMARTRTL_PRUNING_LOOP_TIME_US) {
+            return false;
+        }
+        const uint16_t segment = _prune.hash_segments + 1;
+
+        // the segment is added to every cell within the pruning distance so that a search only needs the cells the other segment covers
+        int32_t x0, y0, x1, y1;
+        hash_cell_range(_path[segment-1], _path[segment], _prune.hash_margin, x0, y0, x1, y1);
+        const uint32_t num_cells = uint32_t(x1 - x0 + 1) * uint32_t(y1 - y0 + 1);
+        if ((x1 - x0 >= SMARTRTL_PRUNING_HASH_CELLS_MAX) || (y1 - y0 >= SMARTRTL_PRUNING_HASH_CELLS_MAX) ||
+            (num_cells > SMARTRTL_PRUNING_HASH_CELLS_MAX) ||
+            (_prune.hash_entries_count + num_cells > _prune.hash_entries_max)) {
+            _prune.hash_long_segments[_prune.hash_long_segments_count++] = segment;
+        } else {
+            for (int32_t x = x0; x <= x1; x++) {
+                for (int32_t y = y0; y <= y1; y++) {
+                    uint16_t &head = _prune.hash_buckets[hash_bucket(x, y)];
+                    _prune.hash_entries[_prune.hash_entries_count] = prune_hash_entry_t {segment, head};
+                    head = _prune.hash_entries_count++;
+                }
+            }
+        }
+        _prune.hash_segments = segment;
+    }
+    return true;
+}
+
+// find the first segment from 1 to i-2 which comes within the pruning distance of segment i
+bool AP_SmartRTL::hash_find_loop(uint16_t i, uint16_t &j, Vector3f &midpoint) const
+{
+    const Vector3f &p1 = _path[i];
+    const Vector3f &p2 = _path[i-1];
+    const uint16_t last_segment = i - 2;
+    uint16_t found = SMARTRTL_PRUNING_HASH_NONE;
+
+    int32_t x0, y0, x1, y1;
+    hash_cell_range(p1, p2, 0.0f, x0, y0, x1, y1);
+    if ((x1 - x0 >= SMARTRTL_PRUNING_HASH_CELLS_MAX) || (y1 - y0 >= SMARTRTL_PRUNING_HASH_CELLS_MAX) ||
+        (uint32_t(x1 - x0 + 1) * uint32_t(y1 - y0 + 1) > SMARTRTL_PRUNING_HASH_CELLS_MAX)) {
+        // segment covers too many cells, check every segment
+        for (uint16_t seg = 1; seg <= last_segment; seg++) {
+            const dist_point dp = segment_segment_dist(p1, p2, _path[seg-1], _path[seg]);
+            if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+                j = seg;
+                midpoint = dp.midpoint;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // check the segments in the cells covered by this segment plus the long segments, keeping the lowest numbered match
+    for (int32_t x = x0; x <= x1; x++) {
+        for (int32_t y = y0; y <= y1; y++) {
+            for (uint16_t e = _prune.hash_buckets[hash_bucket(x, y)]; e != SMARTRTL_PRUNING_HASH_NONE; e = _prune.hash_entries[e].next) {
+                const uint16_t seg = _prune.hash_entries[e].segment;
+                if (seg > last_segment || seg >= found) {
+                    continue;
+                }
+                const dist_point dp = segment_segment_dist(p1, p2, _path[seg-1], _path[seg]);
+                if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+                    found = seg;
+                    midpoint = dp.midpoint;
+                }
+            }
+        }
+    }
+    for (uint16_t k = 0; k < _prune.hash_long_segments_count; k++) {
+        const uint16_t seg = _prune.hash_long_segments[k];
+        if (seg > last_segment || seg >= found) {
+            continue;
+        }
+        const dist_point dp = segment_segment_dist(p1, p2, _path[seg-1], _path[seg]);
+        if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+            found = seg;
+            midpoint = dp.midpoint;
+        }
+    }
+
+    if (found == SMARTRTL_PRUNING_HASH_NONE) {
+        return false;
+    }
+    j = found;
+    return true;
+}
+
+// range of spatial hash cells (horizontally) covered by a line segment, expanded by margin
+void AP_SmartRTL::hash_cell_range(const Vector3f &p1, const Vector3f &p2, float margin, int32_t &x0, int32_t &y0, int32_t &x1, int32_t &y1) const
+{
+    const float cell_size = _prune.hash_cell_size;
+    x0 = floorf((MIN(p1.x, p2.x) - margin) / cell_size);
+    y0 = floorf((MIN(p1.y, p2.y) - margin) / cell_size);
+    x1 = floorf((MAX(p1.x, p2.x) + margin) / cell_size);
+    y1 = floorf((MAX(p1.y, p2.y) + margin) / cell_size);
+}
+
+// spatial hash bucket holding a cell
+uint16_t AP_SmartRTL::hash_bucket(int32_t x, int32_t y) const
+{
+    return ((uint32_t(x) * 73856093U) ^ (uint32_t(y) * 19349663U)) & _prune.hash_buckets_mask;
+}
+
 // restart simplify if new points have been added to path
 // path_points_count is _path_points_count but passed in to avoid having to take the semaphore
 void AP_SmartRTL::restart_simplify_if_new_points(uint16_t path_points_count)
@@ -659,6 +896,7 @@ void AP_SmartRTL::reset_pruning()
     restart_pruning(0);
     _prune.loops_count = 0; // clear the loops that we've recorded
     _prune.path_points_completed = 0;
+    hash_truncate(0);
 }
 
 // remove all simplify-able points from the path
@@ -673,6 +911,10 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
     for (uint16_t src = 1; src < _path_points_count; src++) {
         if (!_simplify.bitmask.get(src)) {
             log_action(SRTL_POINT_SIMPLIFY, _path[src]);
+            if (removed == 0) {
+                // segments from this point onwards change
+                hash_truncate(src - 1);
+            }
             removed++;
         } else {
             _path[dest] = _path[src];
@@ -720,6 +962,7 @@ bool AP_SmartRTL::remove_points_by_loops(uint16_t num_points_to_remove)
 
         // midpoint goes into start_index (this is the end point of the first segment)
         _path[loop.start_index] = loop.midpoint;
+        hash_truncate(loop.start_index - 1);
 
         // shift points after the end of the loop down by the number of points in the loop
         uint16_t loop_num_points_to_remove = loop.end_index - loop.start_index;
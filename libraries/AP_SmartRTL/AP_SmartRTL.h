@@ -8,7 +8,13 @@
 // definitions and macros
 #define SMARTRTL_ACCURACY_DEFAULT        2.0f   // default _ACCURACY parameter value.  Points will be no closer than this distance (in meters) together.
 #define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 20bytes * this number.
+#ifndef SMARTRTL_POINTS_MAX
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define SMARTRTL_POINTS_MAX              3000   // the absolute maximum number of points this library can support.
+#else
 #define SMARTRTL_POINTS_MAX              500    // the absolute maximum number of points this library can support.
+#endif
+#endif
 #define SMARTRTL_TIMEOUT                 15000  // the time in milliseconds with no points saved to the path (for whatever reason), before SmartRTL is disabled for the flight
 #define SMARTRTL_CLEANUP_POINT_TRIGGER   50     // simplification will trigger when this many points are added to the path
 #define SMARTRTL_CLEANUP_START_MARGIN    10     // routine cleanup algorithms begin when the path array has only this many empty slots remaining
@@ -21,6 +27,13 @@
 #define SMARTRTL_PRUNING_DELTA (_accuracy * 0.99)   // How many meters apart must two points be, such that we can assume that there is no obstacle between them.  must be smaller than _ACCURACY parameter
 #define SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT 0.25f // pruning loop buffer size as compared to maximum number of points
 #define SMARTRTL_PRUNING_LOOP_TIME_US    200    // maximum time (in microseconds) that the loop finding algorithm will run before returning
+#ifndef SMARTRTL_PRUNING_HASH_ENABLED
+#define SMARTRTL_PRUNING_HASH_ENABLED    (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)  // use a spatial hash to find segments which may form a loop
+#endif
+#define SMARTRTL_PRUNING_HASH_CELL_SIZE  (_accuracy * 8.0f)   // width (in meters) of the spatial hash cells
+#define SMARTRTL_PRUNING_HASH_CELLS_MAX  9      // segments covering more cells than this are held in the long segment list
+#define SMARTRTL_PRUNING_HASH_ENTRIES_PER_POINT 3   // spatial hash entries allocated per path point
+#define SMARTRTL_PRUNING_HASH_NONE       UINT16_MAX // marks the end of a spatial hash bucket
 
 class AP_SmartRTL {
 
@@ -124,6 +137,23 @@ private:
     void detect_simplifications();
     void detect_loops();
 
+    // loop detection using the spatial hash, called by detect_loops
+    void detect_loops_hashed();
+
+    // spatial hash of path segments used to find the segments which may come within the pruning distance of each other.
+    // segment j joins path point j-1 to point j
+    void hash_clear();
+    // remove segments after num_segments from the hash, used when points on the path are moved or removed
+    void hash_truncate(uint16_t num_segments);
+    // add segments up to and including num_segments to the hash, returns false if it ran out of time
+    bool hash_add_segments(uint16_t num_segments, uint32_t start_time_us);
+    // find the first segment (lowest index) from 1 to i-2 which comes within the pruning distance of segment i
+    // returns true if found with the segment in j and the point midway between the segments in midpoint
+    bool hash_find_loop(uint16_t i, uint16_t &j, Vector3f &midpoint) const;
+    // range of hash cells covered by a line segment, expanded by margin
+    void hash_cell_range(const Vector3f &p1, const Vector3f &p2, float margin, int32_t &x0, int32_t &y0, int32_t &x1, int32_t &y1) const;
+    uint16_t hash_bucket(int32_t x, int32_t y) const;
+
     // restart simplify or pruning if new points have been added to path
     // path_points_count is _path_points_count but passed in to avoid having to take the semaphore
     void restart_simplify_if_new_points(uint16_t path_points_count);
@@ -227,6 +257,10 @@ private:
         Vector3f midpoint;      // midpoint which should replace the first point when the loop is removed
         float length_squared;   // length squared (in meters) of the loop (used so we can remove the longest loops)
     } prune_loop_t;
+    typedef struct {
+        uint16_t segment;       // segment number (the index of the segment's end point)
+        uint16_t next;          // next entry in the same bucket
+    } prune_hash_entry_t;
     struct {
         bool complete;
         uint16_t path_points_count;  // copy of _path_points_count taken when the prune algorithm started
@@ -236,6 +270,16 @@ private:
         prune_loop_t* loops;// the result of the pruning algorithm
         uint16_t loops_max; // maximum number of elements in the _prunable_loops array
         uint16_t loops_count;   // number of elements in the _prunable_loops array
+        uint16_t* hash_buckets;     // most recently added entry in each spatial hash bucket, buckets hold the segments overlapping a cell
+        uint16_t hash_buckets_mask; // number of buckets minus one (the number of buckets is a power of two)
+        prune_hash_entry_t* hash_entries;   // spatial hash entries, in order of segment number
+        uint16_t hash_entries_max;  // maximum number of elements in the hash_entries array
+        uint16_t hash_entries_count;// number of elements in the hash_entries array
+        uint16_t* hash_long_segments;   // segments which cover too many cells to be added to the buckets, these are checked by every search
+        uint16_t hash_long_segments_count;  // number of elements in the hash_long_segments array
+        uint16_t hash_segments;     // segments 1 to hash_segments have been added to the spatial hash
+        float hash_cell_size;       // cell size (in meters) used for the segments in the spatial hash
+        float hash_margin;          // pruning distance (in meters) used for the segments in the spatial hash
     } _prune;
 
     // returns true if the two loops overlap (used within add_loop to determine which loops to keep or throw away)
@@ -0,0 +1,83 @@
+/*
+  Benchmark of SmartRTL path cleanup with long paths
+
+  Records paths of increasing length which wander back over themselves, as
+  a vehicle surveying an area would, then times a thorough cleanup
+  (simplification and loop pruning) of each path.
+
+  on SITL run with
+    ./waf configure --board sitl
+    ./waf build --targets examples/SmartRTL_bench
+    ./build/sitl/examples/SmartRTL_bench
+*/
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_SmartRTL/AP_SmartRTL.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static AP_SmartRTL smart_rtl{true};
+
+#define STEP_M          3.0f    // distance between recorded positions, larger than the default accuracy
+#define AREA_SIZE_M     300.0f  // the vehicle turns back when it reaches the edge of this area
+
+static const uint16_t path_lengths[] { 250, 500, 1000, 2000, SMARTRTL_POINTS_MAX };
+
+// record a path of num_points positions wandering around the area
+static void record_path(uint16_t num_points)
+{
+    smart_rtl.set_home(true, Vector3f{0.0f, 0.0f, 0.0f});
+    Vector3f pos;
+    float heading = 0.0f;
+    for (uint16_t i=0; i<num_points; i++) {
+        heading += radians(rand_float() * 20.0f);
+        if (fabsf(pos.x) > AREA_SIZE_M * 0.5f || fabsf(pos.y) > AREA_SIZE_M * 0.5f) {
+            // head back towards home
+            heading = atan2f(-pos.y, -pos.x) + radians(rand_float() * 45.0f);
+        }
+        pos += Vector3f(cosf(heading), sinf(heading), rand_float() * 0.1f) * STEP_M;
+        smart_rtl.update(true, pos);
+    }
+}
+
+void setup()
+{
+    AP_Param::set_object_value(&smart_rtl, AP_SmartRTL::var_info, "POINTS", SMARTRTL_POINTS_MAX);
+    smart_rtl.init();
+
+    for (const uint16_t num_points : path_lengths) {
+        // request_thorough_cleanup uses millisecond timestamps
+        hal.scheduler->delay(5);
+        record_path(num_points);
+        if (!smart_rtl.is_active()) {
+            ::printf("SmartRTL deactivated\n");
+            exit(1);
+        }
+        const uint16_t recorded = smart_rtl.get_num_points();
+
+        const uint64_t start_us = AP_HAL::micros64();
+        while (!smart_rtl.request_thorough_cleanup(AP_SmartRTL::THOROUGH_CLEAN_ALL)) {
+            smart_rtl.run_background_cleanup();
+        }
+        ::printf("%u points cleaned to %u in %.1fms\n",
+                 (unsigned)recorded, (unsigned)smart_rtl.get_num_points(), (AP_HAL::micros64() - start_us) * 0.001f);
+    }
+
+    exit(0);
+}
+
+void loop()
+{
+}
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+AP_HAL_MAIN();
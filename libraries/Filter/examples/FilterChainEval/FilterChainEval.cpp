@@ -0,0 +1,374 @@
+// Offline evaluation of the gyro filter chain on logged gyro data
+//
+// Runs the real HarmonicNotchFilter and LowPassFilter2p code, plus the DSP engine and harmonic
+// selection used by AP_GyroFFT for FFT-tracked notches, over a CSV of gyro samples and reports the
+// noise attenuation and the phase lag at typical control loop frequencies for one candidate set of
+// filter parameters. Tools/FilterTestTool/filter_sweep.py extracts the samples from a log and runs
+// sweeps of candidate parameters through this in parallel.
+
+/* run with
+    ./waf configure --board sitl
+    ./waf build --targets examples/FilterChainEval
+    ./build/sitl/examples/FilterChainEval gyro.csv 2000 INS_HNTCH_FREQ=80 INS_HNTCH_BW=40 INS_GYRO_FILTER=40
+
+  the CSV has a header line followed by lines of "segment,x,y,z" with gyro rates in rad/s, the filters
+  are reset at the start of each segment so that discontinuous batch sampler data can be used
+*/
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/HarmonicNotchFilter.h>
+#include <AP_GyroFFT/AP_GyroFFT.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// frequencies at which to report gain and phase lag, typical of attitude control bandwidths
+static const float control_freqs_hz[] { 5, 10, 20, 40 };
+// content below this frequency is considered vehicle motion rather than noise
+static const float MOTION_CUTOFF_HZ = 20.0f;
+// time to discard after a filter reset before collecting statistics
+static const float SETTLE_TIME_S = 0.25f;
+
+// candidate filter parameters, named after the vehicle parameters they mirror
+enum ParamIndex : uint8_t {
+    GYRO_FILTER,
+    HNTCH_MODE,
+    HNTCH_FREQ,
+    HNTCH_BW,
+    HNTCH_ATT,
+    HNTCH_HMNCS,
+    HNTCH_OPTS,
+    FFT_MINHZ,
+    FFT_MAXHZ,
+    FFT_WINDOW_SIZE,
+    FFT_HMNC_FIT,
+    NUM_PARAMS
+};
+
+static struct {
+    const char *name;
+    float value;
+} params[NUM_PARAMS] {
+    { "INS_GYRO_FILTER", 20 },
+    { "INS_HNTCH_MODE", 0 },
+    { "INS_HNTCH_FREQ", 80 },
+    { "INS_HNTCH_BW", 40 },
+    { "INS_HNTCH_ATT", 40 },
+    { "INS_HNTCH_HMNCS", 3 },
+    { "INS_HNTCH_OPTS", 0 },
+    { "FFT_MINHZ", 50 },
+    { "FFT_MAXHZ", 450 },
+    { "FFT_WINDOW_SIZE", 64 },
+    { "FFT_HMNC_FIT", 10 },
+};
+
+static float param(ParamIndex idx)
+{
+    return params[idx].value;
+}
+
+// parse NAME=VALUE, returning false if the name is not known
+static bool parse_param(const char *arg)
+{
+    const char *eq = strchr(arg, '=');
+    if (eq == nullptr) {
+        return false;
+    }
+    for (auto &p : params) {
+        if (strlen(p.name) == size_t(eq - arg) && strncmp(p.name, arg, eq - arg) == 0) {
+            p.value = strtof(eq + 1, nullptr);
+            return true;
+        }
+    }
+    return false;
+}
+
+struct GyroSample {
+    uint16_t segment;
+    Vector3f gyro;
+};
+
+static GyroSample *samples;
+static uint32_t num_samples;
+
+// load gyro samples from a CSV file
+static bool load_samples(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+        ::printf("Unable to open %s\n", path);
+        return false;
+    }
+    char line[128];
+    // skip the header
+    if (fgets(line, sizeof(line), f) == nullptr) {
+        fclose(f);
+        return false;
+    }
+    uint32_t allocated = 0;
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        unsigned segment;
+        float x, y, z;
+        if (sscanf(line, "%u,%f,%f,%f", &segment, &x, &y, &z) != 4) {
+            continue;
+        }
+        if (num_samples == allocated) {
+            allocated = MAX(allocated * 2, 4096U);
+            GyroSample *new_samples = (GyroSample *)realloc(samples, allocated * sizeof(GyroSample));
+            if (new_samples == nullptr) {
+                fclose(f);
+                return false;
+            }
+            samples = new_samples;
+        }
+        samples[num_samples++] = GyroSample { uint16_t(segment), Vector3f(x, y, z) };
+    }
+    fclose(f);
+    return num_samples > 0;
+}
+
+// the gyro filter chain as applied by AP_InertialSensor_Backend::apply_gyro_filters()
+class FilterChain {
+public:
+    FilterChain(float sample_rate_hz, float notch_freq_hz) {
+        const uint16_t opts = param(HNTCH_OPTS);
+        uint8_t composite_notches = 1;
+        if (opts & uint16_t(HarmonicNotchFilterParams::Options::DoubleNotch)) {
+            composite_notches = 2;
+        } else if (opts & uint16_t(HarmonicNotchFilterParams::Options::TripleNotch)) {
+            composite_notches = 3;
+        }
+        const uint32_t harmonics = param(HNTCH_HMNCS);
+        if (harmonics != 0) {
+            notch.allocate_filters(1, harmonics, composite_notches);
+            notch.init(sample_rate_hz, notch_freq_hz, param(HNTCH_BW), param(HNTCH_ATT));
+        }
+        lowpass.set_cutoff_frequency(sample_rate_hz, param(GYRO_FILTER));
+    }
+
+    Vector3f apply(const Vector3f &sample) {
+        return lowpass.apply(notch.apply(sample));
+    }
+
+    void update(float notch_freq_hz) {
+        notch.update(notch_freq_hz);
+    }
+
+    void reset() {
+        notch.reset();
+        lowpass.reset();
+    }
+
+private:
+    HarmonicNotchFilterVector3f notch;
+    LowPassFilter2pVector3f lowpass;
+};
+
+#if HAL_WITH_DSP && HAL_GYROFFT_ENABLED
+// simplified version of the AP_GyroFFT analysis on roll and pitch
+class FFTTracker {
+public:
+    bool init(float sample_rate_hz) {
+        const uint16_t window_size = 1 << lrintf(log2f(param(FFT_WINDOW_SIZE)));
+        state = hal.dsp->fft_init(window_size, sample_rate_hz);
+        if (state == nullptr) {
+            return false;
+        }
+        samples_per_frame = window_size / 2;
+        start_bin = MAX(floorf(param(FFT_MINHZ) / state->_bin_resolution), 1);
+        end_bin = MIN(ceilf(param(FFT_MAXHZ) / state->_bin_resolution), state->_bin_count);
+        return window[0].set_size(window_size + samples_per_frame) && window[1].set_size(window_size + samples_per_frame);
+    }
+
+    // push a new sample, returns true if a new frequency estimate is available
+    bool push(const Vector3f &sample, float &freq_hz) {
+        window[0].push(sample.x);
+        window[1].push(sample.y);
+        if (window[0].available() < state->_window_size) {
+            return false;
+        }
+        float sum = 0.0f;
+        for (uint8_t axis = 0; axis < 2; axis++) {
+            hal.dsp->fft_start(state, window[axis], samples_per_frame);
+            hal.dsp->fft_analyse(state, start_bin, end_bin, 0.03f);
+            float freqs[AP_HAL::DSP::MAX_TRACKED_PEAKS];
+            for (uint8_t i = 0; i < AP_HAL::DSP::MAX_TRACKED_PEAKS; i++) {
+                freqs[i] = state->_peak_data[i]._freq_hz;
+            }
+            uint8_t harmonics;
+            sum += AP_GyroFFT::calculate_notch_frequency(freqs, AP_HAL::DSP::MAX_TRACKED_PEAKS, param(FFT_HMNC_FIT), harmonics);
+        }
+        freq_hz = constrain_float(sum * 0.5f, param(FFT_MINHZ), param(FFT_MAXHZ));
+        return true;
+    }
+
+    void reset() {
+        window[0].clear();
+        window[1].clear();
+    }
+
+private:
+    AP_HAL::DSP::FFTWindowState *state;
+    FloatBuffer window[2];
+    uint16_t samples_per_frame;
+    uint16_t start_bin;
+    uint16_t end_bin;
+};
+#endif
+
+// run the logged samples through the filter chain, returning the attenuation of noise on each axis in dB
+// and the average notch frequency
+static bool evaluate_noise(float sample_rate_hz, Vector3f &attenuation_db, float &mean_notch_hz)
+{
+    const bool fft_tracking = HarmonicNotchDynamicMode(param(HNTCH_MODE)) == HarmonicNotchDynamicMode::UpdateGyroFFT;
+    FilterChain chain { sample_rate_hz, param(HNTCH_FREQ) };
+#if HAL_WITH_DSP && HAL_GYROFFT_ENABLED
+    FFTTracker tracker;
+    if (fft_tracking && !tracker.init(sample_rate_hz)) {
+        ::printf("Unable to initialise the DSP engine, build for SITL to evaluate FFT tracking\n");
+        return false;
+    }
+#else
+    if (fft_tracking) {
+        ::printf("FFT tracking requires DSP support, build for SITL\n");
+        return false;
+    }
+#endif
+
+    // separate vehicle motion from noise on both the input and the output
+    LowPassFilter2pVector3f input_motion { sample_rate_hz, MOTION_CUTOFF_HZ };
+    LowPassFilter2pVector3f output_motion { sample_rate_hz, MOTION_CUTOFF_HZ };
+
+    const uint32_t settle_samples = SETTLE_TIME_S * sample_rate_hz;
+    Vector3f input_energy, output_energy;
+    double notch_sum = 0;
+    uint32_t count = 0;
+    uint32_t since_reset = 0;
+    float notch_hz = param(HNTCH_FREQ);
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        const GyroSample &s = samples[i];
+        if (i == 0 || s.segment != samples[i - 1].segment) {
+            chain.reset();
+            input_motion.reset();
+            output_motion.reset();
+#if HAL_WITH_DSP && HAL_GYROFFT_ENABLED
+            if (fft_tracking) {
+                tracker.reset();
+            }
+#endif
+            since_reset = 0;
+        }
+
+#if HAL_WITH_DSP && HAL_GYROFFT_ENABLED
+        float fft_hz;
+        if (fft_tracking && tracker.push(s.gyro, fft_hz)) {
+            // the configured frequency is the lower limit for FFT notches
+            notch_hz = MAX(fft_hz, param(HNTCH_FREQ));
+            chain.update(notch_hz);
+        }
+#endif
+
+        const Vector3f output = chain.apply(s.gyro);
+        const Vector3f input_noise = s.gyro - input_motion.apply(s.gyro);
+        const Vector3f output_noise = output - output_motion.apply(output);
+
+        if (++since_reset < settle_samples) {
+            continue;
+        }
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            input_energy[axis] += sq(input_noise[axis]);
+            output_energy[axis] += sq(output_noise[axis]);
+        }
+        notch_sum += notch_hz;
+        count++;
+    }
+
+    if (count == 0) {
+        ::printf("Not enough samples\n");
+        return false;
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        attenuation_db[axis] = 10.0f * log10f(MAX(input_energy[axis], FLT_MIN) / MAX(output_energy[axis], FLT_MIN));
+    }
+    mean_notch_hz = notch_sum / count;
+    return true;
+}
+
+// measure the gain and phase of the filter chain for a sine wave at the given frequency
+static void evaluate_response(float sample_rate_hz, float notch_hz, float freq_hz, float &gain_db, float &lag_deg)
+{
+    FilterChain chain { sample_rate_hz, notch_hz };
+
+    // settle for one second and then correlate over one second, an integer number of periods
+    const uint32_t n = sample_rate_hz;
+    double in_phase = 0, quadrature = 0;
+    for (uint32_t i = 0; i < 2 * n; i++) {
+        const float wt = M_2PI * freq_hz * i / sample_rate_hz;
+        const float output = chain.apply(Vector3f(sinf(wt), sinf(wt), sinf(wt))).x;
+        if (i >= n) {
+            in_phase += output * sinf(wt);
+            quadrature += output * cosf(wt);
+        }
+    }
+    gain_db = 20.0f * log10f(MAX(2.0 * safe_sqrt(sq(in_phase) + sq(quadrature)) / n, 1e-6));
+    lag_deg = -degrees(atan2f(quadrature, in_phase));
+}
+
+void setup()
+{
+    uint8_t argc;
+    char * const *argv;
+    hal.util->commandline_arguments(argc, argv);
+
+    if (argc < 3) {
+        ::printf("usage: FilterChainEval samples.csv sample_rate_hz [NAME=VALUE]...\n");
+        exit(1);
+    }
+    const float sample_rate_hz = strtof(argv[2], nullptr);
+    for (uint8_t i = 3; i < argc; i++) {
+        if (!parse_param(argv[i])) {
+            ::printf("Unknown parameter %s\n", argv[i]);
+            exit(1);
+        }
+    }
+    if (!is_positive(sample_rate_hz) || !load_samples(argv[1])) {
+        ::printf("No samples loaded\n");
+        exit(1);
+    }
+
+    Vector3f attenuation_db;
+    float mean_notch_hz;
+    if (!evaluate_noise(sample_rate_hz, attenuation_db, mean_notch_hz)) {
+        exit(1);
+    }
+
+    ::printf("HEADER,AttX,AttY,AttZ,NotchHz");
+    for (const float f : control_freqs_hz) {
+        ::printf(",Gain%.0f,Lag%.0f", f, f);
+    }
+    ::printf("\nRESULT,%.2f,%.2f,%.2f,%.1f", attenuation_db.x, attenuation_db.y, attenuation_db.z, mean_notch_hz);
+    for (const float f : control_freqs_hz) {
+        float gain_db, lag_deg;
+        evaluate_response(sample_rate_hz, mean_notch_hz, f, gain_db, lag_deg);
+        ::printf(",%.2f,%.1f", gain_db, lag_deg);
+    }
+    ::printf("\n");
+
+    free(samples);
+    exit(0);
+}
+
+void loop()
+{
+}
+
+AP_HAL_MAIN();
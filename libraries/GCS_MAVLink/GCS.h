@@ -14,6 +14,7 @@
 #include <AP_Mission/AP_Mission.h>
 #include <stdint.h>
 #include "MAVLink_routing.h"
+#include "GCS_MessageCache.h"
 #include <AP_RTC/JitterCorrection.h>
 #include <AP_Common/Bitmask.h>
 #include <AP_LTM_Telem/AP_LTM_Telem.h>
@@ -444,6 +445,23 @@ public:
       allow forwarding of packets / heartbeats to be blocked as required by some components to reduce traffic
     */
     static void disable_channel_routing(mavlink_channel_t chan) { routing.no_route_mask |= (1U<<(chan-MAVLINK_COMM_0)); }
+
+    /*
+      routing table and counters for @SYS/routing.txt
+     */
+    static void routing_info(ExpandingString &str) { routing.info(str); }
+
+#if AP_MAVLINK_MESSAGE_CACHE_ENABLED
+    /*
+      record bytes sent on a channel for the message cache
+     */
+    static void message_cache_capture(mavlink_channel_t chan, const uint8_t *buf, uint16_t len) { message_cache.capture(chan, buf, len); }
+
+    /*
+      message cache counters for @SYS/msgcache.txt
+     */
+    static void message_cache_info(ExpandingString &str) { message_cache.info(str); }
+#endif
     
     /*
       search for a component in the routing table with given mav_type and retrieve it's sysid, compid and channel
@@ -890,6 +908,7 @@ private:
     uint16_t get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const;
 
     bool do_try_send_message(const ap_message id);
+    bool try_send_cached_message(const ap_message id);
 
     // time when we missed sending a parameter for GCS
     static uint32_t reserve_param_space_start_ms;
@@ -906,6 +925,11 @@ private:
     // mavlink routing object
     static MAVLink_routing routing;
 
+#if AP_MAVLINK_MESSAGE_CACHE_ENABLED
+    // messages packed in this update, shared between links
+    static GCS_MessageCache message_cache;
+#endif
+
     struct pending_param_request {
         mavlink_channel_t chan;
         int16_t param_index;
@@ -987,13 +1011,42 @@ private:
         Write,
     };
 
+    // an open file, identified by the session number and the
+    // system that opened it so that several GCSs can transfer files
+    // at once over different links
+    struct ftp_session {
+        int fd = -1;
+        FTP_FILE_MODE mode; // work around AP_Filesystem not supporting file modes
+        uint8_t id;
+        uint8_t sysid;
+        uint8_t compid;
+        mavlink_channel_t chan;     // link of the most recent request
+        uint32_t last_request_ms;
+        uint32_t fd_offset;         // current position of fd
+
+        // data read ahead of the requested offset, allocated while a
+        // file other than an @PARAM file is open for reading
+        uint8_t *readahead;
+        uint32_t readahead_offset;
+        uint16_t readahead_len;
+
+        // burst read in progress, sent a few packets at a time
+        // between handling requests
+        struct {
+            bool active;
+            uint32_t offset;
+            uint32_t last_send_ms;
+            uint32_t delay_ms;
+            uint16_t seq_number;
+            uint16_t remaining;
+            uint8_t max_read;
+        } burst;
+    };
+
     struct ftp_state {
         ObjectBuffer<pending_ftp> *requests;
 
-        // session specific info, currently only support a single session over all links
-        int fd = -1;
-        FTP_FILE_MODE mode; // work around AP_Filesystem not supporting file modes
-        int16_t current_session;
+        ftp_session sessions[AP_MAVLINK_FTP_MAX_SESSIONS];
         uint32_t last_send_ms;
         uint8_t need_banner_send_mask;
     };
@@ -1002,12 +1055,17 @@ private:
     static void ftp_error(struct pending_ftp &response, FTP_ERROR error); // FTP helper method for packing a NAK
     static int gen_dir_entry(char *dest, size_t space, const char * path, const struct dirent * entry); // FTP helper for emitting a dir response
     static void ftp_list_dir(struct pending_ftp &request, struct pending_ftp &response);
+    static ftp_session *ftp_find_session(const pending_ftp &request);
+    static ftp_session *ftp_open_session(const pending_ftp &request, FTP_FILE_MODE mode, int fd);
+    static void ftp_close_session(ftp_session &session);
+    static ssize_t ftp_read(ftp_session &session, uint32_t offset, uint8_t *data, uint8_t size);
 
     bool ftp_init(void);
     void handle_file_transfer_protocol(const mavlink_message_t &msg);
     bool send_ftp_reply(const pending_ftp &reply);
     void ftp_worker(void);
     void ftp_push_replies(pending_ftp &reply);
+    bool ftp_send_bursts(void);
 
     void send_distance_sensor(const class AP_RangeFinder_Backend *sensor, const uint8_t instance) const;
 
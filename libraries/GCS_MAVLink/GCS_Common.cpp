@@ -1241,7 +1241,7 @@ bool GCS_MAVLINK::do_try_send_message(const ap_message id)
     void *data = hal.scheduler->disable_interrupts_save();
     uint32_t start_send_message_us = AP_HAL::micros();
 #endif
-    if (!try_send_message(id)) {
+    if (!try_send_cached_message(id)) {
         // didn't fit in buffer...
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
         try_send_message_stats.no_space_for_message++;
@@ -1260,6 +1260,44 @@ bool GCS_MAVLINK::do_try_send_message(const ap_message id)
     return true;
 }
 
+// call try_send_message, re-using the packed message if another link
+// sent the same message earlier in this update
+bool GCS_MAVLINK::try_send_cached_message(const ap_message id)
+{
+#if AP_MAVLINK_MESSAGE_CACHE_ENABLED
+    if (gcs().num_gcs() < 2) {
+        return try_send_message(id);
+    }
+    const uint32_t start_us = AP_HAL::micros();
+    const mavlink_msg_entry_t *entry;
+    const uint8_t *payload = message_cache.find(id, entry);
+    if (payload != nullptr) {
+        if (!check_payload_size(entry->max_msg_len)) {
+            return false;
+        }
+        _mav_finalize_message_chan_send(chan,
+                                        entry->msgid,
+                                        (const char *)payload,
+                                        entry->min_msg_len,
+                                        entry->max_msg_len,
+                                        entry->crc_extra);
+        message_cache.count_send(true, AP_HAL::micros() - start_us);
+        return true;
+    }
+    if (!message_cache.capture_start(chan, id)) {
+        return try_send_message(id);
+    }
+    const bool ret = try_send_message(id);
+    message_cache.capture_end(ret);
+    if (ret) {
+        message_cache.count_send(false, AP_HAL::micros() - start_us);
+    }
+    return ret;
+#else
+    return try_send_message(id);
+#endif
+}
+
 int8_t GCS_MAVLINK::get_deferred_message_index(const ap_message id) const
 {
     for (uint8_t i=0; i<ARRAY_SIZE(deferred_message); i++) {
@@ -2464,6 +2502,10 @@ void GCS::update_send()
         prot->update();
     }
 
+#if AP_MAVLINK_MESSAGE_CACHE_ENABLED
+    GCS_MAVLINK::message_cache.new_pass();
+#endif
+
     // round-robin the GCS_MAVLINK backend that gets to go first so
     // one backend doesn't monopolise all of the time allowed for sending
     // messages
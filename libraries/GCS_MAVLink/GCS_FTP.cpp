@@ -33,6 +33,8 @@ struct GCS_MAVLINK::ftp_state GCS_MAVLINK::ftp;
 
 // timeout for session inactivity
 #define FTP_SESSION_TIMEOUT 3000
+// number of packets of each burst read sent before looking for new requests
+#define FTP_BURST_WINDOW 8
 
 bool GCS_MAVLINK::ftp_init(void) {
 
@@ -105,7 +107,7 @@ bool GCS_MAVLINK::send_ftp_reply(const pending_ftp &reply)
         send_banner();
     }
     WITH_SEMAPHORE(comm_chan_lock(reply.chan));
-    if (!HAVE_PAYLOAD_SPACE(chan, FILE_TRANSFER_PROTOCOL)) {
+    if (!HAVE_PAYLOAD_SPACE(reply.chan, FILE_TRANSFER_PROTOCOL)) {
         return false;
     }
     uint8_t payload[251] = {};
@@ -160,6 +162,163 @@ void GCS_MAVLINK::ftp_push_replies(pending_ftp &reply)
     }
 }
 
+// find the open file for a request
+GCS_MAVLINK::ftp_session *GCS_MAVLINK::ftp_find_session(const pending_ftp &request)
+{
+    for (auto &session : ftp.sessions) {
+        if (session.fd != -1 && session.id == request.session &&
+            session.sysid == request.sysid && session.compid == request.compid) {
+            return &session;
+        }
+    }
+    return nullptr;
+}
+
+// take a free session for a newly opened file, closing the longest
+// idle session if they are all in use
+GCS_MAVLINK::ftp_session *GCS_MAVLINK::ftp_open_session(const pending_ftp &request, FTP_FILE_MODE mode, int fd)
+{
+    const uint32_t now = AP_HAL::millis();
+    ftp_session *session = nullptr;
+    for (auto &s : ftp.sessions) {
+        if (s.fd == -1) {
+            session = &s;
+            break;
+        }
+        if (!s.burst.active && now - s.last_request_ms >= FTP_SESSION_TIMEOUT &&
+            (session == nullptr || s.last_request_ms < session->last_request_ms)) {
+            session = &s;
+        }
+    }
+    if (session == nullptr) {
+        return nullptr;
+    }
+    ftp_close_session(*session);
+
+    session->fd = fd;
+    session->mode = mode;
+    session->id = request.session;
+    session->sysid = request.sysid;
+    session->compid = request.compid;
+    session->chan = request.chan;
+    session->last_request_ms = now;
+    session->fd_offset = 0;
+    // @PARAM files pad their contents to the read size so every read
+    // must be the size of a reply and can't go through the buffer
+    if (mode == FTP_FILE_MODE::Read &&
+        strncmp((const char *)request.data, "@PARAM/", 7) != 0) {
+        // if this fails the file is read a packet at a time
+        session->readahead = new uint8_t[AP_MAVLINK_FTP_READAHEAD_SIZE];
+    }
+    return session;
+}
+
+void GCS_MAVLINK::ftp_close_session(ftp_session &session)
+{
+    if (session.fd != -1) {
+        AP::FS().close(session.fd);
+        session.fd = -1;
+    }
+    delete[] session.readahead;
+    session.readahead = nullptr;
+    session.readahead_len = 0;
+    session.burst.active = false;
+}
+
+// read from an open file through its read-ahead buffer, returns the
+// number of bytes read, which is only short of size at the end of
+// the file, or -1 on error
+ssize_t GCS_MAVLINK::ftp_read(ftp_session &session, uint32_t offset, uint8_t *data, uint8_t size)
+{
+    if (session.readahead == nullptr) {
+        if (AP::FS().lseek(session.fd, offset, SEEK_SET) == -1) {
+            return -1;
+        }
+        return AP::FS().read(session.fd, data, size);
+    }
+
+    uint8_t total = 0;
+    while (total < size) {
+        const uint32_t ofs = offset + total;
+        if (ofs < session.readahead_offset || ofs >= session.readahead_offset + session.readahead_len) {
+            // refill the buffer, only seeking if this isn't the next
+            // part of the file
+            session.readahead_len = 0;
+            if (session.fd_offset != ofs && AP::FS().lseek(session.fd, ofs, SEEK_SET) == -1) {
+                session.fd_offset = UINT32_MAX;
+                return -1;
+            }
+            const ssize_t read_bytes = AP::FS().read(session.fd, session.readahead, AP_MAVLINK_FTP_READAHEAD_SIZE);
+            if (read_bytes == -1) {
+                session.fd_offset = UINT32_MAX;
+                return -1;
+            }
+            session.readahead_offset = ofs;
+            session.readahead_len = read_bytes;
+            session.fd_offset = ofs + read_bytes;
+            if (read_bytes == 0) {
+                break;
+            }
+        }
+        const uint16_t n = MIN(uint32_t(size - total), session.readahead_offset + session.readahead_len - ofs);
+        memcpy(&data[total], &session.readahead[ofs - session.readahead_offset], n);
+        total += n;
+    }
+    return total;
+}
+
+// send the next few packets of each burst read in progress, returns
+// true if anything was sent
+bool GCS_MAVLINK::ftp_send_bursts(void)
+{
+    bool sent = false;
+    for (auto &session : ftp.sessions) {
+        auto &burst = session.burst;
+        for (uint8_t i = 0; i < FTP_BURST_WINDOW && burst.active && session.fd != -1; i++) {
+            const uint32_t now = AP_HAL::millis();
+            if (burst.delay_ms != 0 && now - burst.last_send_ms < burst.delay_ms) {
+                break;
+            }
+
+            pending_ftp reply {};
+            reply.chan = session.chan;
+            reply.session = session.id;
+            reply.sysid = session.sysid;
+            reply.compid = session.compid;
+            reply.req_opcode = FTP_OP::BurstReadFile;
+            reply.seq_number = burst.seq_number;
+            reply.offset = burst.offset;
+
+            const ssize_t read_bytes = ftp_read(session, burst.offset, reply.data, burst.max_read);
+            if (read_bytes == -1) {
+                ftp_error(reply, FTP_ERROR::FailErrno);
+            } else if (read_bytes == 0) {
+                ftp_error(reply, FTP_ERROR::EndOfFile);
+            } else {
+                reply.opcode = FTP_OP::Ack;
+                reply.size = (uint8_t)read_bytes;
+                reply.burst_complete = (burst.remaining == 1);
+            }
+
+            if (!send_ftp_reply(reply)) {
+                // the link is full, the data will come from the
+                // read-ahead buffer when we try again
+                break;
+            }
+            sent = true;
+            burst.last_send_ms = now;
+            burst.seq_number++;
+            burst.remaining--;
+            if (reply.opcode == FTP_OP::Nack || burst.remaining == 0) {
+                burst.active = false;
+            } else {
+                burst.offset += read_bytes;
+            }
+        }
+    }
+    return sent;
+}
+
 void GCS_MAVLINK::ftp_worker(void) {
     pending_ftp request;
     pending_ftp reply = {};
@@ -169,8 +328,12 @@ void GCS_MAVLINK::ftp_worker(void) {
         bool skip_push_reply = false;
 
         while (ftp.requests == nullptr || !ftp.requests->pop(request)) {
-            // nothing to handle, delay ourselves a bit then check again. Ideally we'd use conditional waits here
-            hal.scheduler->delay(2);
+            // nothing to handle, carry on with any burst reads, if
+            // there is nothing to send delay ourselves a bit then
+            // check again. Ideally we'd use conditional waits here
+            if (!ftp_send_bursts()) {
+                hal.scheduler->delay(2);
+            }
         }
 
         // if it's a rerequest and we still have the last response then send it
@@ -196,379 +359,346 @@ void GCS_MAVLINK::ftp_worker(void) {
             continue;
         }
 
-        uint32_t now = AP_HAL::millis();
-
-        // check for session termination
-        if (request.session != ftp.current_session &&
-            (request.opcode == FTP_OP::TerminateSession || request.opcode == FTP_OP::ResetSessions)) {
-            // terminating a different session, just ack
-            reply.opcode = FTP_OP::Ack;
-        } else if (ftp.fd != -1 && request.session != ftp.current_session &&
-                   now - ftp.last_send_ms < FTP_SESSION_TIMEOUT) {
-            // if we have an open file and the session isn't right
-            // then reject. This prevents IO on the wrong file
-            ftp_error(reply, FTP_ERROR::InvalidSession);
-        } else {
-            if (ftp.fd != -1 &&
-                request.session != ftp.current_session &&
-                now - ftp.last_send_ms >= FTP_SESSION_TIMEOUT) {
-                // if a new session appears and the old session has
-                // been idle for more than the timeout then force
-                // close the old session
-                AP::FS().close(ftp.fd);
-                ftp.fd = -1;
-                ftp.current_session = -1;
-            }
-            // dispatch the command as needed
-            switch (request.opcode) {
-                case FTP_OP::None:
-                    reply.opcode = FTP_OP::Ack;
-                    break;
-                case FTP_OP::TerminateSession:
-                case FTP_OP::ResetSessions:
-                    // we already handled this, just listed for completeness
-                    if (ftp.fd != -1) {
-                        AP::FS().close(ftp.fd);
-                        ftp.fd = -1;
-                    }
-                    ftp.current_session = -1;
-                    reply.opcode = FTP_OP::Ack;
-                    break;
-                case FTP_OP::ListDirectory:
-                    ftp_list_dir(request, reply);
-                    break;
-                case FTP_OP::OpenFileRO:
-                    {
-                        // only allow one file to be open per session
-                        if (ftp.fd != -1 && now - ftp.last_send_ms > FTP_SESSION_TIMEOUT) {
-                            // no activity for 3s, assume client has
-                            // timed out receiving open reply, close
-                            // the file
-                            AP::FS().close(ftp.fd);
-                            ftp.fd = -1;
-                            ftp.current_session = -1;
-                        }
-                        if (ftp.fd != -1) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
-
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
-
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+        const uint32_t now = AP_HAL::millis();
 
-                        // get the file size
-                        struct stat st;
-                        if (AP::FS().stat((char *)request.data, &st)) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        const size_t file_size = st.st_size;
-
-                        // actually open the file
-                        ftp.fd = AP::FS().open((char *)request.data, O_RDONLY);
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        ftp.mode = FTP_FILE_MODE::Read;
-                        ftp.current_session = request.session;
-
-                        reply.opcode = FTP_OP::Ack;
-                        reply.size = sizeof(uint32_t);
-                        put_le32_ptr(reply.data, (uint32_t)file_size);
+        ftp_session *session = ftp_find_session(request);
+        if (session != nullptr) {
+            // replies go back over the link the last request came in on
+            session->chan = request.chan;
+        }
 
-                        // provide compatibility with old protocol banner download
-                        if (strncmp((const char *)request.data, "@PARAM/param.pck", 16) == 0) {
-                            ftp.need_banner_send_mask |= 1U<<reply.chan;
-                        }
+        // dispatch the command as needed
+        switch (request.opcode) {
+            case FTP_OP::None:
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::TerminateSession:
+                if (session != nullptr) {
+                    ftp_close_session(*session);
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::ResetSessions:
+                // close every file opened by this system
+                for (auto &s : ftp.sessions) {
+                    if (s.fd != -1 && s.sysid == request.sysid && s.compid == request.compid) {
+                        ftp_close_session(s);
+                    }
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::ListDirectory:
+                ftp_list_dir(request, reply);
+                break;
+            case FTP_OP::OpenFileRO:
+                {
+                    // only allow one file to be open per session
+                    if (session != nullptr && now - session->last_request_ms > FTP_SESSION_TIMEOUT) {
+                        // no activity for 3s, assume client has
+                        // timed out receiving open reply, close
+                        // the file
+                        ftp_close_session(*session);
+                        session = nullptr;
+                    }
+                    if (session != nullptr) {
+                        ftp_error(reply, FTP_ERROR::Fail);
                         break;
                     }
-                case FTP_OP::ReadFile:
-                    {
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
 
-                        // must have the file in read mode
-                        if ((ftp.mode != FTP_FILE_MODE::Read)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
-
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        // fill the buffer
-                        const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data),request.size));
-                        if (read_bytes == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        if (read_bytes == 0) {
-                            ftp_error(reply, FTP_ERROR::EndOfFile);
-                            break;
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        reply.opcode = FTP_OP::Ack;
-                        reply.offset = request.offset;
-                        reply.size = (uint8_t)read_bytes;
+                    // get the file size
+                    struct stat st;
+                    if (AP::FS().stat((char *)request.data, &st)) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
-                case FTP_OP::Ack:
-                case FTP_OP::Nack:
-                    // eat these, we just didn't expect them
-                    continue;
-                    break;
-                case FTP_OP::OpenFileWO:
-                case FTP_OP::CreateFile:
-                    {
-                        // only allow one file to be open per session
-                        if (ftp.fd != -1) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
-
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
+                    const size_t file_size = st.st_size;
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // actually open the file
+                    const int fd = AP::FS().open((char *)request.data, O_RDONLY);
+                    if (fd == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    session = ftp_open_session(request, FTP_FILE_MODE::Read, fd);
+                    if (session == nullptr) {
+                        AP::FS().close(fd);
+                        ftp_error(reply, FTP_ERROR::NoSessionsAvailable);
+                        break;
+                    }
 
-                        // actually open the file
-                        ftp.fd = AP::FS().open((char *)request.data,
-                                               (request.opcode == FTP_OP::CreateFile) ? O_WRONLY|O_CREAT|O_TRUNC : O_WRONLY);
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        ftp.mode = FTP_FILE_MODE::Write;
-                        ftp.current_session = request.session;
+                    reply.opcode = FTP_OP::Ack;
+                    reply.size = sizeof(uint32_t);
+                    put_le32_ptr(reply.data, (uint32_t)file_size);
 
-                        reply.opcode = FTP_OP::Ack;
+                    // provide compatibility with old protocol banner download
+                    if (strncmp((const char *)request.data, "@PARAM/param.pck", 16) == 0) {
+                        ftp.need_banner_send_mask |= 1U<<reply.chan;
+                    }
+                    break;
+                }
+            case FTP_OP::ReadFile:
+                {
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
                         break;
                     }
-                case FTP_OP::WriteFile:
-                    {
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
-
-                        // must have the file in write mode
-                        if ((ftp.mode != FTP_FILE_MODE::Write)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // must have the file in read mode
+                    if ((session->mode != FTP_FILE_MODE::Read)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
+                        break;
+                    }
 
-                        // fill the buffer
-                        const ssize_t write_bytes = AP::FS().write(ftp.fd, request.data, request.size);
-                        if (write_bytes == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // fill the buffer
+                    const ssize_t read_bytes = ftp_read(*session, request.offset, reply.data, MIN(sizeof(reply.data),request.size));
+                    if (read_bytes == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    if (read_bytes == 0) {
+                        ftp_error(reply, FTP_ERROR::EndOfFile);
+                        break;
+                    }
 
-                        reply.opcode = FTP_OP::Ack;
-                        reply.offset = request.offset;
+                    reply.opcode = FTP_OP::Ack;
+                    reply.offset = request.offset;
+                    reply.size = (uint8_t)read_bytes;
+                    break;
+                }
+            case FTP_OP::Ack:
+            case FTP_OP::Nack:
+                // eat these, we just didn't expect them
+                continue;
+                break;
+            case FTP_OP::OpenFileWO:
+            case FTP_OP::CreateFile:
+                {
+                    // only allow one file to be open per session
+                    if (session != nullptr) {
+                        ftp_error(reply, FTP_ERROR::Fail);
                         break;
                     }
-                case FTP_OP::CreateDirectory:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        // actually make the directory
-                        if (AP::FS().mkdir((char *)request.data) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        reply.opcode = FTP_OP::Ack;
+                    // actually open the file
+                    const int fd = AP::FS().open((char *)request.data,
+                                                 (request.opcode == FTP_OP::CreateFile) ? O_WRONLY|O_CREAT|O_TRUNC : O_WRONLY);
+                    if (fd == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    session = ftp_open_session(request, FTP_FILE_MODE::Write, fd);
+                    if (session == nullptr) {
+                        AP::FS().close(fd);
+                        ftp_error(reply, FTP_ERROR::NoSessionsAvailable);
                         break;
                     }
-                case FTP_OP::RemoveDirectory:
-                case FTP_OP::RemoveFile:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
-
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        // remove the file/dir
-                        if (AP::FS().unlink((char *)request.data) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::WriteFile:
+                {
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
+                        break;
+                    }
 
-                        reply.opcode = FTP_OP::Ack;
+                    // must have the file in write mode
+                    if ((session->mode != FTP_FILE_MODE::Write)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
                         break;
                     }
-                case FTP_OP::CalcFileCRC32:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // seek to requested offset
+                    if (AP::FS().lseek(session->fd, request.offset, SEEK_SET) == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
 
-                        uint32_t checksum = 0;
-                        if (!AP::FS().crc32((char *)request.data, checksum)) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // fill the buffer
+                    const ssize_t write_bytes = AP::FS().write(session->fd, request.data, request.size);
+                    if (write_bytes == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
 
-                        // reset our scratch area so we don't leak data, and can leverage trimming
-                        memset(reply.data, 0, sizeof(reply.data));
-                        reply.size = sizeof(uint32_t);
-                        put_le32_ptr(reply.data, checksum);
-                        reply.opcode = FTP_OP::Ack;
+                    reply.opcode = FTP_OP::Ack;
+                    reply.offset = request.offset;
+                    break;
+                }
+            case FTP_OP::CreateDirectory:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
                         break;
                     }
-                case FTP_OP::BurstReadFile:
-                    {
-                        const uint16_t max_read = (request.size == 0?sizeof(reply.data):request.size);
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
 
-                        // must have the file in read mode
-                        if ((ftp.mode != FTP_FILE_MODE::Read)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // actually make the directory
+                    if (AP::FS().mkdir((char *)request.data) == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
 
-                        /*
-                          calculate a burst delay so that FTP burst
-                          transfer doesn't use more than 1/3 of
-                          available bandwidth on links that don't have
-                          flow control. This reduces the chance of
-                          lost packets a lot, which results in overall
-                          faster transfers
-                         */
-                        uint32_t burst_delay_ms = 0;
-                        if (valid_channel(request.chan)) {
-                            auto *port = mavlink_comm_port[request.chan];
-                            if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
-                                const uint32_t bw = port->bw_in_bytes_per_second();
-                                const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
-                                burst_delay_ms = 3000 * pkt_size / bw;
-                            }
-                        }
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::RemoveDirectory:
+            case FTP_OP::RemoveFile:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        // this transfer size is enough for a full parameter file with max parameters
-                        const uint32_t transfer_size = 500;
-                        for (uint32_t i = 0; (i < transfer_size); i++) {
-                            // fill the buffer
-                            const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data), max_read));
-                            if (read_bytes == -1) {
-                                ftp_error(reply, FTP_ERROR::FailErrno);
-                                break;
-                            }
-
-                            if (read_bytes != sizeof(reply.data)) {
-                                // don't send any old data
-                                memset(reply.data + read_bytes, 0, sizeof(reply.data) - read_bytes);
-                            }
-
-                            if (read_bytes == 0) {
-                                ftp_error(reply, FTP_ERROR::EndOfFile);
-                                break;
-                            }
-
-                            reply.opcode = FTP_OP::Ack;
-                            reply.offset = request.offset + i * max_read;
-                            reply.burst_complete = (i == (transfer_size - 1));
-                            reply.size = (uint8_t)read_bytes;
-
-                            ftp_push_replies(reply);
-
-                            if (read_bytes < max_read) {
-                                // ensure the NACK which we send next is at the right offset
-                                reply.offset += read_bytes;
-                            }
-
-                            // prep the reply to be used again
-                            reply.seq_number++;
-
-                            hal.scheduler->delay(burst_delay_ms);
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        if (reply.opcode != FTP_OP::Nack) {
-                            // prevent a duplicate packet send for
-                            // normal replies of burst reads
-                            skip_push_reply = true;
-                        }
+                    // remove the file/dir
+                    if (AP::FS().unlink((char *)request.data) == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
 
-                case FTP_OP::Rename: {
-                    // sanity check that the request looks well formed
-                    const char *filename1 = (char*)request.data;
-                    const size_t len1 = strnlen(filename1, sizeof(request.data)-2);
-                    const char *filename2 = (char*)&request.data[len1+1];
-                    const size_t len2 = strnlen(filename2, sizeof(request.data)-(len1+1));
-                    if (filename1[len1] != 0 || (len1+len2+1 != request.size) || (request.size == 0)) {
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::CalcFileCRC32:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
                         ftp_error(reply, FTP_ERROR::InvalidDataSize);
                         break;
                     }
-                    request.data[sizeof(request.data) - 1] = 0; // ensure the 2nd path is null terminated
-                    // remove the file/dir
-                    if (AP::FS().rename(filename1, filename2) != 0) {
+
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+
+                    uint32_t checksum = 0;
+                    if (!AP::FS().crc32((char *)request.data, checksum)) {
                         ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
+
+                    // reset our scratch area so we don't leak data, and can leverage trimming
+                    memset(reply.data, 0, sizeof(reply.data));
+                    reply.size = sizeof(uint32_t);
+                    put_le32_ptr(reply.data, checksum);
                     reply.opcode = FTP_OP::Ack;
                     break;
                 }
+            case FTP_OP::BurstReadFile:
+                {
+                    const uint16_t max_read = (request.size == 0?sizeof(reply.data):request.size);
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
+                        break;
+                    }
+
+                    // must have the file in read mode
+                    if ((session->mode != FTP_FILE_MODE::Read)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
+                        break;
+                    }
+
+                    /*
+                      calculate a burst delay so that FTP burst
+                      transfer doesn't use more than 1/3 of
+                      available bandwidth on links that don't have
+                      flow control. This reduces the chance of
+                      lost packets a lot, which results in overall
+                      faster transfers
+                     */
+                    uint32_t burst_delay_ms = 0;
+                    if (valid_channel(request.chan)) {
+                        auto *port = mavlink_comm_port[request.chan];
+                        if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
+                            const uint32_t bw = port->bw_in_bytes_per_second();
+                            const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
+                            burst_delay_ms = 3000 * pkt_size / bw;
+                        }
+                    }
+
+                    /*
+                      the packets are sent by ftp_send_bursts() a
+                      few at a time between requests, so bursts on
+                      several sessions share the worker. A new burst
+                      replaces any burst still in progress, which
+                      is how a client resumes from a lost packet
+                     */
+                    auto &burst = session->burst;
+                    burst.active = true;
+                    burst.offset = request.offset;
+                    burst.max_read = max_read;
+                    // this transfer size is enough for a full parameter file with max parameters
+                    burst.remaining = 500;
+                    burst.seq_number = reply.seq_number;
+                    burst.delay_ms = burst_delay_ms;
+                    burst.last_send_ms = now - burst_delay_ms;
+
+                    // prevent a duplicate packet send for normal
+                    // replies of burst reads, and don't resend this
+                    // unsent reply if the request is repeated
+                    skip_push_reply = true;
+                    reply.session = -1;
+                    break;
+                }
 
-                case FTP_OP::TruncateFile:
-                default:
-                    // this was bad data, just nack it
-                    gcs().send_text(MAV_SEVERITY_DEBUG, "Unsupported FTP: %d", static_cast<int>(request.opcode));
-                    ftp_error(reply, FTP_ERROR::Fail);
+            case FTP_OP::Rename: {
+                // sanity check that the request looks well formed
+                const char *filename1 = (char*)request.data;
+                const size_t len1 = strnlen(filename1, sizeof(request.data)-2);
+                const char *filename2 = (char*)&request.data[len1+1];
+                const size_t len2 = strnlen(filename2, sizeof(request.data)-(len1+1));
+                if (filename1[len1] != 0 || (len1+len2+1 != request.size) || (request.size == 0)) {
+                    ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                    break;
+                }
+                request.data[sizeof(request.data) - 1] = 0; // ensure the 2nd path is null terminated
+                // remove the file/dir
+                if (AP::FS().rename(filename1, filename2) != 0) {
+                    ftp_error(reply, FTP_ERROR::FailErrno);
                     break;
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
             }
+
+            case FTP_OP::TruncateFile:
+            default:
+                // this was bad data, just nack it
+                gcs().send_text(MAV_SEVERITY_DEBUG, "Unsupported FTP: %d", static_cast<int>(request.opcode));
+                ftp_error(reply, FTP_ERROR::Fail);
+                break;
+        }
+
+        if (session != nullptr) {
+            session->last_request_ms = now;
         }
 
         if (!skip_push_reply) {
@@ -0,0 +1,157 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  share packed telemetry messages between MAVLink links
+ */
+
+#include "GCS_MessageCache.h"
+
+#if AP_MAVLINK_MESSAGE_CACHE_ENABLED
+
+#include <AP_Common/ExpandingString.h>
+
+/*
+  return the MAVLink id of a message which is the same on every link,
+  or UINT32_MAX if the message can't be cached. Messages which depend
+  on per-link state, such as the next parameter or battery instance
+  to send, must not be listed here
+ */
+uint32_t GCS_MessageCache::cacheable_msgid(ap_message id)
+{
+    switch (id) {
+    case MSG_ATTITUDE:
+        return MAVLINK_MSG_ID_ATTITUDE;
+    case MSG_ATTITUDE_QUATERNION:
+        return MAVLINK_MSG_ID_ATTITUDE_QUATERNION;
+    case MSG_LOCATION:
+        return MAVLINK_MSG_ID_GLOBAL_POSITION_INT;
+    case MSG_LOCAL_POSITION:
+        return MAVLINK_MSG_ID_LOCAL_POSITION_NED;
+    case MSG_SYS_STATUS:
+        return MAVLINK_MSG_ID_SYS_STATUS;
+    case MSG_NAV_CONTROLLER_OUTPUT:
+        return MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT;
+    case MSG_VFR_HUD:
+        return MAVLINK_MSG_ID_VFR_HUD;
+    case MSG_SERVO_OUTPUT_RAW:
+        return MAVLINK_MSG_ID_SERVO_OUTPUT_RAW;
+    case MSG_RC_CHANNELS:
+        return MAVLINK_MSG_ID_RC_CHANNELS;
+    case MSG_RAW_IMU:
+        return MAVLINK_MSG_ID_RAW_IMU;
+    case MSG_SCALED_PRESSURE:
+        return MAVLINK_MSG_ID_SCALED_PRESSURE;
+    case MSG_GPS_RAW:
+        return MAVLINK_MSG_ID_GPS_RAW_INT;
+    case MSG_SYSTEM_TIME:
+        return MAVLINK_MSG_ID_SYSTEM_TIME;
+    case MSG_AHRS:
+        return MAVLINK_MSG_ID_AHRS;
+    case MSG_VIBRATION:
+        return MAVLINK_MSG_ID_VIBRATION;
+    case MSG_EKF_STATUS_REPORT:
+        return MAVLINK_MSG_ID_EKF_STATUS_REPORT;
+    case MSG_POSITION_TARGET_GLOBAL_INT:
+        return MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT;
+    default:
+        break;
+    }
+    return UINT32_MAX;
+}
+
+/*
+  find a message packed earlier in this pass over the links
+ */
+const uint8_t *GCS_MessageCache::find(ap_message id, const mavlink_msg_entry_t *&entry)
+{
+    const struct slot &s = slots[uint8_t(id) % GCS_MESSAGE_CACHE_SLOTS];
+    if (s.pass != pass || s.id != id) {
+        return nullptr;
+    }
+    entry = s.entry;
+    return s.payload;
+}
+
+/*
+  start capturing the bytes of a message sent on a channel
+ */
+bool GCS_MessageCache::capture_start(mavlink_channel_t chan, ap_message id)
+{
+    capture_msgid = cacheable_msgid(id);
+    if (capture_msgid == UINT32_MAX) {
+        return false;
+    }
+    capture_chan = chan;
+    capture_id = id;
+    capture_len = 0;
+    return true;
+}
+
+/*
+  keep the payload of the captured message if exactly one MAVLink2
+  frame of the expected message was sent. MAVLink1 frames are not kept
+  as they lack the extension fields
+ */
+void GCS_MessageCache::capture_end(bool sent)
+{
+    const uint16_t len = capture_len;
+    capture_chan = mavlink_channel_t(MAVLINK_COMM_NUM_BUFFERS);
+    if (!sent || len < MAVLINK_NUM_HEADER_BYTES || frame[0] != MAVLINK_STX) {
+        return;
+    }
+    const uint8_t payload_len = frame[1];
+    const uint8_t signature_len = (frame[2] & MAVLINK_IFLAG_SIGNED) ? MAVLINK_SIGNATURE_BLOCK_LEN : 0;
+    const uint32_t msgid = frame[7] | (frame[8]<<8) | (uint32_t(frame[9])<<16);
+    if (msgid != capture_msgid ||
+        len != MAVLINK_NUM_NON_PAYLOAD_BYTES + payload_len + signature_len) {
+        return;
+    }
+    const mavlink_msg_entry_t *entry = mavlink_get_msg_entry(msgid);
+    if (entry == nullptr || payload_len > entry->max_msg_len) {
+        return;
+    }
+
+    // MAVLink2 trims the zeros from the end of the payload, put them
+    // back so any link can send it
+    struct slot &s = slots[uint8_t(capture_id) % GCS_MESSAGE_CACHE_SLOTS];
+    s.pass = pass;
+    s.id = capture_id;
+    s.entry = entry;
+    memcpy(s.payload, &frame[MAVLINK_NUM_HEADER_BYTES], payload_len);
+    memset(&s.payload[payload_len], 0, entry->max_msg_len - payload_len);
+}
+
+void GCS_MessageCache::count_send(bool cached, uint32_t time_us)
+{
+    if (cached) {
+        stats.cached++;
+        stats.cached_us += time_us;
+    } else {
+        stats.packed++;
+        stats.packed_us += time_us;
+    }
+}
+
+void GCS_MessageCache::info(ExpandingString &str) const
+{
+    str.printf("Packed: %u avg %uus\n",
+               unsigned(stats.packed),
+               unsigned(stats.packed ? stats.packed_us / stats.packed : 0));
+    str.printf("Cached: %u avg %uus\n",
+               unsigned(stats.cached),
+               unsigned(stats.cached ? stats.cached_us / stats.cached : 0));
+}
+
+#endif  // AP_MAVLINK_MESSAGE_CACHE_ENABLED
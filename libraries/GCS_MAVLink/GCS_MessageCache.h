@@ -0,0 +1,91 @@
+/// @file	GCS_MessageCache.h
+/// @brief	share packed telemetry messages between MAVLink links
+#pragma once
+
+#include "GCS_config.h"
+
+#if AP_MAVLINK_MESSAGE_CACHE_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include "GCS_MAVLink.h"
+#include "ap_message.h"
+
+// number of messages kept from each update, messages share slots by
+// their ap_message id
+#define GCS_MESSAGE_CACHE_SLOTS 8
+
+class ExpandingString;
+
+/*
+  cache of the packed payloads of messages sent in the current pass
+  over the links. When a message is due on several links in the same
+  update the first link packs it as normal while the bytes it sends
+  are captured, and the other links re-frame the captured payload with
+  their own sequence number and signing.
+
+  Only messages whose contents don't depend on the link are cached.
+ */
+class GCS_MessageCache
+{
+public:
+    // start a new pass over the links, the messages cached in the
+    // last pass are no longer used
+    void new_pass() { pass++; }
+
+    // find a message packed earlier in this pass, returns nullptr
+    // if there is none
+    const uint8_t *find(ap_message id, const mavlink_msg_entry_t *&entry);
+
+    // start capturing the bytes sent on chan for message id. Returns
+    // false if the message can't be cached
+    bool capture_start(mavlink_channel_t chan, ap_message id);
+
+    // called for all bytes sent on a channel
+    void capture(mavlink_channel_t chan, const uint8_t *buf, uint16_t len) {
+        if (capture_chan == chan && capture_len + len <= sizeof(frame)) {
+            memcpy(&frame[capture_len], buf, len);
+            capture_len += len;
+        } else if (capture_chan == chan) {
+            // more than one message was sent
+            capture_len = UINT16_MAX;
+        }
+    }
+
+    // finish capturing, keeping the message if it was sent
+    void capture_end(bool sent);
+
+    // count a message send, taking time_us
+    void count_send(bool cached, uint32_t time_us);
+
+    // report hit counts and send times for @SYS/msgcache.txt
+    void info(ExpandingString &str) const;
+
+private:
+    struct slot {
+        uint32_t pass;
+        ap_message id;
+        const mavlink_msg_entry_t *entry;
+        uint8_t payload[MAVLINK_MAX_PAYLOAD_LEN];
+    } slots[GCS_MESSAGE_CACHE_SLOTS];
+
+    // MAVLink id of a message which can be cached, or UINT32_MAX
+    static uint32_t cacheable_msgid(ap_message id);
+
+    uint32_t pass = 1;
+
+    // frame being captured
+    uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+    uint16_t capture_len;
+    mavlink_channel_t capture_chan = mavlink_channel_t(MAVLINK_COMM_NUM_BUFFERS);
+    ap_message capture_id;
+    uint32_t capture_msgid;
+
+    struct {
+        uint32_t packed;
+        uint32_t cached;
+        uint64_t packed_us;
+        uint64_t cached_us;
+    } stats;
+};
+
+#endif  // AP_MAVLINK_MESSAGE_CACHE_ENABLED
@@ -42,6 +42,28 @@
 #define AP_MAVLINK_MAV_CMD_REQUEST_AUTOPILOT_CAPABILITIES_ENABLED 1
 #endif
 
+// number of files which may be open at once over MAVLink FTP
+#ifndef AP_MAVLINK_FTP_MAX_SESSIONS
+#define AP_MAVLINK_FTP_MAX_SESSIONS 3
+#endif
+
+// size of the buffer each MAVLink FTP download reads the file into,
+// larger reads are much quicker than one read per packet on most
+// filesystems
+#ifndef AP_MAVLINK_FTP_READAHEAD_SIZE
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define AP_MAVLINK_FTP_READAHEAD_SIZE 4096
+#else
+#define AP_MAVLINK_FTP_READAHEAD_SIZE 1024
+#endif
+#endif
+
+// keep the packed copy of common telemetry messages so other links
+// sending the same message in the same update can re-use it
+#ifndef AP_MAVLINK_MESSAGE_CACHE_ENABLED
+#define AP_MAVLINK_MESSAGE_CACHE_ENABLED (HAL_GCS_ENABLED && HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
 #ifndef HAL_MAVLINK_INTERVALS_FROM_FILES_ENABLED
 #define HAL_MAVLINK_INTERVALS_FROM_FILES_ENABLED ((AP_FILESYSTEM_FATFS_ENABLED || AP_FILESYSTEM_POSIX_ENABLED) && BOARD_FLASH_SIZE > 1024)
 #endif
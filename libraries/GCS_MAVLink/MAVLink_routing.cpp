@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/ExpandingString.h>
 #include "GCS.h"
 #include "MAVLink_routing.h"
 
@@ -30,6 +31,10 @@ extern const AP_HAL::HAL& hal;
 
 #define ROUTING_DEBUG 0
 
+static_assert(MAVLINK_COMM_NUM_BUFFERS <= 8, "channel masks must fit in a uint8_t");
+static_assert((MAVLINK_ROUTE_HASH_SIZE & (MAVLINK_ROUTE_HASH_SIZE - 1)) == 0, "hash size must be a power of two");
+static_assert(MAVLINK_ROUTE_HASH_SIZE > MAVLINK_MAX_ROUTES, "hash tables must always have an empty slot");
+
 // constructor
 MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
 
@@ -94,6 +99,8 @@ routing table.
 */
 bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
+    stats.checked++;
+
 #if HAL_SOLO_GIMBAL_ENABLED
     // check if a Gopro is connected. If yes, we allow the routing
     // of mavlink messages to a private channel (Solo Gimbal case)
@@ -164,46 +171,36 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
         return true;
     }
 
-    // forward on any channels matching the targets
-    bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
+    // find the channels matching the targets
+    uint8_t mask;
+    if (broadcast_system) {
+        mask = all_routes_mask;
+    } else if (broadcast_component || !match_system) {
+        mask = system_mask(target_system);
+    } else {
+        mask = route_mask(target_system, target_component);
+    }
 
-        // Skip if channel is private and the target system or component IDs do not match
-        GCS_MAVLINK *out_link = gcs().chan(routes[i].channel);
-        if (out_link == nullptr) {
-            // this is bad
-            continue;
-        }
-        if (out_link->is_private() &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
-            continue;
-        }
+    // private channels only get messages addressed to a component
+    // seen on them
+    const uint8_t private_mask = GCS_MAVLINK::private_channel_mask();
+    mask = (mask & ~private_mask) | (mask & private_mask & route_mask(target_system, target_component));
 
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
+    // never send back out on the incoming channel
+    mask &= ~(1U<<(in_link.get_chan()-MAVLINK_COMM_0));
 
-            if (&in_link != out_link && !sent_to_chan[routes[i].channel]) {
-                if (out_link->check_payload_size(msg.len)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_link->get_chan(),
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
-#endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
-        }
+    if (mask != 0) {
+        ::printf("fwd msg %u from chan %u on chans 0x%02x sysid=%d compid=%d\n",
+                 msg.msgid,
+                 (unsigned)in_link.get_chan(),
+                 (unsigned)mask,
+                 (int)target_system,
+                 (int)target_component);
     }
+#endif
+    forward(mask, msg);
+    const bool forwarded = (mask != 0);
 
     if ((!forwarded && match_system) ||
         broadcast_system) {
@@ -229,29 +226,23 @@ void MAVLink_routing::send_to_components(uint32_t msgid, const char *pkt, uint8_
 
 void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entry_t *entry, const uint8_t pkt_len)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
+    // channels our system ID has been seen on
+    const uint8_t mask = system_mask(mavlink_system.sysid);
 
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid != mavlink_system.sysid) {
-            // our system ID hasn't been seen on this link
-            continue;
-        }
-        if (sent_to_chan[routes[i].channel]) {
-            // we've already send it on this link
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(mask & (1U<<i))) {
             continue;
         }
-        if (comm_get_txspace(routes[i].channel) <
-            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) <
+            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(channel)) {
             // it doesn't fit on this channel
             continue;
         }
 #if ROUTING_DEBUG
-        ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
+        ::printf("send msg %u on chan %u\n",
                  entry->msgid,
-                 (unsigned)routes[i].channel,
-                 (unsigned)routes[i].sysid,
-                 (unsigned)routes[i].compid);
+                 (unsigned)channel);
 #endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         if (entry->max_msg_len > pkt_len) {
@@ -259,13 +250,12 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                           entry->max_msg_len, pkt_len);
         }
 #endif
-        _mav_finalize_message_chan_send(routes[i].channel,
+        _mav_finalize_message_chan_send(channel,
                                         entry->msgid,
                                         pkt,
                                         entry->min_msg_len,
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
-        sent_to_chan[routes[i].channel] = true;
     }
 }
 
@@ -280,7 +270,7 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
         if (routes[i].mavtype == mavtype) {
             sysid = routes[i].sysid;
             compid = routes[i].compid;
-            channel = routes[i].channel;
+            channel = (mavlink_channel_t)(MAVLINK_COMM_0 + routes[i].first_chan);
             return true;
         }
     }
@@ -298,19 +288,146 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
     for (uint8_t i=0; i<num_routes; i++) {
         if ((routes[i].mavtype == mavtype) && (routes[i].compid == compid)) {
             sysid = routes[i].sysid;
-            channel = routes[i].channel;
+            channel = (mavlink_channel_t)(MAVLINK_COMM_0 + routes[i].first_chan);
             return true;
         }
     }
     return false;
 }
 
+/*
+  find the slot in route_hash holding the route for sysid/compid,
+  or the empty slot where it would be added
+*/
+uint8_t MAVLink_routing::route_slot(uint8_t sysid, uint8_t compid) const
+{
+    uint8_t slot = (sysid * 37U + compid) & (MAVLINK_ROUTE_HASH_SIZE - 1);
+    while (route_hash[slot] != 0) {
+        const route &r = routes[route_hash[slot] - 1];
+        if (r.sysid == sysid && r.compid == compid) {
+            break;
+        }
+        slot = (slot + 1) & (MAVLINK_ROUTE_HASH_SIZE - 1);
+    }
+    return slot;
+}
+
+/*
+  find the slot in system_hash holding the route for sysid, or the
+  empty slot where it would be added
+*/
+uint8_t MAVLink_routing::system_slot(uint8_t sysid) const
+{
+    uint8_t slot = (sysid * 37U) & (MAVLINK_ROUTE_HASH_SIZE - 1);
+    while (system_hash[slot] != 0 && systems[system_hash[slot] - 1].sysid != sysid) {
+        slot = (slot + 1) & (MAVLINK_ROUTE_HASH_SIZE - 1);
+    }
+    return slot;
+}
+
+// channels a sysid/compid has been seen on, the targets are -1 if
+// the message doesn't have them
+uint8_t MAVLink_routing::route_mask(int16_t sysid, int16_t compid) const
+{
+    if (sysid < 0 || compid < 0) {
+        return 0;
+    }
+    const uint8_t idx = route_hash[route_slot(sysid, compid)];
+    return idx == 0 ? 0 : routes[idx - 1].channel_mask;
+}
+
+// channels any component of a sysid has been seen on
+uint8_t MAVLink_routing::system_mask(int16_t sysid) const
+{
+    if (sysid < 0) {
+        return 0;
+    }
+    const uint8_t idx = system_hash[system_slot(sysid)];
+    return idx == 0 ? 0 : systems[idx - 1].channel_mask;
+}
+
+/*
+  copy a received message into buf exactly as it arrived, returning
+  its length. Unlike mavlink_msg_to_send_buffer() the payload is not
+  trimmed again, as that would change the length byte covered by the
+  received checksum and signature
+*/
+static uint16_t resend_buffer(uint8_t *buf, const mavlink_message_t &msg)
+{
+    uint16_t n;
+    uint8_t signature_len = 0;
+    if (msg.magic == MAVLINK_STX_MAVLINK1) {
+        buf[0] = msg.magic;
+        buf[1] = msg.len;
+        buf[2] = msg.seq;
+        buf[3] = msg.sysid;
+        buf[4] = msg.compid;
+        buf[5] = msg.msgid & 0xFF;
+        n = MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1;
+    } else {
+        buf[0] = msg.magic;
+        buf[1] = msg.len;
+        buf[2] = msg.incompat_flags;
+        buf[3] = msg.compat_flags;
+        buf[4] = msg.seq;
+        buf[5] = msg.sysid;
+        buf[6] = msg.compid;
+        buf[7] = msg.msgid & 0xFF;
+        buf[8] = (msg.msgid >> 8) & 0xFF;
+        buf[9] = (msg.msgid >> 16) & 0xFF;
+        n = MAVLINK_CORE_HEADER_LEN + 1;
+        if (msg.incompat_flags & MAVLINK_IFLAG_SIGNED) {
+            signature_len = MAVLINK_SIGNATURE_BLOCK_LEN;
+        }
+    }
+    memcpy(&buf[n], _MAV_PAYLOAD(&msg), msg.len);
+    n += msg.len;
+    buf[n++] = msg.checksum & 0xFF;
+    buf[n++] = msg.checksum >> 8;
+    memcpy(&buf[n], msg.signature, signature_len);
+    return n + signature_len;
+}
+
+/*
+  send a message on each channel in mask. The message is copied into
+  a buffer once and the same bytes written to each channel
+*/
+void MAVLink_routing::forward(uint8_t mask, const mavlink_message_t &msg)
+{
+    if (mask == 0) {
+        return;
+    }
+    stats.forwarded++;
+
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    const uint16_t len = resend_buffer(buf, msg);
+
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(mask & (1U<<i))) {
+            continue;
+        }
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        GCS_MAVLINK *out_link = gcs().chan(channel);
+        if (out_link == nullptr) {
+            // this is bad
+            continue;
+        }
+        if (!out_link->check_payload_size(msg.len)) {
+            stats.no_space++;
+            continue;
+        }
+        comm_send_lock(channel, len);
+        comm_send_buffer(channel, buf, len);
+        comm_send_unlock(channel);
+        stats.sends++;
+    }
+}
+
 /*
   see if the message is for a new route and learn it
 */
 void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -328,34 +445,51 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
         return;
     }
     const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-            }
-            break;
+    const uint8_t chan_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+
+    const uint8_t slot = route_slot(msg.sysid, msg.compid);
+    if (route_hash[slot] == 0) {
+        if (num_routes >= MAVLINK_MAX_ROUTES) {
+            stats.table_full++;
+            return;
         }
+        route &r = routes[num_routes++];
+        r.sysid = msg.sysid;
+        r.compid = msg.compid;
+        r.mavtype = 0;
+        r.channel_mask = 0;
+        r.first_chan = in_channel - MAVLINK_COMM_0;
+        route_hash[slot] = num_routes;
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg.sysid;
-        routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-        }
-        num_routes++;
+    route &r = routes[route_hash[slot] - 1];
+    if (r.mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r.mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    }
+    if (r.channel_mask & chan_bit) {
+        // already known
+        return;
+    }
+    r.channel_mask |= chan_bit;
+    all_routes_mask |= chan_bit;
+
+    // there are never more systems than routes, so there is always room
+    const uint8_t sslot = system_slot(msg.sysid);
+    if (system_hash[sslot] == 0) {
+        system_route &sr = systems[num_systems++];
+        sr.sysid = msg.sysid;
+        sr.channel_mask = 0;
+        system_hash[sslot] = num_systems;
+    }
+    systems[system_hash[sslot] - 1].channel_mask |= chan_bit;
+
 #if ROUTING_DEBUG
-        ::printf("learned route %u %u via %u\n",
-                 (unsigned)msg.sysid,
-                 (unsigned)msg.compid,
-                 (unsigned)in_channel);
+    ::printf("learned route %u %u via %u\n",
+             (unsigned)msg.sysid,
+             (unsigned)msg.compid,
+             (unsigned)in_channel);
 #endif
-    }
 }
 
-
 /*
   special handling for heartbeat messages. To ensure routing
   propagation heartbeat messages need to be forwarded on all channels
@@ -363,7 +497,7 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
 */
 void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_t &msg)
 {
-    uint16_t mask = GCS_MAVLINK::active_channel_mask() & ~GCS_MAVLINK::private_channel_mask();
+    uint8_t mask = GCS_MAVLINK::active_channel_mask() & ~GCS_MAVLINK::private_channel_mask();
 
     const mavlink_channel_t in_channel = link.get_chan();
 
@@ -375,34 +509,20 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
-    }
+    mask &= ~route_mask(msg.sysid, msg.compid);
 
-    if (mask == 0) {
-        // nothing to send to
-        return;
+#if ROUTING_DEBUG
+    if (mask != 0) {
+        ::printf("fwd HB from chan %u on chans 0x%02x from sysid=%u compid=%u\n",
+                 (unsigned)in_channel,
+                 (unsigned)mask,
+                 (unsigned)msg.sysid,
+                 (unsigned)msg.compid);
     }
+#endif
 
     // send on the remaining channels
-    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
-        if (mask & (1U<<i)) {
-            mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
-            if (comm_get_txspace(channel) >= ((uint16_t)msg.len) +
-                GCS_MAVLINK::packet_overhead_chan(channel)) {
-#if ROUTING_DEBUG
-                ::printf("fwd HB from chan %u on chan %u from sysid=%u compid=%u\n",
-                         (unsigned)in_channel,
-                         (unsigned)channel,
-                         (unsigned)msg.sysid,
-                         (unsigned)msg.compid);
-#endif
-                _mavlink_resend_uart(channel, &msg);
-            }
-        }
-    }
+    forward(mask, msg);
 }
 
 
@@ -425,4 +545,25 @@ void MAVLink_routing::get_targets(const mavlink_message_t &msg, int16_t &sysid,
     }
 }
 
+/*
+  routing table and counters for @SYS/routing.txt
+*/
+void MAVLink_routing::info(ExpandingString &str) const
+{
+    str.printf("Routes: %u/%u Systems: %u\n", (unsigned)num_routes, (unsigned)MAVLINK_MAX_ROUTES, (unsigned)num_systems);
+    str.printf("Checked: %lu Forwarded: %lu Sends: %lu NoSpace: %lu TableFull: %lu\n",
+               (unsigned long)stats.checked,
+               (unsigned long)stats.forwarded,
+               (unsigned long)stats.sends,
+               (unsigned long)stats.no_space,
+               (unsigned long)stats.table_full);
+    for (uint8_t i=0; i<num_routes; i++) {
+        str.printf("%3u/%3u type=%u chans=0x%02x\n",
+                   (unsigned)routes[i].sysid,
+                   (unsigned)routes[i].compid,
+                   (unsigned)routes[i].mavtype,
+                   (unsigned)routes[i].channel_mask);
+    }
+}
+
 #endif  // HAL_GCS_ENABLED
@@ -9,6 +9,12 @@
 // we make more extensive use of MAVLink forwarding
 #define MAVLINK_MAX_ROUTES 20
 
+// number of slots in the route hash tables, a power of two with
+// enough spare slots to keep probe sequences short when full
+#define MAVLINK_ROUTE_HASH_SIZE 32
+
+class ExpandingString;
+
 /*
   object to handle MAVLink packet routing
  */
@@ -49,23 +55,65 @@ public:
      */
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
+    // fill in the routing table and counters for @SYS/routing.txt
+    void info(ExpandingString &str) const;
+
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    // a route for each sysid/compid seen, with the channels it has
+    // been seen on. Routes are found through route_hash, and the
+    // table is only scanned for lookups by mavtype
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
-        mavlink_channel_t channel;
         uint8_t mavtype;
+        uint8_t channel_mask;
+        uint8_t first_chan;     // channel the route was first seen on
     } routes[MAVLINK_MAX_ROUTES];
-    
+
+    // channels each sysid has been seen on, for messages to all
+    // components of a system or to another system
+    uint8_t num_systems;
+    struct system_route {
+        uint8_t sysid;
+        uint8_t channel_mask;
+    } systems[MAVLINK_MAX_ROUTES];
+
+    // open addressing hash tables holding the index+1 of entries in
+    // routes[] and systems[], zero is an empty slot. Routes are
+    // never removed
+    uint8_t route_hash[MAVLINK_ROUTE_HASH_SIZE];
+    uint8_t system_hash[MAVLINK_ROUTE_HASH_SIZE];
+
+    // channels any route has been seen on
+    uint8_t all_routes_mask;
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
-    
+
+    struct {
+        uint32_t checked;       // messages passed to check_and_forward
+        uint32_t forwarded;     // messages forwarded on at least one channel
+        uint32_t sends;         // copies of messages forwarded
+        uint32_t no_space;      // copies dropped for lack of space
+        uint32_t table_full;    // messages from a new sysid/compid not learned
+    } stats;
+
+    // slot in route_hash or system_hash which holds the entry for
+    // a sysid/compid or sysid, or the empty slot it would go in
+    uint8_t route_slot(uint8_t sysid, uint8_t compid) const;
+    uint8_t system_slot(uint8_t sysid) const;
+
+    // channels the route or system has been seen on, 0 if none
+    uint8_t route_mask(int16_t sysid, int16_t compid) const;
+    uint8_t system_mask(int16_t sysid) const;
+
     // learn new routes
     void learn_route(GCS_MAVLINK &link, const mavlink_message_t &msg);
 
+    // send a message as received on each channel in mask
+    void forward(uint8_t mask, const mavlink_message_t &msg);
+
     // extract target sysid and compid from a message
     void get_targets(const mavlink_message_t &msg, int16_t &sysid, int16_t &compid);
 
@@ -44,6 +44,15 @@ MAV_MISSION_RESULT MissionItemProtocol_Waypoints::append_item(const mavlink_miss
         }
     }
 
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+    if (mission.staged_upload_active()) {
+        if (!mission.stage_cmd(cmd)) {
+            return MAV_MISSION_ERROR;
+        }
+        return MAV_MISSION_ACCEPTED;
+    }
+#endif
+
     if (!mission.add_cmd(cmd)) {
         return MAV_MISSION_ERROR;
     }
@@ -57,6 +66,11 @@ bool MissionItemProtocol_Waypoints::clear_all_items()
 
 MAV_MISSION_RESULT MissionItemProtocol_Waypoints::complete(const GCS_MAVLINK &_link)
 {
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+    if (mission.staged_upload_active() && !mission.commit_staged_upload()) {
+        return MAV_MISSION_ERROR;
+    }
+#endif
     _link.send_text(MAV_SEVERITY_INFO, "Flight plan received");
 #if HAL_LOGGING_ENABLED
     AP::logger().Write_EntireMission();
@@ -108,6 +122,11 @@ MAV_MISSION_RESULT MissionItemProtocol_Waypoints::get_item(const GCS_MAVLINK &_l
 }
 
 uint16_t MissionItemProtocol_Waypoints::item_count() const {
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+    if (mission.staged_upload_active()) {
+        return mission.num_staged_cmds();
+    }
+#endif
     return mission.num_commands();
 }
 
@@ -143,8 +162,31 @@ void MissionItemProtocol_Waypoints::timeout()
 
 void MissionItemProtocol_Waypoints::truncate(const mavlink_mission_count_t &packet)
 {
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+    if (mission.staged_upload_active()) {
+        // the stored mission is replaced when the upload completes
+        return;
+    }
+#endif
     // new mission arriving, truncate mission to be the same length
     mission.truncate(packet.count);
 }
 
+MAV_MISSION_RESULT MissionItemProtocol_Waypoints::allocate_receive_resources(const uint16_t count)
+{
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+    // if there is not enough memory to stage the mission the items
+    // are written to storage as they arrive
+    mission.begin_staged_upload(count);
+#endif
+    return MAV_MISSION_ACCEPTED;
+}
+
+void MissionItemProtocol_Waypoints::free_upload_resources()
+{
+#if AP_MISSION_STAGED_UPLOAD_ENABLED
+    mission.cancel_staged_upload();
+#endif
+}
+
 #endif  // HAL_GCS_ENABLED && AP_MISSION_ENABLED
@@ -64,5 +64,10 @@ private:
     // replace_item() replaces an item in the stored list
     MAV_MISSION_RESULT replace_item(const mavlink_mission_item_int_t &) override WARN_IF_UNUSED;
 
+    // full uploads are staged in memory by the mission and only
+    // replace the stored mission once every item has been received
+    MAV_MISSION_RESULT allocate_receive_resources(const uint16_t count) override WARN_IF_UNUSED;
+    void free_upload_resources() override;
+
 };
 